@@ -0,0 +1,706 @@
+#include "city.hh"
+#include "coordinates.h"
+#include "datagenerator.hh"
+#include "flowfield.h"
+#include "policeforce.h"
+#include "core/logic.hh"
+#include "core/location.hh"
+#include "core/locationbuffer.hh"
+#include "core/journeyplanner.hh"
+#include "core/pool.hh"
+#include "core/transitgraph.hh"
+#include "offlinereader.hh"
+#include "actors/passenger.hh"
+#include "actors/stop.hh"
+
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include <memory>
+#include <typeinfo>
+#include <vector>
+
+/**
+  * @file
+  * @brief Benchmarks for the CourseLib hot paths.
+  *
+  * Results can be written in machine-readable form with the QtTest output
+  * options, e.g. `tst_benchmarks -o results.xml,xml` or `-csv`.
+  *
+  * Synthetic-scale mode is controlled with environment variables:
+  * NYSSE_BENCH_SCALE multiplies the synthetic actor and stop counts,
+  * NYSSE_BENCH_BUSES and NYSSE_BENCH_STOPS replace the bundled data files.
+  */
+
+namespace
+{
+
+// Area of the game map in KKJ3 coordinates
+const int MIN_NORTH = 6824973;
+const int MIN_EAST = 3326932;
+const int AREA_SIZE = 1400;
+
+int benchScale()
+{
+    bool ok = false;
+    int scale = qEnvironmentVariableIntValue("NYSSE_BENCH_SCALE", &ok);
+    return ok && scale > 0 ? scale : 1;
+}
+
+QString busFile()
+{
+    QString file = qEnvironmentVariable("NYSSE_BENCH_BUSES");
+    return file.isEmpty() ? CourseSide::DEFAULT_BUSES_FILE : file;
+}
+
+QString stopFile()
+{
+    QString file = qEnvironmentVariable("NYSSE_BENCH_STOPS");
+    return file.isEmpty() ? CourseSide::DEFAULT_STOPS_FILE : file;
+}
+
+Interface::Location randomLocation()
+{
+    return Interface::Location(MIN_NORTH + qrand() % AREA_SIZE,
+                               MIN_EAST + qrand() % AREA_SIZE);
+}
+
+// Minimal vehicle for mixing actor kinds in dispatch benchmarks
+class BenchVehicle : public Interface::IVehicle
+{
+public:
+    Interface::Location giveLocation() const { return Interface::Location(); }
+    void move(Interface::Location) {}
+    bool isRemoved() const { return false; }
+    void remove() {}
+    std::string getName() const { return "Bench"; }
+    std::vector<std::shared_ptr<Interface::IPassenger>> getPassengers() const { return {}; }
+    Interface::PassengerView passengers() const { return Interface::PassengerView(); }
+    void addPassenger(std::shared_ptr<Interface::IPassenger>) {}
+    void removePassenger(std::shared_ptr<Interface::IPassenger>) {}
+};
+
+// Reads data generated with the given configuration
+std::shared_ptr<CourseSide::OfflineData> generateData(const Tools::GeneratorConfig& config)
+{
+    Tools::DataGenerator generator(config);
+    generator.generate();
+
+    QTemporaryDir dir;
+    QString buses = dir.filePath("buses.json");
+    QString stops = dir.filePath("stations.json");
+    if (!Tools::DataGenerator::writeFile(buses, generator.buses(), false) ||
+            !Tools::DataGenerator::writeFile(stops, generator.stops(), false)) {
+        return nullptr;
+    }
+    CourseSide::OfflineReader reader;
+    return reader.readFiles(buses, stops);
+}
+
+// Reads the benchmark data files, or data generated at the given scale if scale > 0
+std::shared_ptr<CourseSide::OfflineData> readData(int syntheticScale)
+{
+    if (syntheticScale <= 0) {
+        CourseSide::OfflineReader reader;
+        return reader.readFiles(busFile(), stopFile());
+    }
+
+    Tools::GeneratorConfig config;
+    config.lines *= syntheticScale;
+    config.stops *= syntheticScale;
+    return generateData(config);
+}
+
+int mapWidth()
+{
+    return Game::Coordinates::BORDER_RIGHT + 1;
+}
+
+int mapHeight()
+{
+    return Game::Coordinates::BORDER_DOWN + 1;
+}
+
+// Walkability of the game map with a river crossed by three bridges
+std::vector<std::uint8_t> riverMask()
+{
+    const int size = Game::FlowField::CELL_SIZE;
+    const int columns = (mapWidth() + size - 1) / size;
+    const int rows = (mapHeight() + size - 1) / size;
+    std::vector<std::uint8_t> mask(std::size_t(columns * rows), 1);
+    for (int row = 0; row < rows; ++row) {
+        if (row % (rows / 3) != rows / 6) {
+            mask[std::size_t(row * columns + columns / 2)] = 0;
+        }
+    }
+    return mask;
+}
+
+std::vector<std::shared_ptr<CourseSide::Stop>> createStops(int count)
+{
+    std::vector<std::shared_ptr<CourseSide::Stop>> stops;
+    stops.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        stops.push_back(std::make_shared<CourseSide::Stop>(
+                            randomLocation(), QString("Stop %1").arg(i), i));
+    }
+    return stops;
+}
+
+}
+
+
+class Benchmarks : public QObject
+{
+    Q_OBJECT
+
+public:
+    Benchmarks();
+    ~Benchmarks();
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void benchmarkReadFiles();
+    void benchmarkAdvance_data();
+    void benchmarkAdvance();
+    void benchmarkNearbyActors_data();
+    void benchmarkNearbyActors();
+    void benchmarkNearestStop_data();
+    void benchmarkNearestStop();
+    void benchmarkCalcDistance();
+    void benchmarkCalcDistances();
+    void benchmarkCloseMask();
+    void benchmarkStopRemovePassenger_data();
+    void benchmarkStopRemovePassenger();
+    void benchmarkActorDispatch_data();
+    void benchmarkActorDispatch();
+    void benchmarkPassengerCast_data();
+    void benchmarkPassengerCast();
+    void benchmarkPassengerChurn_data();
+    void benchmarkPassengerChurn();
+    void benchmarkRouteDecisions();
+    void benchmarkJourneyPlanner_data();
+    void benchmarkJourneyPlanner();
+    void benchmarkSnapshot();
+    void benchmarkPoliceSteer_data();
+    void benchmarkPoliceSteer();
+    void benchmarkFlowFieldSearch();
+
+};
+
+Benchmarks::Benchmarks()
+{
+
+}
+
+Benchmarks::~Benchmarks()
+{
+
+}
+
+void Benchmarks::initTestCase()
+{
+    Q_INIT_RESOURCE(offlinedata);
+    qsrand(1);
+}
+
+void Benchmarks::benchmarkReadFiles()
+{
+    CourseSide::OfflineReader reader;
+    std::shared_ptr<CourseSide::OfflineData> data;
+
+    QBENCHMARK {
+        data = reader.readFiles(busFile(), stopFile());
+    }
+    QVERIFY( data != nullptr );
+    QVERIFY( !data->stops.empty() );
+}
+
+void Benchmarks::benchmarkAdvance_data()
+{
+    QTest::addColumn<QTime>("time");
+    QTest::addColumn<int>("extraPassengers");
+
+    int scale = benchScale();
+    QTest::newRow("early morning") << QTime(5, 30) << 0;
+    QTest::newRow("rush hour") << QTime(7, 20) << 0;
+    QTest::newRow("rush hour, 10k passengers") << QTime(7, 20) << 10000 * scale;
+    QTest::newRow("rush hour, 100k passengers") << QTime(7, 20) << 100000 * scale;
+}
+
+void Benchmarks::benchmarkAdvance()
+{
+    QFETCH(QTime, time);
+    QFETCH(int, extraPassengers);
+
+    std::shared_ptr<CourseSide::OfflineData> data = readData(0);
+    QVERIFY(data != nullptr);
+
+    std::shared_ptr<Game::City> city = std::make_shared<Game::City>();
+    CourseSide::Logic logic;
+    logic.takeCity(city);
+    logic.takeOfflineData(data);
+    logic.setTime(time.hour(), time.minute());
+    logic.finalizeGameStart();
+
+    // Extra passengers wait at the stops the logic simulates, so buses board them
+    for (int i = 0; i < extraPassengers; ++i) {
+        logic.addNewPassengers(data->stops.at(i % data->stops.size()), 1);
+    }
+
+    // increaseTime moves the clock like the timer does, advance alone would repeat one second
+    QBENCHMARK {
+        logic.increaseTime();
+    }
+}
+
+void Benchmarks::benchmarkNearbyActors_data()
+{
+    QTest::addColumn<int>("actors");
+
+    int scale = benchScale();
+    QTest::newRow("1k actors") << 1000 * scale;
+    QTest::newRow("10k actors") << 10000 * scale;
+    QTest::newRow("100k actors") << 100000 * scale;
+}
+
+void Benchmarks::benchmarkNearbyActors()
+{
+    QFETCH(int, actors);
+
+    Game::City city;
+    std::vector<std::shared_ptr<CourseSide::Stop>> stops = createStops(actors / 10 + 1);
+    for (int i = 0; i < actors; ++i) {
+        std::shared_ptr<CourseSide::Passenger> passenger =
+                std::make_shared<CourseSide::Passenger>(stops.front());
+        passenger->enterStop(stops.at(i % stops.size()));
+        city.addActor(passenger);
+    }
+    city.startGame();
+
+    Interface::Location loc = randomLocation();
+    std::vector<std::shared_ptr<Interface::IActor>> nearby;
+    QBENCHMARK {
+        nearby = city.getNearbyActors(loc);
+    }
+}
+
+void Benchmarks::benchmarkNearestStop_data()
+{
+    QTest::addColumn<int>("stops");
+
+    int scale = benchScale();
+    QTest::newRow("2.5k stops") << 2500 * scale;
+    QTest::newRow("25k stops") << 25000 * scale;
+}
+
+void Benchmarks::benchmarkNearestStop()
+{
+    QFETCH(int, stops);
+
+    Game::City city;
+    for (std::shared_ptr<CourseSide::Stop> stop : createStops(stops)) {
+        city.addStop(stop);
+    }
+    city.startGame();
+
+    Interface::Location loc = randomLocation();
+    std::shared_ptr<Interface::IStop> nearest;
+    QBENCHMARK {
+        nearest = city.getNearestStop(loc);
+    }
+    QVERIFY( nearest != nullptr );
+}
+
+void Benchmarks::benchmarkCalcDistance()
+{
+    const int count = 10000 * benchScale();
+    std::vector<Interface::Location> locations;
+    locations.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        locations.push_back(randomLocation());
+    }
+
+    Interface::Location from = randomLocation();
+    double sum = 0.0;
+    QBENCHMARK {
+        for (const Interface::Location& loc : locations) {
+            sum += Interface::Location::calcDistance(from, loc);
+        }
+    }
+    QVERIFY( sum > 0.0 );
+}
+
+void Benchmarks::benchmarkCalcDistances()
+{
+    const int count = 10000 * benchScale();
+    Interface::LocationBuffer locations;
+    locations.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        locations.push_back(randomLocation());
+    }
+
+    Interface::Location from = randomLocation();
+    std::vector<double> distances;
+    QBENCHMARK {
+        Interface::Location::calcDistances(from, locations, distances);
+    }
+    QCOMPARE( distances.size(), locations.size() );
+}
+
+void Benchmarks::benchmarkCloseMask()
+{
+    const int count = 10000 * benchScale();
+    Interface::LocationBuffer locations;
+    locations.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        locations.push_back(randomLocation());
+    }
+
+    Interface::Location from = randomLocation();
+    std::vector<std::uint64_t> mask;
+    QBENCHMARK {
+        Interface::Location::closeMask(from, locations, mask);
+    }
+    QCOMPARE( mask.size(), locations.size() / 64 + (locations.size() % 64 != 0) );
+}
+
+void Benchmarks::benchmarkStopRemovePassenger_data()
+{
+    QTest::addColumn<int>("passengers");
+
+    int scale = benchScale();
+    QTest::newRow("10 passengers") << 10 * scale;
+    QTest::newRow("100 passengers") << 100 * scale;
+    QTest::newRow("1000 passengers") << 1000 * scale;
+}
+
+void Benchmarks::benchmarkStopRemovePassenger()
+{
+    QFETCH(int, passengers);
+
+    std::shared_ptr<CourseSide::Stop> stop = createStops(1).front();
+    std::vector<std::shared_ptr<CourseSide::Passenger>> waiting;
+    waiting.reserve(passengers);
+    for (int i = 0; i < passengers; ++i) {
+        waiting.push_back(std::make_shared<CourseSide::Passenger>(stop));
+    }
+
+    // Each round fills the stop and empties it in boarding order
+    QBENCHMARK {
+        for (std::shared_ptr<CourseSide::Passenger> passenger : waiting) {
+            stop->addPassenger(passenger);
+        }
+        for (std::shared_ptr<CourseSide::Passenger> passenger : waiting) {
+            stop->removePassenger(passenger);
+        }
+    }
+    QVERIFY( stop->getPassengers().empty() );
+}
+
+void Benchmarks::benchmarkActorDispatch_data()
+{
+    QTest::addColumn<bool>("useKind");
+
+    QTest::newRow("typeid") << false;
+    QTest::newRow("kind tag") << true;
+}
+
+void Benchmarks::benchmarkActorDispatch()
+{
+    QFETCH(bool, useKind);
+
+    // One vehicle for every ten passengers, like a busy city
+    const int count = 100000 * benchScale();
+    std::shared_ptr<CourseSide::Stop> stop = createStops(1).front();
+    std::vector<std::shared_ptr<Interface::IActor>> actors;
+    actors.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        if (i % 10 == 0) {
+            actors.push_back(std::make_shared<BenchVehicle>());
+        } else {
+            actors.push_back(std::make_shared<CourseSide::Passenger>(stop));
+        }
+    }
+
+    int vehicles = 0;
+    if (useKind) {
+        QBENCHMARK {
+            for (const std::shared_ptr<Interface::IActor>& actor : actors) {
+                if (actor->getKind() == Interface::ActorKind::VEHICLE) {
+                    ++vehicles;
+                }
+            }
+        }
+    } else {
+        QBENCHMARK {
+            for (const std::shared_ptr<Interface::IActor>& actor : actors) {
+                if (typeid(*actor) == typeid(BenchVehicle)) {
+                    ++vehicles;
+                }
+            }
+        }
+    }
+    QVERIFY( vehicles > 0 );
+}
+
+void Benchmarks::benchmarkPassengerCast_data()
+{
+    QTest::addColumn<bool>("useStatic");
+
+    QTest::newRow("dynamic_pointer_cast") << false;
+    QTest::newRow("static_pointer_cast") << true;
+}
+
+void Benchmarks::benchmarkPassengerCast()
+{
+    QFETCH(bool, useStatic);
+
+    const int count = 100000 * benchScale();
+    std::shared_ptr<CourseSide::Stop> stop = createStops(1).front();
+    std::vector<std::shared_ptr<Interface::IPassenger>> passengers;
+    passengers.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        passengers.push_back(std::make_shared<CourseSide::Passenger>(stop));
+    }
+
+    int removed = 0;
+    if (useStatic) {
+        QBENCHMARK {
+            for (const std::shared_ptr<Interface::IPassenger>& ipassenger : passengers) {
+                if (ipassenger->getKind() == Interface::ActorKind::PASSENGER) {
+                    removed += std::static_pointer_cast<CourseSide::Passenger>(ipassenger)->isRemoved();
+                }
+            }
+        }
+    } else {
+        QBENCHMARK {
+            for (const std::shared_ptr<Interface::IPassenger>& ipassenger : passengers) {
+                std::shared_ptr<CourseSide::Passenger> passenger =
+                        std::dynamic_pointer_cast<CourseSide::Passenger>(ipassenger);
+                if (passenger != nullptr) {
+                    removed += passenger->isRemoved();
+                }
+            }
+        }
+    }
+    QCOMPARE( removed, 0 );
+}
+
+void Benchmarks::benchmarkPassengerChurn_data()
+{
+    QTest::addColumn<bool>("usePool");
+
+    QTest::newRow("make_shared") << false;
+    QTest::newRow("pool") << true;
+}
+
+void Benchmarks::benchmarkPassengerChurn()
+{
+    QFETCH(bool, usePool);
+
+    // Spawns passengers and frees every other one, like a day of boarding and leaving
+    const int count = 10000 * benchScale();
+    std::shared_ptr<CourseSide::Stop> stop = createStops(1).front();
+    std::shared_ptr<CourseSide::Pool> pool = std::make_shared<CourseSide::Pool>();
+    std::vector<std::shared_ptr<CourseSide::Passenger>> passengers;
+    passengers.reserve(count);
+
+    QBENCHMARK {
+        for (int i = 0; i < count; ++i) {
+            if (usePool) {
+                passengers.push_back(std::allocate_shared<CourseSide::Passenger>(
+                                         CourseSide::PoolAllocator<CourseSide::Passenger>(pool), stop));
+            } else {
+                passengers.push_back(std::make_shared<CourseSide::Passenger>(stop));
+            }
+            if (i % 2 == 1) {
+                passengers.pop_back();
+            }
+        }
+        passengers.clear();
+    }
+    if (usePool) {
+        QCOMPARE( pool->statistics().live(), std::size_t(0) );
+    }
+}
+
+void Benchmarks::benchmarkRouteDecisions()
+{
+    CourseSide::OfflineReader reader;
+    std::shared_ptr<CourseSide::OfflineData> data = reader.readFiles(busFile(), stopFile());
+    QVERIFY( data != nullptr && !data->stops.empty() && !data->buses.empty() );
+
+    CourseSide::TransitGraph graph;
+    graph.build(*data);
+
+    // Boarding questions of 100k passengers, searches are cached per destination
+    const int count = 100000 * benchScale();
+    const int stops = static_cast<int>(graph.stopCount());
+    const int patterns = static_cast<int>(graph.patternCount());
+    std::vector<std::int32_t> questions;
+    questions.reserve(3 * count);
+    for (int i = 0; i < count; ++i) {
+        questions.push_back(qrand() % patterns);
+        questions.push_back(qrand() % stops);
+        questions.push_back(qrand() % stops);
+    }
+
+    int boarding = 0;
+    QBENCHMARK {
+        for (std::size_t i = 0; i < questions.size(); i += 3) {
+            if (graph.board(questions[i], questions[i + 1], questions[i + 2]) ==
+                    CourseSide::TransitGraph::Advice::YES) {
+                ++boarding;
+            }
+        }
+    }
+    QVERIFY( boarding >= 0 );
+}
+
+void Benchmarks::benchmarkJourneyPlanner_data()
+{
+    QTest::addColumn<int>("syntheticScale");
+    QTest::addColumn<bool>("useProfile");
+
+    QTest::newRow("Tampere, earliest arrival") << 0 << false;
+    QTest::newRow("Tampere, profile") << 0 << true;
+    QTest::newRow("synthetic 10x, earliest arrival") << 10 << false;
+    QTest::newRow("synthetic 10x, profile") << 10 << true;
+}
+
+void Benchmarks::benchmarkJourneyPlanner()
+{
+    QFETCH(int, syntheticScale);
+    QFETCH(bool, useProfile);
+
+    std::shared_ptr<CourseSide::OfflineData> data = readData(syntheticScale);
+    QVERIFY( data != nullptr && !data->stops.empty() );
+
+    CourseSide::JourneyPlanner planner;
+    planner.build(*data);
+    QVERIFY( !planner.connections().empty() );
+
+    // Random stop pairs departing during the day, profiles over the next two hours
+    const int queries = useProfile ? 10 : 100;
+    const int stops = static_cast<int>(planner.stopCount());
+    std::vector<std::int32_t> questions;
+    for (int i = 0; i < queries; ++i) {
+        questions.push_back(qrand() % stops);
+        questions.push_back(qrand() % stops);
+        questions.push_back((6 + qrand() % 14) * 3600);
+    }
+
+    int answered = 0;
+    auto runQueries = [&]() {
+        for (std::size_t i = 0; i < questions.size(); i += 3) {
+            if (useProfile) {
+                answered += !planner.profile(questions[i], questions[i + 1], questions[i + 2],
+                                             questions[i + 2] + 2 * 3600).empty();
+            } else {
+                answered += planner.earliestArrival(questions[i], questions[i + 1],
+                                                    questions[i + 2]).found();
+            }
+        }
+    };
+
+    QBENCHMARK {
+        runQueries();
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    runQueries();
+    qint64 nsecs = qMax<qint64>(timer.nsecsElapsed(), 1);
+    qInfo("%.0f queries per second over %zu connections",
+          queries * 1e9 / nsecs, planner.connections().size());
+    QVERIFY( answered >= 0 );
+}
+
+void Benchmarks::benchmarkSnapshot()
+{
+    std::shared_ptr<Game::City> city = std::make_shared<Game::City>();
+    CourseSide::Logic logic;
+    logic.takeCity(city);
+    logic.fileConfig(stopFile(), busFile());
+    logic.setTime(7, 20);
+    logic.finalizeGameStart();
+    for (int i = 0; i < 50; ++i) {
+        logic.increaseTime();
+    }
+
+    QByteArray snapshot;
+    QBENCHMARK {
+        snapshot.clear();
+        QDataStream out(&snapshot, QIODevice::WriteOnly);
+        QVERIFY( logic.saveSnapshot(out) );
+    }
+
+    // Restoring needs a fresh city and data, only the restore itself is timed
+    std::shared_ptr<Game::City> restoredCity = std::make_shared<Game::City>();
+    CourseSide::Logic restored;
+    restored.takeCity(restoredCity);
+    restored.fileConfig(stopFile(), busFile());
+
+    QElapsedTimer timer;
+    timer.start();
+    QDataStream in(snapshot);
+    QVERIFY( restored.restoreSnapshot(in) );
+    qInfo("restored %d bytes in %lld us", snapshot.size(), timer.nsecsElapsed() / 1000);
+
+    QByteArray again;
+    QDataStream out(&again, QIODevice::WriteOnly);
+    QVERIFY( restored.saveSnapshot(out) );
+    QCOMPARE( again, snapshot );
+}
+
+void Benchmarks::benchmarkPoliceSteer_data()
+{
+    QTest::addColumn<int>("units");
+
+    int scale = benchScale();
+    QTest::newRow("1 unit") << 1;
+    QTest::newRow("128 units") << 128 * scale;
+    QTest::newRow("1k units") << 1024 * scale;
+}
+
+void Benchmarks::benchmarkPoliceSteer()
+{
+    QFETCH(int, units);
+
+    Game::FlowField field;
+    field.setWalkable(mapWidth(), mapHeight(), riverMask());
+    Game::PoliceForce police;
+    police.addUnits(units);
+    police.setFlowField(&field);
+
+    // Player keeps moving around the middle of the map, so units keep steering
+    int tick = 0;
+    QBENCHMARK {
+        int x = 500 + (tick % 200) - 100;
+        int y = 285 + ((tick / 200) % 2 == 0 ? 100 : -100);
+        field.setTarget(x, y);
+        police.steer(x, y);
+        ++tick;
+    }
+    QCOMPARE( police.size(), std::size_t(units) );
+}
+
+void Benchmarks::benchmarkFlowFieldSearch()
+{
+    Game::FlowField field;
+    field.setWalkable(mapWidth(), mapHeight(), riverMask());
+
+    // Every target is in another cell, so every call searches
+    int tick = 0;
+    QBENCHMARK {
+        QVERIFY( field.setTarget(8 * (tick % 2) + 500, 300) );
+        ++tick;
+    }
+}
+
+QTEST_GUILESS_MAIN(Benchmarks)
+
+#include "tst_benchmarks.moc"
@@ -6,15 +6,29 @@
 
 TEMPLATE = lib
 CONFIG    += c++14 staticlib
-QT        += widgets gui network core multimedia
+QT        += widgets gui network core multimedia concurrent
+
+# Build with CONFIG+=avx to use the 8-wide batch kernels of Location,
+# SSE2 kernels are used by default on x86-64
+avx: QMAKE_CXXFLAGS += -mavx
+
+include(statistics.pri)
 
 
 SOURCES += \
     actors/nysse.cc \
     actors/passenger.cc \
     actors/stop.cc \
+    core/arrivaltable.cc \
+    core/boardingschedule.cc \
+    core/journeyplanner.cc \
     core/location.cc \
     core/logic.cc \
+    core/passengertable.cc \
+    core/pool.cc \
+    core/statisticspolicy.cc \
+    core/trace.cc \
+    core/transitgraph.cc \
     errors/gameerror.cc \
     errors/initerror.cc \
     graphics/simpleactoritem.cpp \
@@ -25,8 +39,18 @@ HEADERS += \
     actors/nysse.hh \
     actors/passenger.hh \
     actors/stop.hh \
+    core/arrivaltable.hh \
+    core/boardingschedule.hh \
+    core/journeyplanner.hh \
     core/location.hh \
+    core/locationbuffer.hh \
     core/logic.hh \
+    core/passengertable.hh \
+    core/pool.hh \
+    core/projection.hh \
+    core/statisticspolicy.hh \
+    core/trace.hh \
+    core/transitgraph.hh \
     creategame.hh \
     doxygeninfo.hh \
     errors/gameerror.hh \
@@ -38,6 +62,7 @@ HEADERS += \
     interfaces/ipassenger.hh \
     interfaces/istatistics.hh \
     interfaces/istop.hh \
+    interfaces/passengerview.hh \
     interfaces/ivehicle.hh \
     offlinereader.hh
 
@@ -1,5 +1,6 @@
 #include "actors/passenger.hh"
 #include "actors/nysse.hh"
+#include "core/passengertable.hh"
 #include "errors/gameerror.hh"
 
 
@@ -8,7 +9,9 @@ namespace CourseSide
 
 Passenger::Passenger(std::weak_ptr< Interface::IStop > destination) :
     removed_(false),
-    destination_(destination)
+    destination_(destination),
+    table_(nullptr),
+    row_(0)
 {
 }
 
@@ -34,6 +37,9 @@ void Passenger::move(Interface::Location loc)
 void Passenger::remove()
 {
     removed_ = true;
+    if (table_ != nullptr) {
+        table_->setRemoved(row_);
+    }
 }
 
 bool Passenger::isRemoved() const
@@ -84,6 +90,9 @@ void Passenger::enterVehicle(std::weak_ptr<Interface::IVehicle> vehicle)
 {
     nyssep_ = vehicle;
     stopp_.reset();
+    if (table_ != nullptr) {
+        table_->setVehicle(row_, vehicle.lock().get());
+    }
 }
 
 void Passenger::enterNysse(std::weak_ptr< Nysse > bus)
@@ -91,6 +100,9 @@ void Passenger::enterNysse(std::weak_ptr< Nysse > bus)
     // Set nyssep_ to point to given Nysse and forget stopp_
     nyssep_ = bus;
     stopp_.reset();
+    if (table_ != nullptr) {
+        table_->setVehicle(row_, bus.lock().get());
+    }
 }
 
 bool Passenger::wantToEnterStop(std::weak_ptr<Interface::IStop> /*stop*/) const
@@ -108,6 +120,9 @@ void Passenger::enterStop(std::weak_ptr< Interface::IStop > stop)
     // Go to stop from bus
     nyssep_.reset();
     stopp_ = stop;
+    if (table_ != nullptr) {
+        table_->setStop(row_, stop.lock().get());
+    }
 }
 
 }
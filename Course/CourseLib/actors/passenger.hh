@@ -12,6 +12,7 @@ namespace CourseSide
 {
 
 class Nysse;
+class PassengerTable;
 
 class Passenger : public Interface::IPassenger
 {
@@ -49,12 +50,17 @@ protected:
 
 
 private:
+    friend class PassengerTable;
 
     // Current bus
     std::weak_ptr< Interface::IVehicle > nyssep_;
     // Current stop
     std::weak_ptr< Interface::IStop > stopp_;
 
+    // Table the state is written through to, and the row of this passenger in it
+    PassengerTable* table_;
+    std::size_t row_;
+
 
     };
 
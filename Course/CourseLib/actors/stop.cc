@@ -34,7 +34,12 @@ unsigned int Stop::getId() const
 
 std::vector<std::shared_ptr<Interface::IPassenger> > Stop::getPassengers() const
 {
-    return passengers_;
+    return passengers().toVector();
+}
+
+Interface::PassengerView Stop::passengers() const
+{
+    return Interface::PassengerView(passengers_);
 }
 
 void Stop::setLocation(const Interface::Location &location)
@@ -54,18 +59,30 @@ void Stop::setId(unsigned int id)
 
 void Stop::addPassenger(const std::weak_ptr<Interface::IPassenger> passenger)
 {
-    passengers_.push_back(passenger.lock());
-
+    std::shared_ptr<Interface::IPassenger> added = passenger.lock();
+    if (added == nullptr || !index_.insert({added.get(), passengers_.size()}).second) {
+        // expired or already in the stop
+        return;
+    }
+    passengers_.push_back(std::move(added));
 }
 
 void Stop::removePassenger(const std::weak_ptr<Interface::IPassenger> passenger)
 {
-    for (auto it = passengers_.begin(); it!= passengers_.end(); ++it){
-        if (*it == passenger.lock()){
-            passengers_.erase(it);
-            break;
-        }
+    std::shared_ptr<Interface::IPassenger> removed = passenger.lock();
+    auto found = index_.find(removed.get());
+    if (found == index_.end()) {
+        return;
+    }
+
+    // Move the last passenger to the place of the removed one
+    std::size_t position = found->second;
+    index_.erase(found);
+    if (position + 1 != passengers_.size()) {
+        passengers_[position] = std::move(passengers_.back());
+        index_[passengers_[position].get()] = position;
     }
+    passengers_.pop_back();
 }
 
 }
@@ -5,9 +5,11 @@
 #include "interfaces/ipassenger.hh"
 #include "actors/passenger.hh"
 #include "interfaces/istop.hh"
+#include "interfaces/passengerview.hh"
 
 #include <QString>
 #include <set>
+#include <unordered_map>
 
 
 namespace CourseSide
@@ -25,6 +27,9 @@ public:
     unsigned int getId() const;
     std::vector<std::shared_ptr<Interface::IPassenger>> getPassengers() const;
 
+    // Order of passengers is not preserved by removePassenger
+    Interface::PassengerView passengers() const;
+
     void setLocation(const Interface::Location &location);
     void setName(const QString &name);
     void setId(unsigned int id);
@@ -35,7 +40,10 @@ private:
     Interface::Location location_;
     QString name_;
     unsigned int id_;
+    // Passengers are removed by swapping the last one into their place,
+    // index_ tells the position of each passenger in passengers_
     std::vector<std::shared_ptr<Interface::IPassenger>> passengers_;
+    std::unordered_map<const Interface::IPassenger*, std::size_t> index_;
 };
 
 }
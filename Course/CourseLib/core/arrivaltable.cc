@@ -0,0 +1,93 @@
+#include "core/arrivaltable.hh"
+
+#include <algorithm>
+#include <utility>
+
+namespace CourseSide
+{
+
+bool ArrivalTable::update(const std::shared_ptr<Nysse>& bus, const std::shared_ptr<Stop>& stop)
+{
+    auto current = busStops_.find(bus.get());
+    if (current != busStops_.end()) {
+        if (current->second == stop.get()) {
+            // Still dwelling at the same stop
+            return false;
+        }
+        leave(bus.get(), current->second);
+        busStops_.erase(current);
+    }
+    if (stop == nullptr) {
+        return false;
+    }
+
+    auto found = stopIndex_.find(stop.get());
+    if (found == stopIndex_.end()) {
+        found = stopIndex_.insert({stop.get(), dwells_.size()}).first;
+        dwells_.push_back(Dwell{stop, {}});
+    }
+    dwells_[found->second].buses.push_back(bus);
+    busStops_.insert({bus.get(), stop.get()});
+    return true;
+}
+
+void ArrivalTable::remove(const Nysse* bus)
+{
+    auto current = busStops_.find(bus);
+    if (current != busStops_.end()) {
+        leave(bus, current->second);
+        busStops_.erase(current);
+    }
+}
+
+const ArrivalTable::Dwell* ArrivalTable::dwellAt(const Stop* stop) const
+{
+    auto found = stopIndex_.find(stop);
+    if (found == stopIndex_.end()) {
+        return nullptr;
+    }
+    return &dwells_[found->second];
+}
+
+const Stop* ArrivalTable::stopOf(const Nysse* bus) const
+{
+    auto found = busStops_.find(bus);
+    if (found == busStops_.end()) {
+        return nullptr;
+    }
+    return found->second;
+}
+
+void ArrivalTable::clear()
+{
+    dwells_.clear();
+    stopIndex_.clear();
+    busStops_.clear();
+}
+
+void ArrivalTable::leave(const Nysse* bus, const Stop* stop)
+{
+    auto found = stopIndex_.find(stop);
+    if (found == stopIndex_.end()) {
+        return;
+    }
+    std::size_t position = found->second;
+    std::vector<std::shared_ptr<Nysse>>& buses = dwells_[position].buses;
+    buses.erase(std::find_if(buses.begin(), buses.end(),
+                             [bus](const std::shared_ptr<Nysse>& dwelling) {
+                                 return dwelling.get() == bus;
+                             }));
+    if (!buses.empty()) {
+        return;
+    }
+
+    // The last dwell takes the place of the empty one, only its index changes
+    stopIndex_.erase(found);
+    if (position + 1 != dwells_.size()) {
+        dwells_[position] = std::move(dwells_.back());
+        stopIndex_[dwells_[position].stop.get()] = position;
+    }
+    dwells_.pop_back();
+}
+
+}
@@ -0,0 +1,92 @@
+#ifndef ARRIVALTABLE_HH
+#define ARRIVALTABLE_HH
+
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @file
+ * @brief Defines an index from stops to the buses dwelling at them.
+ */
+
+
+namespace CourseSide
+{
+
+class Nysse;
+class Stop;
+
+/**
+ * @brief ArrivalTable tells which buses are dwelling at which stops.
+ *
+ * Logic updates the table as buses move, arrive and leave, which tells when a bus arrives and
+ * which buses a passenger entering a stop can still catch. The buses of a stop are kept in the
+ * order they arrived, so the order they are offered in does not depend on addresses.
+ */
+class ArrivalTable
+{
+public:
+    /**
+     * @brief Dwell is an occupied stop and the buses at it.
+     */
+    struct Dwell
+    {
+        std::shared_ptr<Stop> stop;
+        std::vector<std::shared_ptr<Nysse>> buses;
+    };
+
+    /**
+     * @brief update records where the bus is now.
+     * @param bus bus that has moved
+     * @param stop stop the bus is at, nullptr if the bus is between stops
+     * @return true if the bus arrived at stop, i.e. was not already dwelling there
+     * @post Bus is listed only at stop. Exception guarantee: basic.
+     */
+    bool update(const std::shared_ptr<Nysse>& bus, const std::shared_ptr<Stop>& stop);
+
+    /**
+     * @brief remove forgets the bus.
+     * @param bus bus that has left the traffic
+     * @post Bus is not listed at any stop. Exception guarantee: nothrow.
+     */
+    void remove(const Nysse* bus);
+
+    /**
+     * @brief dwellAt returns the buses dwelling at the stop.
+     * @param stop stop to look up
+     * @return Dwell of the stop, nullptr if no bus is at the stop
+     * @post Exception guarantee: nothrow.
+     */
+    const Dwell* dwellAt(const Stop* stop) const;
+
+    /**
+     * @brief stopOf tells where the bus is dwelling.
+     * @param bus bus to look up
+     * @return stop of the bus, nullptr if the bus is between stops or not known
+     * @post Exception guarantee: nothrow.
+     */
+    const Stop* stopOf(const Nysse* bus) const;
+
+    /**
+     * @brief clear forgets all buses.
+     * @post Exception guarantee: nothrow.
+     */
+    void clear();
+
+private:
+    // Removes bus from the dwell of stop, and the dwell if it becomes empty
+    void leave(const Nysse* bus, const Stop* stop);
+
+    // Occupied stops, in no particular order
+    std::vector<Dwell> dwells_;
+    // Position of each occupied stop in dwells_
+    std::unordered_map<const Stop*, std::size_t> stopIndex_;
+    // Stop of each bus that is at a stop
+    std::unordered_map<const Nysse*, const Stop*> busStops_;
+};
+
+}
+
+#endif // ARRIVALTABLE_HH
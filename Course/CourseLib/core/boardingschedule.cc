@@ -0,0 +1,51 @@
+#include "core/boardingschedule.hh"
+
+namespace CourseSide
+{
+
+BoardingSchedule::BoardingSchedule() : sequence_(0)
+{
+}
+
+void BoardingSchedule::schedule(Kind kind, std::int64_t time,
+                                const std::shared_ptr<Passenger>& passenger,
+                                const std::shared_ptr<Nysse>& bus,
+                                const std::shared_ptr<Stop>& stop)
+{
+    events_.push(Event{time, sequence_, kind, passenger, bus, stop});
+    ++sequence_;
+}
+
+bool BoardingSchedule::takeDue(std::int64_t now, Event& event)
+{
+    if (events_.empty() || events_.top().time > now) {
+        return false;
+    }
+    event = events_.top();
+    events_.pop();
+    return true;
+}
+
+std::size_t BoardingSchedule::size() const
+{
+    return events_.size();
+}
+
+std::vector<BoardingSchedule::Event> BoardingSchedule::pending() const
+{
+    std::priority_queue<Event, std::vector<Event>, Later> events = events_;
+    std::vector<Event> pending;
+    pending.reserve(events.size());
+    while (!events.empty()) {
+        pending.push_back(events.top());
+        events.pop();
+    }
+    return pending;
+}
+
+void BoardingSchedule::clear()
+{
+    events_ = decltype(events_)();
+}
+
+}
@@ -0,0 +1,103 @@
+#ifndef BOARDINGSCHEDULE_HH
+#define BOARDINGSCHEDULE_HH
+
+#include <cstdint>
+#include <memory>
+#include <queue>
+#include <vector>
+
+/**
+ * @file
+ * @brief Defines a time-ordered queue of scheduled boardings and alightings.
+ */
+
+
+namespace CourseSide
+{
+
+class Nysse;
+class Passenger;
+class Stop;
+
+/**
+ * @brief BoardingSchedule holds the boardings and alightings decided when buses arrive at stops.
+ *
+ * Events are ordered by their game time and, at equal times, by the order they were scheduled.
+ * An event only tells what was decided; Logic checks that it is still possible when the event
+ * is due, e.g. that the bus has not left the stop.
+ */
+class BoardingSchedule
+{
+public:
+    enum class Kind : std::uint8_t
+    {
+        BOARD,
+        ALIGHT
+    };
+
+    struct Event
+    {
+        // Game time in milliseconds, see Logic
+        std::int64_t time;
+        std::uint64_t sequence;
+        Kind kind;
+        std::weak_ptr<Passenger> passenger;
+        std::weak_ptr<Nysse> bus;
+        std::weak_ptr<Stop> stop;
+    };
+
+    BoardingSchedule();
+
+    /**
+     * @brief schedule adds an event.
+     * @param kind boarding or alighting
+     * @param time game time in milliseconds when the event is due
+     * @param passenger passenger that boards or alights
+     * @param bus bus the passenger boards or alights from
+     * @param stop stop where it happens
+     * @post Exception guarantee: strong.
+     */
+    void schedule(Kind kind, std::int64_t time, const std::shared_ptr<Passenger>& passenger,
+                  const std::shared_ptr<Nysse>& bus, const std::shared_ptr<Stop>& stop);
+
+    /**
+     * @brief takeDue removes the earliest event if it is due.
+     * @param now current game time in milliseconds
+     * @param event output, the removed event
+     * @return true if an event was due and removed
+     * @post Exception guarantee: basic.
+     */
+    bool takeDue(std::int64_t now, Event& event);
+
+    std::size_t size() const;
+
+    /**
+     * @brief pending tells the events that are not yet due, e.g. for a snapshot.
+     * @return events in the order they become due; scheduling them in this order to an
+     * empty schedule gives the same order
+     * @post Exception guarantee: strong.
+     */
+    std::vector<Event> pending() const;
+
+    /**
+     * @brief clear removes all events.
+     * @post Exception guarantee: nothrow.
+     */
+    void clear();
+
+private:
+    struct Later
+    {
+        bool operator()(const Event& a, const Event& b) const
+        {
+            return a.time != b.time ? a.time > b.time : a.sequence > b.sequence;
+        }
+    };
+
+    std::priority_queue<Event, std::vector<Event>, Later> events_;
+    std::uint64_t sequence_;
+};
+
+}
+
+#endif // BOARDINGSCHEDULE_HH
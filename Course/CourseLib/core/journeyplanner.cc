@@ -0,0 +1,278 @@
+#include "core/journeyplanner.hh"
+#include "offlinereader.hh"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace CourseSide
+{
+
+const std::int32_t JourneyPlanner::NEVER;
+const std::int32_t JourneyPlanner::NONE;
+
+namespace
+{
+
+std::int32_t toSeconds(const QTime& time)
+{
+    return time.msecsSinceStartOfDay() / 1000;
+}
+
+}
+
+JourneyPlanner::JourneyPlanner() : stopCount_(0)
+{
+}
+
+void JourneyPlanner::build(const OfflineData& data)
+{
+    connections_.clear();
+    trips_.clear();
+    patterns_.clear();
+    firstTripOf_.clear();
+    stopIndex_.clear();
+    tripCache_.clear();
+
+    stopCount_ = data.stops.size();
+    stopIndex_.reserve(stopCount_);
+    for (std::size_t i = 0; i < stopCount_; ++i) {
+        stopIndex_.insert({data.stops[i].get(), static_cast<std::int32_t>(i)});
+    }
+
+    // Stops of a line with their times from the start of the line
+    std::vector<std::pair<std::int32_t, std::int32_t>> pattern;
+    for (const std::shared_ptr<BusData>& bus : data.buses) {
+        pattern.clear();
+        for (const auto& point : bus->timeRoute2) {
+            std::int32_t stop = stopIndex(point.second.second.get());
+            if (stop != NONE && (pattern.empty() || pattern.back().first != stop)) {
+                pattern.push_back({stop, toSeconds(point.first)});
+            }
+        }
+        if (pattern.size() < 2) {
+            continue;
+        }
+
+        std::int32_t patternIndex = static_cast<std::int32_t>(patterns_.size());
+        patterns_.push_back(pattern);
+        firstTripOf_.insert({bus.get(), static_cast<std::int32_t>(trips_.size())});
+        for (const QTime& start : bus->schedule) {
+            std::int32_t trip = static_cast<std::int32_t>(trips_.size());
+            std::int32_t startTime = toSeconds(start);
+            trips_.push_back(Trip{bus.get(), startTime, patternIndex});
+            for (std::size_t i = 0; i + 1 < pattern.size(); ++i) {
+                connections_.push_back(Connection{startTime + pattern[i].second,
+                                                  startTime + pattern[i + 1].second,
+                                                  pattern[i].first, pattern[i + 1].first,
+                                                  trip});
+            }
+        }
+    }
+
+    // Stable, so that connections of a run leaving at the same second stay in order
+    std::stable_sort(connections_.begin(), connections_.end(),
+                     [](const Connection& a, const Connection& b) {
+                         return a.departure < b.departure;
+                     });
+}
+
+std::int32_t JourneyPlanner::stopIndex(const Stop* stop) const
+{
+    auto found = stopIndex_.find(stop);
+    return found == stopIndex_.end() ? NONE : found->second;
+}
+
+JourneyPlanner::Journey JourneyPlanner::earliestArrival(std::int32_t from, std::int32_t to,
+                                                        std::int32_t departure) const
+{
+    Journey journey;
+    if (from == to) {
+        journey.arrival = departure;
+        return journey;
+    }
+
+    std::vector<std::int32_t> arrival(stopCount_, NEVER);
+    // Connection where each reached trip was boarded, -1 if not reached
+    std::vector<std::int32_t> boarded(trips_.size(), -1);
+    // Boarding and alighting connections of the last leg to each stop
+    std::vector<std::pair<std::int32_t, std::int32_t>> lastLeg(stopCount_, {-1, -1});
+    arrival[from] = departure;
+
+    auto first = std::lower_bound(connections_.begin(), connections_.end(), departure,
+                                  [](const Connection& c, std::int32_t time) {
+                                      return c.departure < time;
+                                  });
+    for (auto c = first; c != connections_.end(); ++c) {
+        if (arrival[to] <= c->departure) {
+            // No later connection can improve the arrival
+            break;
+        }
+        std::int32_t index = static_cast<std::int32_t>(c - connections_.begin());
+        if (boarded[c->trip] == -1 && arrival[c->from] <= c->departure) {
+            boarded[c->trip] = index;
+        }
+        if (boarded[c->trip] != -1 && c->arrival < arrival[c->to]) {
+            arrival[c->to] = c->arrival;
+            lastLeg[c->to] = {boarded[c->trip], index};
+        }
+    }
+
+    if (arrival[to] == NEVER) {
+        return journey;
+    }
+    journey.arrival = arrival[to];
+
+    // Follow the legs backwards from the destination
+    for (std::int32_t stop = to; stop != from; ) {
+        const Connection& enter = connections_[lastLeg[stop].first];
+        const Connection& exit = connections_[lastLeg[stop].second];
+        journey.legs.push_back(Leg{enter.trip, enter.from, exit.to, enter.departure, exit.arrival});
+        stop = enter.from;
+    }
+    std::reverse(journey.legs.begin(), journey.legs.end());
+    return journey;
+}
+
+std::vector<JourneyPlanner::ProfileEntry> JourneyPlanner::profile(std::int32_t from, std::int32_t to,
+                                                                  std::int32_t earliest,
+                                                                  std::int32_t latest) const
+{
+    // Pareto sets of each stop, added in decreasing departure order, so along each
+    // vector both departures and arrivals decrease
+    std::vector<std::vector<ProfileEntry>> profiles(stopCount_);
+    // Earliest arrival when staying in each trip
+    std::vector<std::int32_t> tripArrival(trips_.size(), NEVER);
+
+    auto first = std::lower_bound(connections_.begin(), connections_.end(), earliest,
+                                  [](const Connection& c, std::int32_t time) {
+                                      return c.departure < time;
+                                  });
+
+    // Departing earlier never arrives later, so no entry in the window arrives after the
+    // earliest arrival of a departure at latest. Connections leaving after that arrival
+    // cannot be on any of the journeys and are not scanned.
+    auto last = connections_.end();
+    if (from != to) {
+        std::int32_t bound = earliestArrival(from, to, latest).arrival;
+        if (bound != NEVER) {
+            last = std::upper_bound(first, connections_.end(), bound,
+                                    [](std::int32_t time, const Connection& c) {
+                                        return time < c.departure;
+                                    });
+        }
+    }
+
+    for (auto c = last; c != first; ) {
+        --c;
+
+        std::int32_t best = c->to == to ? c->arrival : NEVER;
+        best = std::min(best, tripArrival[c->trip]);
+
+        // Transfer at c->to: the last entry that departs at or after c->arrival has the
+        // earliest arrival of those, searched from the end where departures are earliest
+        const std::vector<ProfileEntry>& next = profiles[c->to];
+        auto transfer = std::upper_bound(next.rbegin(), next.rend(), c->arrival,
+                                         [](std::int32_t time, const ProfileEntry& entry) {
+                                             return time <= entry.departure;
+                                         });
+        if (transfer != next.rend()) {
+            best = std::min(best, transfer->arrival);
+        }
+
+        if (best == NEVER) {
+            continue;
+        }
+        tripArrival[c->trip] = best;
+
+        std::vector<ProfileEntry>& own = profiles[c->from];
+        if (own.empty() || best < own.back().arrival) {
+            if (!own.empty() && own.back().departure == c->departure) {
+                own.back().arrival = best;
+            } else {
+                own.push_back(ProfileEntry{c->departure, best});
+            }
+        }
+    }
+
+    std::vector<ProfileEntry> result;
+    for (auto entry = profiles[from].rbegin(); entry != profiles[from].rend(); ++entry) {
+        if (entry->departure <= latest) {
+            result.push_back(*entry);
+        }
+    }
+    return result;
+}
+
+std::int32_t JourneyPlanner::tripOf(const BusData* bus, std::int32_t start) const
+{
+    auto found = firstTripOf_.find(bus);
+    if (found == firstTripOf_.end()) {
+        return NONE;
+    }
+    for (std::size_t trip = found->second; trip < trips_.size() && trips_[trip].bus == bus; ++trip) {
+        if (trips_[trip].start == start) {
+            return static_cast<std::int32_t>(trip);
+        }
+    }
+    return NONE;
+}
+
+std::int32_t JourneyPlanner::departureAt(std::int32_t trip, std::int32_t stop,
+                                         std::int32_t time) const
+{
+    if (trip == NONE) {
+        return NEVER;
+    }
+    const std::vector<std::pair<std::int32_t, std::int32_t>>& pattern =
+            patterns_[trips_[trip].pattern];
+    std::int32_t departure = NEVER;
+    // The last stop of a run has no departure
+    for (std::size_t i = 0; i + 1 < pattern.size(); ++i) {
+        std::int32_t visit = trips_[trip].start + pattern[i].second;
+        if (pattern[i].first == stop &&
+                (departure == NEVER || std::abs(visit - time) < std::abs(departure - time))) {
+            departure = visit;
+        }
+    }
+    return departure;
+}
+
+std::int32_t JourneyPlanner::firstTrip(std::int32_t from, std::int32_t to,
+                                       std::int32_t departure) const
+{
+    std::uint64_t key = static_cast<std::uint64_t>(static_cast<std::uint32_t>(from)) << 32 |
+            static_cast<std::uint32_t>(to);
+    auto cached = tripCache_.find(key);
+    if (cached != tripCache_.end() && cached->second.asked <= departure &&
+            departure <= cached->second.until) {
+        return cached->second.trip;
+    }
+
+    // The journey is also the fastest for any departure up to its first leg, and nothing
+    // departing later reaches a destination that cannot be reached now
+    Journey journey = earliestArrival(from, to, departure);
+    CachedTrip answer{departure, NEVER, NONE};
+    if (!journey.legs.empty()) {
+        answer.until = journey.legs.front().departure;
+        answer.trip = journey.legs.front().trip;
+    }
+    tripCache_[key] = answer;
+    return answer.trip;
+}
+
+const std::vector<JourneyPlanner::Connection>& JourneyPlanner::connections() const
+{
+    return connections_;
+}
+
+const std::vector<JourneyPlanner::Trip>& JourneyPlanner::trips() const
+{
+    return trips_;
+}
+
+std::size_t JourneyPlanner::stopCount() const
+{
+    return stopCount_;
+}
+
+}
@@ -0,0 +1,211 @@
+#ifndef JOURNEYPLANNER_HH
+#define JOURNEYPLANNER_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @file
+ * @brief Defines a journey planner over the timetables of OfflineData.
+ */
+
+
+namespace CourseSide
+{
+
+struct BusData;
+struct OfflineData;
+class Stop;
+
+/**
+ * @brief JourneyPlanner answers timetable queries with the Connection Scan Algorithm.
+ *
+ * The timetable is compiled into connections: one for every run of a line between two
+ * consecutive stops, sorted by departure time. Stops are identified by their index in
+ * OfflineData::stops. Times are seconds since the start of the day; runs that continue
+ * past midnight get times over 24 hours. Transfers happen at the same stop and take no time.
+ */
+class JourneyPlanner
+{
+public:
+    // Arrival time of an unreachable stop
+    static const std::int32_t NEVER = INT32_MAX;
+    // Index of an unknown stop
+    static const std::int32_t NONE = -1;
+
+    /**
+     * @brief Connection is a bus driving from a stop to the next one.
+     */
+    struct Connection
+    {
+        std::int32_t departure;
+        std::int32_t arrival;
+        std::int32_t from;
+        std::int32_t to;
+        // Index of the run in trips()
+        std::int32_t trip;
+    };
+
+    /**
+     * @brief Trip is one run of a line.
+     */
+    struct Trip
+    {
+        const BusData* bus;
+        // Departure from the first stop
+        std::int32_t start;
+        // Index of the stop sequence of the line
+        std::int32_t pattern;
+    };
+
+    /**
+     * @brief Leg is a part of a journey spent in one bus.
+     */
+    struct Leg
+    {
+        std::int32_t trip;
+        std::int32_t from;
+        std::int32_t to;
+        std::int32_t departure;
+        std::int32_t arrival;
+    };
+
+    /**
+     * @brief Journey is the answer to an earliest-arrival query.
+     */
+    struct Journey
+    {
+        // NEVER if the destination cannot be reached
+        std::int32_t arrival = NEVER;
+        std::vector<Leg> legs;
+
+        bool found() const
+        {
+            return arrival != NEVER;
+        }
+    };
+
+    /**
+     * @brief ProfileEntry tells the earliest arrival when departing at a given time.
+     */
+    struct ProfileEntry
+    {
+        std::int32_t departure;
+        std::int32_t arrival;
+    };
+
+    JourneyPlanner();
+
+    /**
+     * @brief build compiles the timetable of the given data into connections.
+     * @param data offline data with stops and buses
+     * @post Previous timetable is replaced. Exception guarantee: basic.
+     */
+    void build(const OfflineData& data);
+
+    /**
+     * @brief stopIndex tells the index of the given stop.
+     * @param stop stop to look up
+     * @return index of the stop, NONE if it is not known
+     * @post Exception guarantee: nothrow.
+     */
+    std::int32_t stopIndex(const Stop* stop) const;
+
+    /**
+     * @brief earliestArrival finds the fastest journey departing at or after the given time.
+     * @param from index of the origin stop
+     * @param to index of the destination stop
+     * @param departure earliest departure time in seconds
+     * @pre Both stops are known.
+     * @return Journey with the earliest arrival, not found if there is none.
+     * @post Exception guarantee: basic.
+     */
+    Journey earliestArrival(std::int32_t from, std::int32_t to, std::int32_t departure) const;
+
+    /**
+     * @brief profile finds the earliest arrivals for all departures in a time window.
+     *
+     * Entries are Pareto-optimal: no other departure leaves later and arrives earlier.
+     * Only connections departing before the earliest arrival of a departure at latest are
+     * scanned, so a short window costs about as much as the journeys it contains.
+     *
+     * @param from index of the origin stop
+     * @param to index of the destination stop
+     * @param earliest start of the departure window in seconds
+     * @param latest end of the departure window in seconds
+     * @pre Both stops are known.
+     * @return Entries ordered by departure time.
+     * @post Exception guarantee: basic.
+     */
+    std::vector<ProfileEntry> profile(std::int32_t from, std::int32_t to,
+                                      std::int32_t earliest, std::int32_t latest) const;
+
+    /**
+     * @brief tripOf tells the run of a line that departs at the given time.
+     * @param bus bus line to look up
+     * @param start departure from the first stop in seconds
+     * @return index of the trip, NONE if the line has no such run
+     * @post Exception guarantee: nothrow.
+     */
+    std::int32_t tripOf(const BusData* bus, std::int32_t start) const;
+
+    /**
+     * @brief departureAt tells when a run leaves the given stop.
+     * @param trip index of the trip, may be NONE
+     * @param stop index of the stop
+     * @param time time in seconds the run is at the stop, picks the visit of a line that
+     * passes the stop more than once
+     * @return departure time closest to time, NEVER if the run does not leave the stop
+     * @post Exception guarantee: nothrow.
+     */
+    std::int32_t departureAt(std::int32_t trip, std::int32_t stop, std::int32_t time) const;
+
+    /**
+     * @brief firstTrip tells the run boarded first on the fastest journey departing at or
+     * after the given time.
+     *
+     * An answer stays valid for departures up to the first leg of its journey, so it is
+     * cached per pair of stops and searched again only when asked for a later departure.
+     *
+     * @param from index of the origin stop
+     * @param to index of the destination stop
+     * @param departure earliest departure time in seconds
+     * @pre Both stops are known and differ.
+     * @return index of the trip, NONE if the destination cannot be reached
+     * @post Search may be cached. Exception guarantee: basic.
+     */
+    std::int32_t firstTrip(std::int32_t from, std::int32_t to, std::int32_t departure) const;
+
+    const std::vector<Connection>& connections() const;
+    const std::vector<Trip>& trips() const;
+    std::size_t stopCount() const;
+
+private:
+    // Answer of firstTrip for departures from asked to until
+    struct CachedTrip
+    {
+        std::int32_t asked;
+        std::int32_t until;
+        std::int32_t trip;
+    };
+
+    // Connections sorted by departure time
+    std::vector<Connection> connections_;
+    std::vector<Trip> trips_;
+    // Stops of each line with their times from the start of the line
+    std::vector<std::vector<std::pair<std::int32_t, std::int32_t>>> patterns_;
+    // First trip of each line, the trips of a line are consecutive
+    std::unordered_map<const BusData*, std::int32_t> firstTripOf_;
+    std::unordered_map<const Stop*, std::int32_t> stopIndex_;
+    std::size_t stopCount_;
+
+    // Latest firstTrip answer per pair of stops, keyed by from and to
+    mutable std::unordered_map<std::uint64_t, CachedTrip> tripCache_;
+};
+
+}
+
+#endif // JOURNEYPLANNER_HH
@@ -1,13 +1,25 @@
 #include "location.hh"
+#include "locationbuffer.hh"
+#include "projection.hh"
 
 #include <math.h>
+#include <cmath>
 #include <QDebug>
 
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 
 namespace Interface
 {
 
-Location::Location() : northcoord_(6700000), eastcoord_(3500000), x_(0), y_(0)
+constexpr int Location::FRACTION_BITS;
+
+Location::Location() :
+    northfixed_(6700000 << FRACTION_BITS), eastfixed_(3500000 << FRACTION_BITS)
 {
 
 }
@@ -22,38 +34,60 @@ Location::Location(int northcoord, int eastcoord) : Location()
 
 int Location::giveX() const
 {
-    return x_;
+    return xFromEast(eastfixed_);
 }
 
 int Location::giveY() const
 {
-    return y_;
+    return yFromNorth(northfixed_);
 }
 
 void Location::setXY(int x, int y)
 {
-    x_ = x;
-    y_ = y;
-    eastcoord_ = EastFromX(x);
-    northcoord_ = NorthFromY(y);
+    eastfixed_ = EastFromX(x);
+    northfixed_ = NorthFromY(y);
 }
 
 double Location::giveNorthernCoord() const
 {
-    return northcoord_;
+    return fromFixed(northfixed_);
 }
 
 double Location::giveEasternCoord() const
 {
-    return eastcoord_;
+    return fromFixed(eastfixed_);
 }
 
 void Location::setNorthEast(int northcoord, int eastcoord)
 {
-    northcoord_ = northcoord;
-    eastcoord_ = eastcoord;
-    x_ = xFromEast(eastcoord);
-    y_ = yFromNorth(northcoord);
+    northfixed_ = static_cast<std::int32_t>(northcoord) << FRACTION_BITS;
+    eastfixed_ = static_cast<std::int32_t>(eastcoord) << FRACTION_BITS;
+}
+
+std::int32_t Location::giveNorthernFixed() const
+{
+    return northfixed_;
+}
+
+std::int32_t Location::giveEasternFixed() const
+{
+    return eastfixed_;
+}
+
+void Location::setNorthEastFixed(std::int32_t northfixed, std::int32_t eastfixed)
+{
+    northfixed_ = northfixed;
+    eastfixed_ = eastfixed;
+}
+
+std::int32_t Location::toFixed(double coord)
+{
+    return static_cast<std::int32_t>(std::lround(coord * (1 << FRACTION_BITS)));
+}
+
+double Location::fromFixed(std::int32_t fixed)
+{
+    return fixed / static_cast<double>(1 << FRACTION_BITS);
 }
 
 bool Location::isClose(const Location &loc, int limit) const
@@ -64,31 +98,33 @@ bool Location::isClose(const Location &loc, int limit) const
     return dx*dx + dy*dy <= limit*limit;
 }
 
-int Location::xFromEast(int eastcoord)
+// Pixel coordinates are those of the small map, whose bottom left corner
+// is at kkj3-joint coordinate system point (6824642, 3327034),
+// scaling is 500:1500
+
+int Location::xFromEast(std::int32_t eastfixed)
 {
-    // 3327034 is kkj3-joint coordinate system point
-    // at bottom left corner of small map
-    // scaling is 500:1500
-    return static_cast<int>((eastcoord - 3327034) * 0.333333);
+    return SmallMapProjection::xFromEast(fromFixed(eastfixed));
 }
 
-int Location::yFromNorth(int northcoord)
+int Location::yFromNorth(std::int32_t northfixed)
 {
-    // 6824642 is kkj3-joint coordinate system point
-    // at nottom left corner of small map
-    // scaling is 500:1500
-    return static_cast<int>((northcoord - 6824642) * 0.333333);
+    return SmallMapProjection::yFromNorth(fromFixed(northfixed));
 }
 
+// Rounds away from the map corner, so that the pixel coordinate of the result,
+// which is truncated towards the corner, is the given one
 
-int Location::EastFromX(int x)
+std::int32_t Location::EastFromX(int x)
 {
-    return static_cast<int>(x/0.333333 + 3327034);
+    double fixed = SmallMapProjection::eastFromX(x) * (1 << FRACTION_BITS);
+    return static_cast<std::int32_t>(x < 0 ? std::floor(fixed) : std::ceil(fixed));
 }
 
-int Location::NorthFromY(int y)
+std::int32_t Location::NorthFromY(int y)
 {
-    return static_cast<int>(y/0.333333 + 6824642);
+    double fixed = SmallMapProjection::northFromY(y) * (1 << FRACTION_BITS);
+    return static_cast<std::int32_t>(y < 0 ? std::floor(fixed) : std::ceil(fixed));
 }
 
 double Location::calcDistance(Location a, Location b)
@@ -100,6 +136,98 @@ double Location::calcDistance(Location a, Location b)
     return distance;
 }
 
+void Location::calcDistances(const Location& from, const LocationBuffer& locations,
+                             std::vector<double>& distances)
+{
+    const std::size_t count = locations.size();
+    const double* east = locations.east.data();
+    const double* north = locations.north.data();
+    const double fromEast = from.giveEasternCoord();
+    const double fromNorth = from.giveNorthernCoord();
+
+    distances.resize(count);
+    double* out = distances.data();
+    std::size_t i = 0;
+
+#if defined(__AVX__)
+    const __m256d e0 = _mm256_set1_pd(fromEast);
+    const __m256d n0 = _mm256_set1_pd(fromNorth);
+    for (; i + 4 <= count; i += 4) {
+        __m256d de = _mm256_sub_pd(_mm256_loadu_pd(east + i), e0);
+        __m256d dn = _mm256_sub_pd(_mm256_loadu_pd(north + i), n0);
+        __m256d squared = _mm256_add_pd(_mm256_mul_pd(de, de), _mm256_mul_pd(dn, dn));
+        _mm256_storeu_pd(out + i, _mm256_sqrt_pd(squared));
+    }
+#elif defined(__SSE2__)
+    const __m128d e0 = _mm_set1_pd(fromEast);
+    const __m128d n0 = _mm_set1_pd(fromNorth);
+    for (; i + 2 <= count; i += 2) {
+        __m128d de = _mm_sub_pd(_mm_loadu_pd(east + i), e0);
+        __m128d dn = _mm_sub_pd(_mm_loadu_pd(north + i), n0);
+        __m128d squared = _mm_add_pd(_mm_mul_pd(de, de), _mm_mul_pd(dn, dn));
+        _mm_storeu_pd(out + i, _mm_sqrt_pd(squared));
+    }
+#endif
+
+    for (; i < count; ++i) {
+        double de = east[i] - fromEast;
+        double dn = north[i] - fromNorth;
+        out[i] = std::sqrt(de * de + dn * dn);
+    }
+}
+
+void Location::closeMask(const Location& loc, const LocationBuffer& locations,
+                         std::vector<std::uint64_t>& mask, int limit)
+{
+    const std::size_t count = locations.size();
+    const int* xs = locations.x.data();
+    const int* ys = locations.y.data();
+    const int x0 = loc.giveX();
+    const int y0 = loc.giveY();
+
+    mask.assign((count + 63) / 64, 0);
+    std::size_t i = 0;
+
+    // Pixel coordinates and their differences are exact in float. Squares of large
+    // differences may round, but only far above any sensible limit.
+#if defined(__AVX__)
+    const __m256 qx = _mm256_set1_ps(static_cast<float>(x0));
+    const __m256 qy = _mm256_set1_ps(static_cast<float>(y0));
+    const __m256 lim = _mm256_set1_ps(static_cast<float>(limit * limit));
+    for (; i + 8 <= count; i += 8) {
+        __m256 dx = _mm256_sub_ps(_mm256_cvtepi32_ps(
+                                      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(xs + i))), qx);
+        __m256 dy = _mm256_sub_ps(_mm256_cvtepi32_ps(
+                                      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ys + i))), qy);
+        __m256 squared = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        std::uint64_t bits = static_cast<unsigned int>(
+                    _mm256_movemask_ps(_mm256_cmp_ps(squared, lim, _CMP_LE_OQ)));
+        mask[i / 64] |= bits << (i % 64);
+    }
+#elif defined(__SSE2__)
+    const __m128 qx = _mm_set1_ps(static_cast<float>(x0));
+    const __m128 qy = _mm_set1_ps(static_cast<float>(y0));
+    const __m128 lim = _mm_set1_ps(static_cast<float>(limit * limit));
+    for (; i + 4 <= count; i += 4) {
+        __m128 dx = _mm_sub_ps(_mm_cvtepi32_ps(
+                                   _mm_loadu_si128(reinterpret_cast<const __m128i*>(xs + i))), qx);
+        __m128 dy = _mm_sub_ps(_mm_cvtepi32_ps(
+                                   _mm_loadu_si128(reinterpret_cast<const __m128i*>(ys + i))), qy);
+        __m128 squared = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        std::uint64_t bits = static_cast<unsigned int>(_mm_movemask_ps(_mm_cmple_ps(squared, lim)));
+        mask[i / 64] |= bits << (i % 64);
+    }
+#endif
+
+    for (; i < count; ++i) {
+        long long dx = xs[i] - x0;
+        long long dy = ys[i] - y0;
+        if (dx * dx + dy * dy <= static_cast<long long>(limit) * limit) {
+            mask[i / 64] |= std::uint64_t(1) << (i % 64);
+        }
+    }
+}
+
 Location Location::calcBetween(Location a, Location b, double distance)
 {
     // Creating a vector
@@ -111,15 +239,15 @@ Location Location::calcBetween(Location a, Location b, double distance)
 }
 
 void Location::printBoth() {
-    qDebug() << northcoord_ << " " << eastcoord_;
-    qDebug() << x_ << " " << y_;
+    qDebug() << giveNorthernCoord() << " " << giveEasternCoord();
+    qDebug() << giveX() << " " << giveY();
 }
 
 bool Location::operator==(const Location &location)
 {
     // comparison operator
     // needed, for determining wether a bus stop and location are equal
-    return (this->x_==location.giveX() && this->y_ == location.giveY());
+    return (giveX() == location.giveX() && giveY() == location.giveY());
 }
 
 }
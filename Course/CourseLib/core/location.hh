@@ -1,6 +1,9 @@
 #ifndef LOCATION_HH
 #define LOCATION_HH
 
+#include <cstdint>
+#include <vector>
+
 /**
   * @file
   * @brief Defines a class that contains methods for handling location. (coordinates)
@@ -10,16 +13,27 @@
 namespace Interface
 {
 
+struct LocationBuffer;
+
 /**
  * @brief Location is a class, which has methods dealing with the location of the objects.
  *
  * The class provides transformation from map coordinates to pixel coordinates and back, calculation
  * of the distnce and the possibility of generating points between two coordinates.
  *
+ * Map coordinates are stored as fixed-point numbers with FRACTION_BITS fractional bits, so a
+ * location takes 8 bytes and sub-metre movement accumulates exactly. Pixel coordinates are
+ * derived from the map coordinates when asked. Fixed-point coordinates cover map coordinates
+ * below 2^(31 - FRACTION_BITS) metres, which includes all of Finland.
  */
 class Location
 {
 public:
+    /**
+     * @brief FRACTION_BITS is the number of fractional bits in fixed-point map coordinates.
+     */
+    static constexpr int FRACTION_BITS = 8;
+
     /**
      * @brief Default constructor
      * @post Location is set to north=6700000, east=3500000.
@@ -85,6 +99,40 @@ public:
      */
     void setNorthEast(int northcoord, int eastcoord);
 
+    /**
+     * @brief giveNorthernFixed returns the northern coordinate from map grid in fixed point.
+     * @pre -
+     * @return Northern coordinate multiplied by 2^FRACTION_BITS
+     * @post Exception guarantee: nothrow.
+     */
+    std::int32_t giveNorthernFixed() const;
+
+    /**
+     * @brief giveEasternFixed returns the eastern coordinate from map grid in fixed point.
+     * @pre -
+     * @return Eastern coordinate multiplied by 2^FRACTION_BITS
+     * @post Exception guarantee: nothrow.
+     */
+    std::int32_t giveEasternFixed() const;
+
+    /**
+     * @brief setNorthEastFixed moves the location to a new fixed-point coordinate in map grid.
+     * @param northfixed northern coordinate multiplied by 2^FRACTION_BITS
+     * @param eastfixed eastern coordinate multiplied by 2^FRACTION_BITS
+     * @pre -
+     * @post Location is updated. Exception guarantee: nothrow.
+     */
+    void setNorthEastFixed(std::int32_t northfixed, std::int32_t eastfixed);
+
+    /**
+     * @brief toFixed converts a map coordinate or a distance to fixed point.
+     * @param coord coordinate or distance in metres
+     * @pre coord is inside the fixed-point range.
+     * @return coord multiplied by 2^FRACTION_BITS, rounded to nearest
+     * @post Exception guarantee: nothrow.
+     */
+    static std::int32_t toFixed(double coord);
+
     /**
      * @brief isClose tells if given location is close to this location.
      *
@@ -108,6 +156,36 @@ public:
      */
     static double calcDistance(Location a, Location b);
 
+    /**
+     * @brief calcDistances calculates the distances from one location to many locations in map grid.
+     *
+     * Uses AVX or SSE2 when the library is compiled with them, otherwise a scalar loop.
+     *
+     * @param from location the distances are calculated from
+     * @param locations locations the distances are calculated to
+     * @param distances output, element i is the distance to location i
+     * @pre -
+     * @post distances.size() == locations.size(). Exception guarantee: basic.
+     */
+    static void calcDistances(const Location& from, const LocationBuffer& locations,
+                              std::vector<double>& distances);
+
+    /**
+     * @brief closeMask tells which of many locations are close to the given location.
+     *
+     * Batch version of isClose. Uses AVX or SSE2 when the library is compiled with them,
+     * otherwise a scalar loop.
+     *
+     * @param loc location the closeness is checked to
+     * @param locations locations to be checked
+     * @param mask output bitmask, bit i % 64 of word i / 64 is set if location i is close
+     * @param limit same as in isClose
+     * @pre -
+     * @post mask has (locations.size() + 63) / 64 words. Exception guarantee: basic.
+     */
+    static void closeMask(const Location& loc, const LocationBuffer& locations,
+                          std::vector<std::uint64_t>& mask, int limit = 10);
+
     /**
      * @brief calcBetween calculates wanted position between two locations.
      * @param a first location
@@ -129,15 +207,15 @@ public:
 
 private:
 
-    static int xFromEast(int eastcoord);
-    static int yFromNorth(int northcoord);
-    static int EastFromX(int x);
-    static int NorthFromY(int y);
+    static int xFromEast(std::int32_t eastfixed);
+    static int yFromNorth(std::int32_t northfixed);
+    static std::int32_t EastFromX(int x);
+    static std::int32_t NorthFromY(int y);
+
+    static double fromFixed(std::int32_t fixed);
 
-    int northcoord_;
-    int eastcoord_;
-    int x_;
-    int y_;
+    std::int32_t northfixed_;
+    std::int32_t eastfixed_;
 };
 
 }
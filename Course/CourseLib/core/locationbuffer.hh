@@ -0,0 +1,113 @@
+#ifndef LOCATIONBUFFER_HH
+#define LOCATIONBUFFER_HH
+
+#include "core/location.hh"
+
+#include <cstddef>
+#include <vector>
+
+/**
+  * @file
+  * @brief Defines a structure-of-arrays buffer of locations for the batch operations of Location.
+  */
+
+namespace Interface
+{
+
+/**
+ * @brief LocationBuffer stores many locations as separate contiguous coordinate arrays.
+ *
+ * Element i of each array belongs to the same location. Map coordinates are used by
+ * Location::calcDistances and pixel coordinates by Location::closeMask.
+ */
+struct LocationBuffer
+{
+    std::vector<double> east;
+    std::vector<double> north;
+    std::vector<int> x;
+    std::vector<int> y;
+
+    /**
+     * @brief push_back appends a location to the buffer.
+     * @param loc location to be appended
+     * @post Exception guarantee: basic.
+     */
+    void push_back(const Location& loc)
+    {
+        east.push_back(loc.giveEasternCoord());
+        north.push_back(loc.giveNorthernCoord());
+        x.push_back(loc.giveX());
+        y.push_back(loc.giveY());
+    }
+
+    /**
+     * @brief set replaces a location in the buffer.
+     * @param i index of the location
+     * @param loc new location
+     * @pre i < size()
+     * @post Exception guarantee: nothrow.
+     */
+    void set(std::size_t i, const Location& loc)
+    {
+        east[i] = loc.giveEasternCoord();
+        north[i] = loc.giveNorthernCoord();
+        x[i] = loc.giveX();
+        y[i] = loc.giveY();
+    }
+
+    /**
+     * @brief swapRemove removes a location by moving the last location to its place.
+     * @param i index of the location
+     * @pre i < size()
+     * @post Locations other than the last keep their indices. Exception guarantee: nothrow.
+     */
+    void swapRemove(std::size_t i)
+    {
+        east[i] = east.back();
+        north[i] = north.back();
+        x[i] = x.back();
+        y[i] = y.back();
+        east.pop_back();
+        north.pop_back();
+        x.pop_back();
+        y.pop_back();
+    }
+
+    /**
+     * @brief reserve reserves space for count locations.
+     * @param count number of locations
+     */
+    void reserve(std::size_t count)
+    {
+        east.reserve(count);
+        north.reserve(count);
+        x.reserve(count);
+        y.reserve(count);
+    }
+
+    /**
+     * @brief clear removes all locations but keeps the allocated space.
+     * @post Exception guarantee: nothrow.
+     */
+    void clear()
+    {
+        east.clear();
+        north.clear();
+        x.clear();
+        y.clear();
+    }
+
+    /**
+     * @brief size returns the number of locations in the buffer.
+     * @return number of locations
+     * @post Exception guarantee: nothrow.
+     */
+    std::size_t size() const
+    {
+        return east.size();
+    }
+};
+
+}
+
+#endif // LOCATIONBUFFER_HH
@@ -1,31 +1,105 @@
 #include "core/logic.hh"
+#include "core/trace.hh"
 #include "offlinereader.hh"
 #include <QTimer>
 #include <memory>
 #include <iostream>
+#include <sstream>
+#include <unordered_set>
+#include <QDataStream>
 #include <QDebug>
 #include <QDir>
+#include <QtConcurrent>
 
 namespace CourseSide
 {
 
+namespace
+{
+
+// Share of fileConfigAsync progress given to reading, the rest is building the graphs
+const int READING_PERCENT = 90;
+
+// Bus of a snapshot, created again from its line and departure
+struct SavedBus
+{
+    qint32 line;
+    QTime start;
+    qint32 sid;
+};
+
+// Passenger of a snapshot, either at a stop or in a bus of the snapshot. Stops of the
+// game are numbered after the stops of the timetable
+struct SavedPassenger
+{
+    qint32 destination;
+    qint32 stop;
+    qint32 bus;
+};
+
+// Pending boarding or alighting of a snapshot, by the numbers of its passenger and bus
+struct SavedBoarding
+{
+    qint64 time;
+    quint8 kind;
+    qint32 passenger;
+    qint32 bus;
+    qint32 stop;
+};
+
+}
+
 Logic::Logic(QObject *parent)
     : QObject(parent),
+      pool_(std::make_shared<Pool>()),
+      clock_(0),
+      lastClockMsecs_(0),
       debugstate_(false),
       gamestarted_(false),
       time_(QTime::currentTime().hour(), QTime::currentTime().minute(), QTime::currentTime().second()),
-      busSID_(0)
+      busSID_(0),
+      ticks_(0)
 {
+    // time_ is declared after lastClockMsecs_
+    lastClockMsecs_ = time_.msecsSinceStartOfDay();
+
+    connect(&loader_, &QFutureWatcher<std::shared_ptr<LoadedData>>::finished, this, [this]() {
+        std::shared_ptr<LoadedData> loaded = loader_.result();
+        bool ret = loaded->data != nullptr;
+        if (ret) {
+            offlinedata_ = loaded->data;
+            transit_ = std::move(loaded->transit);
+            planner_ = std::move(loaded->planner);
+            busfile_ = loadingBusfile_;
+            stopfile_ = loadingStopfile_;
+        } else {
+            qCWarning(courseLogic) << "Something went wrong with reading the files.";
+        }
+        emit loadingProgress(100);
+        emit offlineDataLoaded(ret);
+    });
+}
+
+Logic::~Logic()
+{
+    // The worker posts progress to this object
+    loader_.waitForFinished();
 }
 
 bool Logic::readOfflineData(const QString &buses, const QString &stops)
 {
     OfflineReader offlinereader;
-    if((offlinedata_ = offlinereader.readFiles(buses, stops)) == NULL) {
+    return takeOfflineData(offlinereader.readFiles(buses, stops));
+}
+
+bool Logic::takeOfflineData(std::shared_ptr<OfflineData> data)
+{
+    if ((offlinedata_ = data) == NULL) {
         return false;
     }
+    transit_.build(*offlinedata_);
+    planner_.build(*offlinedata_);
     return true;
-
 }
 
 void Logic::finalizeGameStart()
@@ -35,18 +109,23 @@ void Logic::finalizeGameStart()
 
     addStopsAndPassengers();
 
+    startGame();
+}
+
+void Logic::startGame()
+{
     cityif_->setClock(time_);
     cityif_->startGame();
     gamestarted_ = true;
 
     connect(&timer_, SIGNAL(timeout()), this, SLOT(increaseTime()));
     timer_.start(UPDATE_INTERVAL_MS);
-
 }
 
 void Logic::setTime(unsigned short hr, unsigned short min)
 {
     time_.setHMS(hr, min, 0);
+    lastClockMsecs_ = time_.msecsSinceStartOfDay();
 }
 
 void Logic::advance()
@@ -54,29 +133,39 @@ void Logic::advance()
     // Tells the city a new time every minute
     if (time_.second() == 0) {
         cityif_->setClock(time_);
+        sampleStatistics();
+        statistics_.minutePassed();
     }
 
-    // Goes through current passengers and removes removed (from game) passengers from data structures
-    for (std::list<std::shared_ptr<Passenger>>::iterator it = passengers_.begin();
-         it != passengers_.end(); it++) {
+    // Game time since the start, time_ wraps at midnight
+    const int DAY_MSECS = 24 * 60 * 60 * 1000;
+    clock_ += (time_.msecsSinceStartOfDay() - lastClockMsecs_ + DAY_MSECS) % DAY_MSECS;
+    lastClockMsecs_ = time_.msecsSinceStartOfDay();
 
-        // Check if removed
-        if (it->get()->isRemoved()) {
-            // Remove passenger from buses or stops accounting
-            if (it->get()->isInVehicle()) {
-                it->get()->getVehicle()->removePassenger(*it);
-            } else {
-                std::shared_ptr<Stop> pysakki = std::dynamic_pointer_cast<Stop>(it->get()->getStop());
-                pysakki->removePassenger(*it);
-            }
+    // Goes through current passengers and removes removed (from game) passengers from data structures.
+    // Only the removed column is scanned, walking backwards keeps unvisited rows in place
+    const std::vector<std::uint8_t>& removed = passengers_.removed();
+    for (std::size_t row = passengers_.size(); row-- > 0; ) {
+        if (!removed[row]) {
+            continue;
+        }
+        std::shared_ptr<Passenger> passenger = passengers_.handles()[row];
 
-            // Remove passenger from accounting
-            if (cityif_->findActor(*it)) {
-                cityif_->removeActor(*it);
+        // Remove passenger from buses or stops accounting
+        if (passengers_.vehicles()[row] != nullptr) {
+            if (std::shared_ptr<Interface::IVehicle> vehicle = passenger->getVehicle()) {
+                vehicle->removePassenger(passenger);
             }
-            it = passengers_.erase(it);
-            continue;
+        } else if (std::shared_ptr<Interface::IStop> stop = passenger->getStop()) {
+            // Stop is the only implementation of IStop
+            std::static_pointer_cast<Stop>(stop)->removePassenger(passenger);
         }
+
+        // Remove passenger from accounting
+        if (cityif_->findActor(passenger)) {
+            cityif_->removeActor(passenger);
+        }
+        passengers_.erase(row);
     }
 
     // Goes through current buses and removes ones that are removed
@@ -88,8 +177,10 @@ void Logic::advance()
 
             // If bus is marked removed, go through its passengers and check that they are marked as removed too
             // If not marked --> mark as removed and remove the bus and its passengers from data structures
-            for (std::shared_ptr<Interface::IPassenger> passengerif : bus->getPassengers()) {
-                std::shared_ptr<Passenger> passenger = std::dynamic_pointer_cast<Passenger> (passengerif);
+            Interface::PassengerView onboard = bus->passengers();
+            for (const std::shared_ptr<Interface::IPassenger>& passengerif : onboard) {
+                Q_ASSERT(passengerif->getKind() == Interface::ActorKind::PASSENGER);
+                std::shared_ptr<Passenger> passenger = std::static_pointer_cast<Passenger> (passengerif);
 
                 if (!passenger->isRemoved()) {
                     passenger->remove();
@@ -99,11 +190,14 @@ void Logic::advance()
                     cityif_->removeActor(passenger);
                 }
                 // remove the pasenger from course side data structure
-                passengers_.remove(passenger);
+                passengers_.erase(*passenger);
             }
-            qDebug() << "Removing nysse: " << QString::fromStdString(bus->getName());
+            COURSE_TRACE(Trace::Event::BUS_REMOVED, static_cast<std::int32_t>(onboard.size()), 0);
+            statistics_.busLeft();
+            arrivals_.remove(bus.get());
+            busRuns_.erase(bus.get());
 
-            std::shared_ptr<Interface::IActor> toimijaBussi = std::dynamic_pointer_cast<Interface::IActor> (*it);
+            std::shared_ptr<Interface::IActor> toimijaBussi = *it;
 
             if (cityif_->findActor(toimijaBussi)) {
                 cityif_->removeActor(toimijaBussi);
@@ -118,14 +212,15 @@ void Logic::advance()
         if (!ret) { // Remove bus if at final stop or wrong time
 
             // Put passengers to the final stop of the bus
-            std::vector<std::shared_ptr<Interface::IPassenger>> passengers = bus->getPassengers();
+            Interface::PassengerView passengers = bus->passengers();
             std::weak_ptr<Stop> finalStop = bus->getFinalStop();
 
-            // every passenger moved out of bus before it is removed
-            for (auto passengerIt = passengers.begin(); passengerIt != passengers.end(); passengerIt++) {
+            // every passenger moved out of bus before it is removed,
+            // walking backwards keeps the view valid while removing
+            for (std::size_t i = passengers.size(); i-- > 0; ) {
                 // assuming that passengers are of certain type
-                std::shared_ptr<Passenger> passenger = std::dynamic_pointer_cast<Passenger>(*passengerIt);
-                Q_ASSERT(passenger != nullptr);
+                Q_ASSERT(passengers[i]->getKind() == Interface::ActorKind::PASSENGER);
+                std::shared_ptr<Passenger> passenger = std::static_pointer_cast<Passenger>(passengers[i]);
 
                 // Updates passenger to the final stop
                 // Location of the passenger is already updated at
@@ -141,9 +236,14 @@ void Logic::advance()
                 cityif_->removeActor(*it);
             }
 
+            COURSE_TRACE(Trace::Event::BUS_LEFT, static_cast<std::int32_t>(passengers.size()), 0);
+            statistics_.busLeft();
+            arrivals_.remove(bus.get());
+            busRuns_.erase(bus.get());
             it = buses_.erase(it);
 
         } else {
+            updateArrival(bus);
             ++it;
         }
     }
@@ -159,62 +259,250 @@ void Logic::advance()
         addNewBuses();
     }
 
-    // go through all stops that have buses
-    for (std::shared_ptr <Nysse> bus : buses_) {
-        std::shared_ptr <Stop> stop = bus->getStop().lock();
+    // Passengers decide once when a bus arrives, and the decisions are carried out
+    // when they are due. Work does not depend on how long buses dwell or on the tick rate
+    for (const std::shared_ptr<Nysse>& bus : newArrivals_) {
+        scheduleBoarding(bus);
+    }
+    newArrivals_.clear();
+
+    runBoardings();
 
-        if (stop != nullptr) {
-            // 1. move passengers to stop if they want to
+    // Events of this tick are given to statistics at once
+    statistics_.flush();
+}
 
-            for (std::shared_ptr <Interface::IPassenger> ipassenger : bus->getPassengers()) {
-                std::shared_ptr <Passenger> passenger = std::dynamic_pointer_cast<Passenger> (ipassenger);
-                Q_ASSERT(passenger != nullptr);
+void Logic::updateArrival(const std::shared_ptr<Nysse>& bus)
+{
+    if (arrivals_.update(bus, bus->getStop().lock())) {
+        newArrivals_.push_back(bus);
+    }
+}
 
-                if (passenger->wantToEnterStop(stop)) {
-                    passenger->enterStop(stop);
-                    bus->removePassenger(ipassenger);
-                    stop->addPassenger(passenger);
-                    cityif_->actorMoved(passenger);
-                }
-            }
+void Logic::scheduleBoarding(const std::shared_ptr<Nysse>& bus)
+{
+    std::shared_ptr<Stop> stop = bus->getStop().lock();
+    if (stop == nullptr || arrivals_.stopOf(bus.get()) != stop.get()) {
+        // Left again before the decisions were made
+        return;
+    }
+
+    // Alighting passengers use the door first, then the boarding ones
+    std::int64_t doorTime = clock_;
+    for (const std::shared_ptr<Interface::IPassenger>& passengerif : bus->passengers()) {
+        Q_ASSERT(passengerif->getKind() == Interface::ActorKind::PASSENGER);
+        std::shared_ptr<Passenger> passenger = std::static_pointer_cast<Passenger>(passengerif);
+
+        if (wantsToAlight(passenger, bus, stop)) {
+            boardings_.schedule(BoardingSchedule::Kind::ALIGHT, doorTime, passenger, bus, stop);
+            doorTime += DOOR_INTERVAL_MS;
         }
     }
 
-    // 2. let every passenger in this stop about the buses in this stop at this time
-    for (std::shared_ptr <Nysse> stopbus : buses_) {
-        std::shared_ptr <Stop> stop = stopbus->getStop().lock();
+    for (const std::shared_ptr<Interface::IPassenger>& passengerif : stop->passengers()) {
+        Q_ASSERT(passengerif->getKind() == Interface::ActorKind::PASSENGER);
+        std::shared_ptr<Passenger> passenger = std::static_pointer_cast<Passenger>(passengerif);
 
-        // stopbus is bus that is currently at the same stop
-        if (stop != nullptr) {
-            for (std::shared_ptr <Interface::IPassenger> istoppassenger : stop->getPassengers()) {
-                std::shared_ptr <Passenger> stoppassenger = std::dynamic_pointer_cast<Passenger> (istoppassenger);
-                Q_ASSERT(stoppassenger != nullptr);
+        if (wantsToBoard(passenger, bus, stop)) {
+            boardings_.schedule(BoardingSchedule::Kind::BOARD, doorTime, passenger, bus, stop);
+            doorTime += DOOR_INTERVAL_MS;
+        }
+    }
+}
 
-                if (stoppassenger->wantToEnterNysse(stopbus)) {
-                    stoppassenger->enterNysse(stopbus);
-                    stop->removePassenger(stoppassenger);
-                    stopbus->addPassenger(stoppassenger);
-                    cityif_->actorMoved(stoppassenger);
-                }
+bool Logic::wantsToBoard(const std::shared_ptr<Passenger>& passenger,
+                         const std::shared_ptr<Nysse>& bus, const std::shared_ptr<Stop>& stop)
+{
+    auto run = busRuns_.find(bus.get());
+    std::int32_t from = transit_.stopIndex(stop.get());
+    std::int32_t destination = passengers_.destinationOf(*passenger);
+    std::int32_t trip = plannedTrip(bus.get(), from, destination);
+    if (trip != JourneyPlanner::NONE) {
+        return trip == run->second.trip;
+    }
+
+    TransitGraph::Advice advice = transit_.board(
+                run == busRuns_.end() ? TransitGraph::NONE : run->second.pattern,
+                from, destination);
+    if (advice == TransitGraph::Advice::UNKNOWN) {
+        // Half of the passengers board, as Passenger::wantToEnterNysse decides
+        return randomBelow(2) != 0;
+    }
+    return advice == TransitGraph::Advice::YES;
+}
+
+bool Logic::wantsToAlight(const std::shared_ptr<Passenger>& passenger,
+                          const std::shared_ptr<Nysse>& bus, const std::shared_ptr<Stop>& stop)
+{
+    auto run = busRuns_.find(bus.get());
+    std::int32_t at = transit_.stopIndex(stop.get());
+    std::int32_t destination = passengers_.destinationOf(*passenger);
+    std::int32_t trip = plannedTrip(bus.get(), at, destination);
+    if (trip != JourneyPlanner::NONE) {
+        // The fastest journey from here does not stay on this bus
+        return trip != run->second.trip;
+    }
+
+    TransitGraph::Advice advice = transit_.alight(
+                run == busRuns_.end() ? TransitGraph::NONE : run->second.pattern,
+                at, destination);
+    if (advice == TransitGraph::Advice::UNKNOWN) {
+        // Half of the passengers alight, as Passenger::wantToEnterStop decides
+        return randomBelow(2) != 0;
+    }
+    return advice == TransitGraph::Advice::YES;
+}
+
+std::int32_t Logic::plannedTrip(const Nysse* bus, std::int32_t stop, std::int32_t destination) const
+{
+    auto run = busRuns_.find(bus);
+    if (run == busRuns_.end() || stop == JourneyPlanner::NONE ||
+            destination == PassengerTable::NO_STOP || stop == destination) {
+        return JourneyPlanner::NONE;
+    }
+    // Planned from when this bus leaves, so that staying on it is one of the journeys.
+    // Runs that continue past midnight have times over 24 hours in planner_
+    std::int32_t departure = JourneyPlanner::NEVER;
+    if (run->second.trip != JourneyPlanner::NONE) {
+        const int DAY_SECONDS = 24 * 60 * 60;
+        std::int32_t start = planner_.trips()[run->second.trip].start;
+        std::int32_t now = time_.msecsSinceStartOfDay() / 1000;
+        departure = planner_.departureAt(run->second.trip, stop,
+                                         start + (now - start + DAY_SECONDS) % DAY_SECONDS);
+    }
+    if (departure == JourneyPlanner::NEVER) {
+        return JourneyPlanner::NONE;
+    }
+    return planner_.firstTrip(stop, destination, departure);
+}
+
+void Logic::offerDwellingBuses(const std::shared_ptr<Passenger>& passenger,
+                               const std::shared_ptr<Stop>& stop, const Nysse* except)
+{
+    const ArrivalTable::Dwell* dwell = arrivals_.dwellAt(stop.get());
+    if (dwell == nullptr) {
+        return;
+    }
+    for (const std::shared_ptr<Nysse>& bus : dwell->buses) {
+        if (bus.get() != except && wantsToBoard(passenger, bus, stop)) {
+            boardings_.schedule(BoardingSchedule::Kind::BOARD, clock_ + DOOR_INTERVAL_MS,
+                                passenger, bus, stop);
+            return;
+        }
+    }
+}
+
+void Logic::runBoardings()
+{
+    BoardingSchedule::Event event;
+    while (boardings_.takeDue(clock_, event)) {
+        std::shared_ptr<Passenger> passenger = event.passenger.lock();
+        std::shared_ptr<Nysse> bus = event.bus.lock();
+        std::shared_ptr<Stop> stop = event.stop.lock();
+
+        // Skip what is no longer possible, e.g. the bus has left
+        if (passenger == nullptr || bus == nullptr || stop == nullptr || passenger->isRemoved() ||
+                arrivals_.stopOf(bus.get()) != stop.get()) {
+            continue;
+        }
+
+        if (event.kind == BoardingSchedule::Kind::ALIGHT) {
+            if (passenger->getVehicle() != bus) {
+                continue;
+            }
+            passenger->enterStop(stop);
+            bus->removePassenger(passenger);
+            stop->addPassenger(passenger);
+            cityif_->actorMoved(passenger);
+            if (StatisticsPolicy::EVENTS) {
+                statistics_.alighted(lineOf(bus.get()));
+            }
+            // Passengers who have arrived leave the game, the next advance removes them
+            std::int32_t destination = passengers_.destinationOf(*passenger);
+            if (destination != PassengerTable::NO_STOP &&
+                    destination == passengers_.stopIndex(stop.get())) {
+                passenger->remove();
+                continue;
+            }
+            offerDwellingBuses(passenger, stop, bus.get());
+        } else {
+            // Boarding an earlier bus makes the passenger leave the stop
+            if (passenger->getStop() != stop) {
+                continue;
+            }
+            passenger->enterNysse(bus);
+            stop->removePassenger(passenger);
+            bus->addPassenger(passenger);
+            cityif_->actorMoved(passenger);
+            if (StatisticsPolicy::EVENTS) {
+                statistics_.boarded(lineOf(bus.get()));
             }
         }
     }
 }
 
+unsigned int Logic::lineOf(const Nysse* bus) const
+{
+    std::unordered_map<const Nysse*, BusRun>::const_iterator run = busRuns_.find(bus);
+    return run != busRuns_.end() ? run->second.line : 0;
+}
+
+void Logic::sampleStatistics()
+{
+    if (!StatisticsPolicy::SAMPLES) {
+        return;
+    }
+    for (const std::shared_ptr<Stop>& stop : offlinedata_->stops) {
+        statistics_.waiting(stop->getId(), static_cast<int>(stop->passengers().size()));
+    }
+    for (const std::shared_ptr<Nysse>& bus : buses_) {
+        statistics_.load(lineOf(bus.get()), static_cast<int>(bus->passengers().size()));
+    }
+}
+
 void Logic::fileConfig(QString stops, QString buses) {
-            qDebug () << "fileConfig";
-            qDebug () << " ----check";
-            qDebug () << QDir::currentPath();
+    qCDebug(courseLogic) << "fileConfig, working directory:" << QDir::currentPath();
     bool ret = readOfflineData(buses, stops);
 
     if (ret) {
         busfile_ = buses;
         stopfile_ = stops;
     } else {
-        qDebug () << "Something went wrong with reading the files.";
+        qCWarning(courseLogic) << "Something went wrong with reading the files.";
     }
 }
 
+void Logic::fileConfigAsync(QString stops, QString buses)
+{
+    Q_ASSERT(!loader_.isRunning());
+    qCDebug(courseLogic) << "fileConfigAsync, working directory:" << QDir::currentPath();
+    loadingBusfile_ = buses;
+    loadingStopfile_ = stops;
+
+    // Progress is posted only when the percentage changes, not for every stop. Reading
+    // ends below 100 so the dialog stays open while the graphs are built.
+    int lastPercent = -1;
+    OfflineReader::ProgressCallback progress = [this, lastPercent](int done, int total) mutable {
+        int percent = total > 0 ? done * READING_PERCENT / total : 0;
+        if (percent != lastPercent) {
+            lastPercent = percent;
+            QMetaObject::invokeMethod(this, [this, percent]() {
+                emit loadingProgress(percent);
+            }, Qt::QueuedConnection);
+        }
+    };
+    loader_.setFuture(QtConcurrent::run([buses, stops, progress]() {
+        std::shared_ptr<LoadedData> loaded = std::make_shared<LoadedData>();
+        OfflineReader offlinereader;
+        loaded->data = offlinereader.readFiles(buses, stops, progress);
+        if (loaded->data != nullptr) {
+            loaded->transit.build(*loaded->data);
+            loaded->planner.build(*loaded->data);
+        }
+        return loaded;
+    }));
+}
+
 void Logic::configChanged(QTime time, bool debug)
 {
     // handling the command line parameters
@@ -234,9 +522,12 @@ void Logic::increaseTime()
     }
 
     time_ = time_.addMSecs(TIME_SPEED * UPDATE_INTERVAL_MS);
+    ++ticks_;
+    if (Trace::isEnabled()) {
+        Trace::setClock(time_.msecsSinceStartOfDay());
+    }
     if (time_.second() == 0) {
-        qDebug() << "";
-        qDebug() << "time is: " << time_.toString();
+        qCDebug(courseLogic) << "time is: " << time_.toString();
     }
 
     // move all old buses
@@ -264,10 +555,9 @@ bool Logic::calculateNewLocationForBus(std::shared_ptr<Nysse> bus)
     cityif_->actorMoved(bus);
 
     // passengers are moved
-    std::vector<std::shared_ptr<Interface::IPassenger>> passengers = bus->getPassengers();
-    for (auto it = passengers.begin(); it != passengers.end(); it++) {
-        it->get()->move(newLocation);
-        cityif_->actorMoved(*it);
+    for (const std::shared_ptr<Interface::IPassenger>& passenger : bus->passengers()) {
+        passenger->move(newLocation);
+        cityif_->actorMoved(passenger);
     }
 
     return true;
@@ -275,7 +565,7 @@ bool Logic::calculateNewLocationForBus(std::shared_ptr<Nysse> bus)
 
 void Logic::addBuses()
 {
-    qDebug() << "Current time: " << time_.toString();
+    qCDebug(courseLogic) << "Current time: " << time_.toString();
     // Find buses that are on route from offlinedata
     for (std::shared_ptr<BusData> bus: offlinedata_->buses) {
         for (QTime starttime : bus->schedule) {
@@ -289,14 +579,14 @@ void Logic::addBuses()
 
                 // if debug state on, add only one
                 if (debugstate_) {
-                    qDebug() << "Debug on --> only one bus";
+                    qCDebug(courseLogic) << "Debug on --> only one bus";
                     return;
                 }
             }
         }
     }
 
-    qDebug() << "Buses currently at traffic: " << buses_.size();
+    COURSE_TRACE(Trace::Event::BUSES_IN_TRAFFIC, static_cast<std::int32_t>(buses_.size()), 0);
 }
 
 void Logic::addNewBuses()
@@ -320,27 +610,33 @@ void Logic::addNewBuses()
             }
         }
     }
-    qDebug() << "Buses currently at traffic: " << buses_.size();
+    COURSE_TRACE(Trace::Event::BUSES_IN_TRAFFIC, static_cast<std::int32_t>(buses_.size()), 0);
 }
 
 
-void Logic::createBus(std::shared_ptr<BusData> bus, QTime starttime)
+std::shared_ptr<Nysse> Logic::createBus(std::shared_ptr<BusData> bus, QTime starttime)
 {
     QTime time = (--(bus->timeRoute2.end()))->first;
     int minutes = time.minute() + time.hour() * 60;
 
     if (time_ == starttime.addSecs( minutes * 60 )) {
         // return if bus is at final stop
-        return;
+        return nullptr;
     }
 
     // Create new bus and add it to city
-    std::shared_ptr<Nysse> newBus = std::make_shared<Nysse>(bus->routeNumber);
+    std::shared_ptr<Nysse> newBus =
+            std::allocate_shared<Nysse>(PoolAllocator<Nysse>(pool_), bus->routeNumber);
 
     // Add data to buses
     newBus->setRoute(bus->timeRoute2, starttime);
     newBus->calcStartingPos(time_);
     buses_.push_back(newBus);
+    busRuns_.insert({newBus.get(), BusRun{transit_.patternOf(bus.get()),
+                                          planner_.tripOf(bus.get(),
+                                                          starttime.msecsSinceStartOfDay() / 1000),
+                                          starttime, busSID_, bus->routeNumber}});
+    updateArrival(newBus);
     newBus->setCity(cityif_);
     newBus->setSID(busSID_);
 
@@ -348,7 +644,9 @@ void Logic::createBus(std::shared_ptr<BusData> bus, QTime starttime)
     cityif_->addActor(newBus);
 
     // Buses at transport
-    qDebug() << "Bus added! Route nro: " << bus->routeNumber;
+    COURSE_TRACE(Trace::Event::BUS_ADDED, static_cast<std::int32_t>(bus->routeNumber), busSID_ - 1);
+    statistics_.busAdded();
+    return newBus;
 }
 
 std::map<QTime, std::weak_ptr<Stop> > Logic::calculateStopTimes(std::map<QTime, std::shared_ptr<Stop> > &stops, QTime &starttime)
@@ -366,43 +664,376 @@ std::map<QTime, std::weak_ptr<Stop> > Logic::calculateStopTimes(std::map<QTime,
 void Logic::addStopsAndPassengers()
 {
     // give city all stops before creating passengers
-    for ( std::shared_ptr<Stop> stop: offlinedata_->stops) {
-        cityif_->addStop(stop);
-    }
+    addStopsToCity();
 
+    // at most 10 passengers per stop
+    std::vector<std::shared_ptr<Interface::IActor>> newPassengers;
+    newPassengers.reserve(offlinedata_->stops.size() * 10);
     for ( std::shared_ptr<Stop> stop: offlinedata_->stops) {
         // add new passengers
-        int randi = rand() % 10 + 1;
+        int randi = static_cast<int>(randomBelow(10)) + 1;
 
         for (int i = 0; i < randi; i++) {
-            std::weak_ptr<Interface::IStop> destinationStop = offlinedata_->stops.at( rand() % offlinedata_->stops.size() );
-            std::shared_ptr<Passenger> newPassenger = nullptr;
-            newPassenger = std::make_shared<Passenger>( destinationStop );
+            std::shared_ptr<Passenger> newPassenger = createPassenger();
 
             // add passengers for this stop
             newPassenger->enterStop( stop );
-            passengers_.push_back(newPassenger);
+            passengers_.add(newPassenger);
             stop->addPassenger(newPassenger);
-            cityif_->addActor(newPassenger);
+            newPassengers.push_back(newPassenger);
         }
     }
+    cityif_->addActors(newPassengers);
+    statistics_.passengersAdded(static_cast<int>(newPassengers.size()));
 }
 
-void Logic::addNewPassengers(std::shared_ptr<Stop> stop, unsigned int no)
+void Logic::addStopsToCity()
 {
+    passengers_.setStops(offlinedata_->stops);
+
+    std::vector<std::shared_ptr<Interface::IStop>> stops(offlinedata_->stops.begin(),
+                                                         offlinedata_->stops.end());
+    cityif_->addStops(stops);
+}
 
+void Logic::addNewPassengers(std::shared_ptr<Stop> stop, unsigned int no)
+{
+    std::vector<std::shared_ptr<Passenger>> newPassengers;
+    newPassengers.reserve(no);
     for(unsigned int i = 0; i < no; i++) {
         // new passenger
-        std::weak_ptr<Interface::IStop> destinationStop = offlinedata_->stops.at( rand() % offlinedata_->stops.size() );
-        std::shared_ptr<Passenger> newPassenger = nullptr;
-        newPassenger = std::make_shared<Passenger>( destinationStop );
+        std::shared_ptr<Passenger> newPassenger = createPassenger();
 
         // add into data structure
         newPassenger->enterStop(stop);
-        passengers_.push_back(newPassenger);
+        passengers_.add(newPassenger);
         stop->addPassenger(newPassenger);
-        cityif_->addActor(newPassenger);
+        newPassengers.push_back(newPassenger);
     }
+    cityif_->addActors({newPassengers.begin(), newPassengers.end()});
+    statistics_.passengersAdded(static_cast<int>(no));
+
+    // city knows the passengers before they can board
+    for (const std::shared_ptr<Passenger>& newPassenger : newPassengers) {
+        offerDwellingBuses(newPassenger, stop, nullptr);
+    }
+}
+
+std::shared_ptr<Passenger> Logic::createPassenger()
+{
+    std::weak_ptr<Interface::IStop> destinationStop = offlinedata_->stops.at(
+                randomBelow(static_cast<unsigned int>(offlinedata_->stops.size())));
+    return createPassenger(destinationStop);
+}
+
+unsigned int Logic::randomBelow(unsigned int bound)
+{
+    return static_cast<unsigned int>(random_() % bound);
+}
+
+std::shared_ptr<Passenger> Logic::createPassenger(std::weak_ptr<Interface::IStop> destination)
+{
+    return std::allocate_shared<Passenger>(PoolAllocator<Passenger>(pool_), destination);
+}
+
+bool Logic::saveSnapshot(QDataStream &out) const
+{
+    if (offlinedata_ == nullptr) {
+        return false;
+    }
+    out.setVersion(QDataStream::Qt_5_15);
+    out << SNAPSHOT_MAGIC << SNAPSHOT_VERSION;
+
+    // Sizes of the data tell when a snapshot is restored with other files
+    out << busfile_ << stopfile_
+        << static_cast<quint32>(offlinedata_->stops.size())
+        << static_cast<quint32>(offlinedata_->buses.size());
+    out << time_ << static_cast<qint64>(clock_) << static_cast<qint32>(busSID_) << debugstate_
+        << static_cast<quint64>(ticks_);
+
+    // The engine writes its state as text, which the standard specifies exactly
+    std::ostringstream random;
+    random << random_;
+    out << QByteArray::fromStdString(random.str());
+
+    // Buses are numbered in the order they are written, removed ones are left out
+    std::unordered_map<const Interface::IVehicle*, qint32> busIndices;
+    std::unordered_set<const Interface::IVehicle*> leavingBuses;
+    std::vector<SavedBus> buses;
+    for (const std::shared_ptr<Nysse>& bus : buses_) {
+        auto run = busRuns_.find(bus.get());
+        if (bus->isRemoved() || run == busRuns_.end() || run->second.pattern == TransitGraph::NONE) {
+            leavingBuses.insert(bus.get());
+            continue;
+        }
+        busIndices.insert({bus.get(), static_cast<qint32>(buses.size())});
+        buses.push_back(SavedBus{run->second.pattern, run->second.start, run->second.sid});
+    }
+    out << static_cast<quint32>(buses.size());
+    for (const SavedBus& bus : buses) {
+        out << bus.line << bus.start << bus.sid;
+    }
+
+    // Passengers are read from the columns of the table, passengers of removed buses
+    // are left out. A passenger anywhere else Logic can't place again fails the save
+    std::unordered_map<const Passenger*, qint32> passengerIndices;
+    std::vector<SavedPassenger> passengers;
+    passengers.reserve(passengers_.size());
+    for (std::size_t row = 0; row < passengers_.size(); ++row) {
+        if (passengers_.removed()[row]) {
+            continue;
+        }
+        qint32 stop = passengers_.stops()[row];
+        qint32 bus = PassengerTable::NO_STOP;
+        if (passengers_.vehicles()[row] != nullptr) {
+            auto found = busIndices.find(passengers_.vehicles()[row]);
+            if (found == busIndices.end()) {
+                if (leavingBuses.count(passengers_.vehicles()[row]) != 0) {
+                    continue;
+                }
+                qCWarning(courseLogic) << "Cannot save a passenger in a vehicle that is not a bus.";
+                return false;
+            }
+            bus = found->second;
+        } else if (stop == PassengerTable::NO_STOP) {
+            stop = gameStopIndex(passengers_.handles()[row]->getStop().get());
+            if (stop == PassengerTable::NO_STOP) {
+                qCWarning(courseLogic) << "Cannot save a passenger at a stop Logic doesn't know.";
+                return false;
+            }
+        }
+        passengerIndices.insert({passengers_.handles()[row].get(),
+                                 static_cast<qint32>(passengers.size())});
+        passengers.push_back(SavedPassenger{passengers_.destinations()[row], stop, bus});
+    }
+    out << static_cast<quint32>(passengers.size());
+    for (const SavedPassenger& passenger : passengers) {
+        out << passenger.destination << passenger.stop << passenger.bus;
+    }
+
+    // Decisions already made are saved, so restored buses don't draw them again.
+    // Arrivals of this tick not yet decided are decided after the restore
+    std::vector<SavedBoarding> boardings;
+    for (const BoardingSchedule::Event& event : boardings_.pending()) {
+        std::shared_ptr<Passenger> passenger = event.passenger.lock();
+        std::shared_ptr<Nysse> bus = event.bus.lock();
+        std::shared_ptr<Stop> stop = event.stop.lock();
+        if (passenger == nullptr || bus == nullptr || stop == nullptr) {
+            continue;
+        }
+        auto passengerIndex = passengerIndices.find(passenger.get());
+        auto busIndex = busIndices.find(bus.get());
+        qint32 stopIndex = passengers_.stopIndex(stop.get());
+        // Logic skips events whose passenger or bus is gone, they needn't be saved
+        if (passengerIndex == passengerIndices.end() || busIndex == busIndices.end() ||
+                stopIndex == PassengerTable::NO_STOP) {
+            continue;
+        }
+        boardings.push_back(SavedBoarding{event.time, static_cast<quint8>(event.kind),
+                                          passengerIndex->second, busIndex->second, stopIndex});
+    }
+    out << static_cast<quint32>(boardings.size());
+    for (const SavedBoarding& boarding : boardings) {
+        out << boarding.time << boarding.kind << boarding.passenger << boarding.bus << boarding.stop;
+    }
+
+    std::vector<qint32> arrivals;
+    for (const std::shared_ptr<Nysse>& bus : newArrivals_) {
+        auto found = busIndices.find(bus.get());
+        if (found != busIndices.end()) {
+            arrivals.push_back(found->second);
+        }
+    }
+    out << static_cast<quint32>(arrivals.size());
+    for (qint32 arrival : arrivals) {
+        out << arrival;
+    }
+    return out.status() == QDataStream::Ok;
+}
+
+bool Logic::restoreSnapshot(QDataStream &in)
+{
+    Q_ASSERT(!gamestarted_);
+    if (offlinedata_ == nullptr) {
+        return false;
+    }
+    in.setVersion(QDataStream::Qt_5_15);
+
+    quint32 magic = 0;
+    quint16 version = 0;
+    in >> magic >> version;
+    if (in.status() != QDataStream::Ok || magic != SNAPSHOT_MAGIC || version != SNAPSHOT_VERSION) {
+        qCWarning(courseLogic) << "Not a snapshot or a snapshot of another version.";
+        return false;
+    }
+
+    QString busfile;
+    QString stopfile;
+    quint32 stopCount = 0;
+    quint32 lineCount = 0;
+    in >> busfile >> stopfile >> stopCount >> lineCount;
+    if (stopCount != offlinedata_->stops.size() || lineCount != offlinedata_->buses.size()) {
+        qCWarning(courseLogic) << "Snapshot was taken with other data files:" << busfile << stopfile;
+        return false;
+    }
+
+    QTime time;
+    qint64 clock = 0;
+    qint32 busSID = 0;
+    bool debug = false;
+    quint64 ticks = 0;
+    QByteArray randomState;
+    in >> time >> clock >> busSID >> debug >> ticks >> randomState;
+
+    std::mt19937 random;
+    std::istringstream randomIn(randomState.toStdString());
+    if (!(randomIn >> random)) {
+        in.setStatus(QDataStream::ReadCorruptData);
+    }
+
+    // Everything is read and checked before the state is changed
+    quint32 busCount = 0;
+    in >> busCount;
+    std::vector<SavedBus> buses;
+    for (quint32 i = 0; i < busCount && in.status() == QDataStream::Ok; ++i) {
+        SavedBus bus;
+        in >> bus.line >> bus.start >> bus.sid;
+        if (bus.line < 0 || static_cast<quint32>(bus.line) >= lineCount) {
+            in.setStatus(QDataStream::ReadCorruptData);
+        }
+        buses.push_back(bus);
+    }
+
+    quint32 passengerCount = 0;
+    in >> passengerCount;
+    std::vector<SavedPassenger> passengers;
+    for (quint32 i = 0; i < passengerCount && in.status() == QDataStream::Ok; ++i) {
+        SavedPassenger passenger;
+        in >> passenger.destination >> passenger.stop >> passenger.bus;
+        bool atStop = passenger.stop >= 0 &&
+                static_cast<std::size_t>(passenger.stop) < stopCount + gameStops_.size();
+        bool inBus = passenger.bus >= 0 && static_cast<std::size_t>(passenger.bus) < buses.size();
+        if ((!atStop && !inBus) || passenger.destination < PassengerTable::NO_STOP ||
+                passenger.destination >= static_cast<qint32>(stopCount)) {
+            in.setStatus(QDataStream::ReadCorruptData);
+        }
+        passengers.push_back(passenger);
+    }
+
+    quint32 boardingCount = 0;
+    in >> boardingCount;
+    std::vector<SavedBoarding> boardings;
+    for (quint32 i = 0; i < boardingCount && in.status() == QDataStream::Ok; ++i) {
+        SavedBoarding boarding;
+        in >> boarding.time >> boarding.kind >> boarding.passenger >> boarding.bus >> boarding.stop;
+        if (boarding.kind > static_cast<quint8>(BoardingSchedule::Kind::ALIGHT) ||
+                boarding.passenger < 0 || static_cast<std::size_t>(boarding.passenger) >= passengers.size() ||
+                boarding.bus < 0 || static_cast<std::size_t>(boarding.bus) >= buses.size() ||
+                boarding.stop < 0 || static_cast<quint32>(boarding.stop) >= stopCount) {
+            in.setStatus(QDataStream::ReadCorruptData);
+        }
+        boardings.push_back(boarding);
+    }
+
+    quint32 arrivalCount = 0;
+    in >> arrivalCount;
+    std::vector<qint32> arrivals;
+    for (quint32 i = 0; i < arrivalCount && in.status() == QDataStream::Ok; ++i) {
+        qint32 arrival = 0;
+        in >> arrival;
+        if (arrival < 0 || static_cast<std::size_t>(arrival) >= buses.size()) {
+            in.setStatus(QDataStream::ReadCorruptData);
+        }
+        arrivals.push_back(arrival);
+    }
+
+    if (in.status() != QDataStream::Ok || !time.isValid()) {
+        qCWarning(courseLogic) << "Snapshot is truncated or corrupt.";
+        return false;
+    }
+
+    time_ = time;
+    clock_ = clock;
+    lastClockMsecs_ = time_.msecsSinceStartOfDay();
+    debugstate_ = debug;
+    ticks_ = ticks;
+
+    // Buses are placed on their routes at the restored time like in addBuses,
+    // decisions of the dwelling ones are restored below instead of made again
+    std::vector<std::shared_ptr<BusData>> lines(offlinedata_->buses.begin(),
+                                                offlinedata_->buses.end());
+    std::vector<std::shared_ptr<Nysse>> restoredBuses;
+    restoredBuses.reserve(buses.size());
+    for (const SavedBus& bus : buses) {
+        busSID_ = bus.sid;
+        restoredBuses.push_back(createBus(lines[bus.line], bus.start));
+    }
+    busSID_ = busSID;
+
+    addStopsToCity();
+
+    newArrivals_.clear();
+    for (qint32 arrival : arrivals) {
+        if (restoredBuses[arrival] != nullptr) {
+            newArrivals_.push_back(restoredBuses[arrival]);
+        }
+    }
+
+    std::vector<std::shared_ptr<Interface::IActor>> newPassengers;
+    newPassengers.reserve(passengers.size());
+    std::vector<std::shared_ptr<Passenger>> restoredPassengers(passengers.size());
+    for (std::size_t i = 0; i < passengers.size(); ++i) {
+        const SavedPassenger& saved = passengers[i];
+        std::shared_ptr<Passenger> passenger = saved.destination == PassengerTable::NO_STOP
+                ? createPassenger()
+                : createPassenger(offlinedata_->stops[saved.destination]);
+
+        if (saved.bus != PassengerTable::NO_STOP) {
+            std::shared_ptr<Nysse> bus = restoredBuses[saved.bus];
+            if (bus == nullptr) {
+                // Bus was at its final stop
+                continue;
+            }
+            passenger->enterNysse(bus);
+            bus->addPassenger(passenger);
+            passenger->move(bus->giveLocation());
+        } else {
+            std::shared_ptr<Stop> stop = static_cast<std::size_t>(saved.stop) < stopCount
+                    ? offlinedata_->stops[saved.stop]
+                    : gameStops_[saved.stop - stopCount];
+            passenger->enterStop(stop);
+            stop->addPassenger(passenger);
+        }
+        passengers_.add(passenger);
+        newPassengers.push_back(passenger);
+        restoredPassengers[i] = passenger;
+    }
+
+    // Saved in the order they are due, scheduling keeps the order
+    boardings_.clear();
+    for (const SavedBoarding& boarding : boardings) {
+        std::shared_ptr<Passenger> passenger = restoredPassengers[boarding.passenger];
+        std::shared_ptr<Nysse> bus = restoredBuses[boarding.bus];
+        if (passenger == nullptr || bus == nullptr) {
+            continue;
+        }
+        boardings_.schedule(static_cast<BoardingSchedule::Kind>(boarding.kind), boarding.time,
+                            passenger, bus, offlinedata_->stops[boarding.stop]);
+    }
+    cityif_->addActors(newPassengers);
+    statistics_.passengersAdded(static_cast<int>(newPassengers.size()));
+
+    // Passengers without a destination drew new ones above, the game continues
+    // from the numbers of the saved one
+    random_ = random;
+
+    startGame();
+    return true;
+}
+
+const PoolStatistics& Logic::allocationStatistics() const
+{
+    return pool_->statistics();
 }
 
 bool Logic::takeCity(std::shared_ptr<Interface::ICity> city) {
@@ -411,9 +1042,44 @@ bool Logic::takeCity(std::shared_ptr<Interface::ICity> city) {
     return true;
 }
 
+void Logic::addGameStop(std::shared_ptr<Stop> stop)
+{
+    gameStops_.push_back(stop);
+}
+
+std::int32_t Logic::gameStopIndex(const Interface::IStop* stop) const
+{
+    for (std::size_t i = 0; i < gameStops_.size(); ++i) {
+        if (gameStops_[i].get() == stop) {
+            return static_cast<std::int32_t>(offlinedata_->stops.size() + i);
+        }
+    }
+    return PassengerTable::NO_STOP;
+}
+
+void Logic::takeStatistics(Interface::IStatistics* statistics)
+{
+    statistics_.setSink(statistics);
+}
+
+void Logic::setSeed(unsigned int seed)
+{
+    random_.seed(seed);
+}
+
+std::uint64_t Logic::ticks() const
+{
+    return ticks_;
+}
+
 // ratio between real time and game time
 const int Logic::TIME_SPEED = 10;
 // time between updates in milliseconds
 const int Logic::UPDATE_INTERVAL_MS = 100;
+// game time between passengers using the same door
+const int Logic::DOOR_INTERVAL_MS = 500;
+// "NYSS" and the version of the snapshot format
+const quint32 Logic::SNAPSHOT_MAGIC = 0x4E595353;
+const quint16 Logic::SNAPSHOT_VERSION = 3;
 
 }
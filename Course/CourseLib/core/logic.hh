@@ -3,13 +3,26 @@
 
 #include "actors/passenger.hh"
 #include "actors/nysse.hh"
+#include "core/arrivaltable.hh"
+#include "core/boardingschedule.hh"
+#include "core/journeyplanner.hh"
+#include "core/passengertable.hh"
+#include "core/pool.hh"
+#include "core/statisticspolicy.hh"
+#include "core/transitgraph.hh"
 #include "offlinereader.hh"
 #include "interfaces/icity.hh"
+#include "interfaces/istatistics.hh"
 
 #include <list>
+#include <random>
+#include <unordered_map>
+#include <QFutureWatcher>
 #include <QTime>
 #include <QTimer>
 
+class QDataStream;
+
 /**
  * @file
  * @brief Defines a class that handles the courseside gamelogic
@@ -38,6 +51,11 @@ public:
      */
     Logic(QObject *parent = 0);
 
+    /**
+     * @brief Destructor waits for a load started by fileConfigAsync to finish
+     */
+    ~Logic();
+
     /**
      * @brief readOfflineData uses OfflineReader class to read given offlinedata-files
      * @param buses filepath for busfile
@@ -46,6 +64,13 @@ public:
      */
     bool readOfflineData(const QString& buses, const QString& stops);
 
+    /**
+     * @brief takeOfflineData sets data read by OfflineReader as the offlinedata of the game
+     * @param data read offlinedata
+     * @return true if data was given, else false
+     */
+    bool takeOfflineData(std::shared_ptr<OfflineData> data);
+
     /**
      * @brief finalizeGameStart calls to add buses, stops and passengers,
      * calls cityif_ to start the game and starts timer to update buses movement
@@ -60,6 +85,17 @@ public:
      */
     void fileConfig(QString stops = DEFAULT_STOPS_FILE, QString buses = DEFAULT_BUSES_FILE);
 
+    /**
+     * @brief fileConfigAsync reads offlinedata in a worker thread. Progress is told with
+     * loadingProgress and the end of reading with offlineDataLoaded
+     * @param stops datafile for stops, defaults to constant
+     * @param buses datafile for buses, defaults to constant
+     * @pre no other load is running
+     * @post offlinedata and its graphs are built in the worker and taken in the thread of
+     * Logic before offlineDataLoaded is emitted
+     */
+    void fileConfigAsync(QString stops = DEFAULT_STOPS_FILE, QString buses = DEFAULT_BUSES_FILE);
+
     /**
      * @brief setTime sets time_ to given time
      * @param hr time in hours
@@ -74,6 +110,79 @@ public:
      */
     bool takeCity(std::shared_ptr<Interface::ICity> city);
 
+    /**
+     * @brief takeStatistics sets the statistics that are told about buses and passengers.
+     * Events are delivered through StatisticsPolicy chosen when the library is built
+     * @param statistics statistics of the game, not owned, nullptr stops the events
+     * @pre statistics outlives the game or is replaced before it is deleted
+     */
+    void takeStatistics(Interface::IStatistics* statistics);
+
+    /**
+     * @brief addGameStop tells about a stop the game has outside the timetable, so that
+     * snapshots save and restore the passengers at it
+     * @param stop stop of the game
+     * @pre stops are added in the same order before saveSnapshot and restoreSnapshot
+     */
+    void addGameStop(std::shared_ptr<Stop> stop);
+
+    /**
+     * @brief setSeed seeds the random numbers of passengers, their stops and their
+     * decisions, so that the same seed and inputs give the same game
+     * @param seed seed of the random engine of the game
+     * @pre called before finalizeGameStart
+     */
+    void setSeed(unsigned int seed);
+
+    /**
+     * @brief ticks tells how many times increaseTime has advanced the game
+     * @return number of ticks since the start of the game
+     */
+    std::uint64_t ticks() const;
+
+    /**
+     * @brief allocationStatistics tells how passengers and buses have been allocated.
+     * @return counters of the pool passengers and buses are allocated from
+     */
+    const PoolStatistics& allocationStatistics() const;
+
+    /**
+     * @brief saveSnapshot writes the state of the simulation to a compact binary snapshot:
+     * time, ticks, state of the random engine, buses in traffic by their line and
+     * departure, passengers by their stop or bus and destination, and the boardings and
+     * alightings already decided
+     * @param out stream the snapshot is written to
+     * @pre offlinedata is read
+     * @return true if the snapshot was written, false if it couldn't be written or a
+     * passenger is in a vehicle or at a stop that isn't a bus or a stop known to Logic
+     */
+    bool saveSnapshot(QDataStream& out) const;
+
+    /**
+     * @brief restoreSnapshot starts the game from a snapshot instead of finalizeGameStart.
+     * Buses, stops and passengers are given to cityif_ as when the game was started
+     * @param in stream to read a snapshot written by saveSnapshot from
+     * @pre takeCity and fileConfig must be called with the data files of the snapshot,
+     * game is not started
+     * @return true if the game was started from the snapshot, false if the snapshot is
+     * not valid or was taken with other data files. Nothing is changed on false
+     */
+    bool restoreSnapshot(QDataStream& in);
+
+signals:
+
+    /**
+     * @brief loadingProgress tells how far fileConfigAsync has read
+     * @param percent share of the load done in percents, grows until it is 100 at the end
+     */
+    void loadingProgress(int percent);
+
+    /**
+     * @brief offlineDataLoaded is emitted when fileConfigAsync has finished
+     * @param success true if data files were read correctly, else false
+     */
+    void offlineDataLoaded(bool success);
+
 public slots:
 
     /**
@@ -112,12 +221,62 @@ private:
     static const int TIME_SPEED;
     // time between updates in milliseconds
     static const int UPDATE_INTERVAL_MS;
+    // game time between passengers using the same door
+    static const int DOOR_INTERVAL_MS;
+    // Identifies the format of saveSnapshot
+    static const quint32 SNAPSHOT_MAGIC;
+    static const quint16 SNAPSHOT_VERSION;
+
+    // How a bus in traffic was created
+    struct BusRun
+    {
+        // Pattern in transit_, also the index of the line in offlinedata_->buses
+        std::int32_t pattern;
+        // Run in planner_, NONE if the timetable has no such run
+        std::int32_t trip;
+        QTime start;
+        int sid;
+        unsigned int line;
+    };
 
     std::shared_ptr<Interface::ICity> cityif_;
-    std::list< std::shared_ptr<Passenger> > passengers_;
+    // Passengers and buses are allocated from pool_, objects keep it alive
+    std::shared_ptr<Pool> pool_;
+    // Passenger state in columns, rows are in no particular order
+    PassengerTable passengers_;
     std::list< std::shared_ptr<Nysse> > buses_;
+    // Stop sequences of the lines, built when offline data is read
+    TransitGraph transit_;
+    // Timetables of the lines, built when offline data is read
+    JourneyPlanner planner_;
+    // Line and departure of each bus in traffic
+    std::unordered_map<const Nysse*, BusRun> busRuns_;
+    // Buses dwelling at stops, updated as buses move
+    ArrivalTable arrivals_;
+    // Buses that arrived at a stop during this advance, not yet scheduled
+    std::vector<std::shared_ptr<Nysse>> newArrivals_;
+    // Boardings and alightings decided at arrivals
+    BoardingSchedule boardings_;
+    // Delivers events to the statistics of the game
+    StatisticsPolicy statistics_;
+    // Game time in milliseconds that keeps increasing over midnight
+    std::int64_t clock_;
+    int lastClockMsecs_;
     std::vector< std::shared_ptr<Stop> > stops_;
+    // Stops of the game outside the timetable, see addGameStop
+    std::vector< std::shared_ptr<Stop> > gameStops_;
     std::shared_ptr<OfflineData> offlinedata_;
+    // Offline data and the graphs built from it in the worker of fileConfigAsync
+    struct LoadedData
+    {
+        std::shared_ptr<OfflineData> data;
+        TransitGraph transit;
+        JourneyPlanner planner;
+    };
+    // Load started by fileConfigAsync
+    QFutureWatcher<std::shared_ptr<LoadedData>> loader_;
+    QString loadingBusfile_;
+    QString loadingStopfile_;
     QString busfile_;
     QString stopfile_;
     bool debugstate_;
@@ -145,14 +304,67 @@ private:
     // Adds stops to the city and passengers to the stops, called by finalizeGameStart
     void addStopsAndPassengers();
 
+    // Gives all stops to the city, once when the game is started
+    void addStopsToCity();
+
+    // Starts the game in the city and the timer, after buses and passengers are added
+    void startGame();
+
     // Calculates stop times based on departure times and time spent at stop
     std::map<QTime, std::weak_ptr<Stop>> calculateStopTimes(std::map<QTime, std::shared_ptr<Stop>>& stops, QTime& departure_time);
 
     // Creates bus and adds it to traffic, gives the bus to cityif_, called by methods
-    // to create a bus
-    void createBus(std::shared_ptr<BusData> bus, QTime departure_time);
+    // to create a bus. Returns nullptr if the bus is already at its final stop
+    std::shared_ptr<Nysse> createBus(std::shared_ptr<BusData> bus, QTime departure_time);
+
+    // Updates the stop of a moved or created bus in arrivals_
+    void updateArrival(const std::shared_ptr<Nysse>& bus);
+
+    // Samples once the decisions of passengers on the arrived bus and at its stop
+    // and schedules them, staggered by DOOR_INTERVAL_MS
+    void scheduleBoarding(const std::shared_ptr<Nysse>& bus);
+
+    // Boarding and alighting decisions. A passenger stays on or boards the run that is first
+    // on its fastest journey in planner_. If the timetable cannot tell, buses that take
+    // fewer rides in transit_ are taken, and otherwise a coin is flipped with random_
+    bool wantsToBoard(const std::shared_ptr<Passenger>& passenger,
+                      const std::shared_ptr<Nysse>& bus, const std::shared_ptr<Stop>& stop);
+    bool wantsToAlight(const std::shared_ptr<Passenger>& passenger,
+                       const std::shared_ptr<Nysse>& bus, const std::shared_ptr<Stop>& stop);
+
+    // Samples the decision of a passenger that entered a stop for the buses dwelling there
+    void offerDwellingBuses(const std::shared_ptr<Passenger>& passenger,
+                            const std::shared_ptr<Stop>& stop, const Nysse* except);
+
+    // Carries out the scheduled events that are due and still possible
+    void runBoardings();
+
+    // Run boarded first on the fastest journey from stop when bus leaves it,
+    // NONE if planner_ cannot tell
+    std::int32_t plannedTrip(const Nysse* bus, std::int32_t stop, std::int32_t destination) const;
+
+    // Snapshot number of a stop given with addGameStop, NO_STOP if it wasn't given
+    std::int32_t gameStopIndex(const Interface::IStop* stop) const;
+
+    // Line of a bus in traffic, 0 if the bus is not known
+    unsigned int lineOf(const Nysse* bus) const;
+
+    // Tells statistics the waiting passengers and bus loads once a minute, if the policy samples
+    void sampleStatistics();
+
+    // Random number in [0, bound) from random_. Modulo instead of a distribution, whose
+    // results differ between standard libraries, so snapshots and replays are portable
+    unsigned int randomBelow(unsigned int bound);
+
+    // Creates a passenger from pool_, headed to a random stop
+    std::shared_ptr<Passenger> createPassenger();
+    // Creates a passenger from pool_, headed to the given stop
+    std::shared_ptr<Passenger> createPassenger(std::weak_ptr<Interface::IStop> destination);
 
     int busSID_;
+    std::uint64_t ticks_;
+    // All random numbers of the game, saved in snapshots
+    std::mt19937 random_;
 };
 
 }
@@ -0,0 +1,157 @@
+#include "core/passengertable.hh"
+#include "actors/passenger.hh"
+#include "actors/stop.hh"
+
+#include <QtGlobal>
+
+namespace CourseSide
+{
+
+namespace
+{
+
+// Doubles the capacity of a full column so that appending rows stays amortised O(1)
+template <typename T>
+void reserveRow(std::vector<T>& column)
+{
+    if (column.size() == column.capacity()) {
+        column.reserve(2 * column.size() + 1);
+    }
+}
+
+}
+
+const std::int32_t PassengerTable::NO_STOP;
+
+PassengerTable::PassengerTable()
+{
+}
+
+PassengerTable::~PassengerTable()
+{
+    for (const std::shared_ptr<Passenger>& passenger : handles_) {
+        passenger->table_ = nullptr;
+    }
+}
+
+void PassengerTable::setStops(const std::vector<std::shared_ptr<Stop>>& stops)
+{
+    stopIndices_.clear();
+    stopIndices_.reserve(stops.size());
+    for (std::size_t i = 0; i < stops.size(); ++i) {
+        stopIndices_.insert({stops[i].get(), static_cast<std::int32_t>(i)});
+    }
+}
+
+std::int32_t PassengerTable::stopIndex(const Interface::IStop* stop) const
+{
+    auto found = stopIndices_.find(stop);
+    if (found == stopIndices_.end()) {
+        return NO_STOP;
+    }
+    return found->second;
+}
+
+void PassengerTable::add(const std::shared_ptr<Passenger>& passenger)
+{
+    Q_ASSERT(passenger->table_ == nullptr);
+
+    std::size_t row = handles_.size();
+    reserveRow(handles_);
+    reserveRow(stops_);
+    reserveRow(vehicles_);
+    reserveRow(destinations_);
+    reserveRow(removed_);
+
+    // Nothing throws after the reservations
+    handles_.push_back(passenger);
+    stops_.push_back(stopIndex(passenger->stopp_.lock().get()));
+    vehicles_.push_back(passenger->nyssep_.lock().get());
+    destinations_.push_back(stopIndex(passenger->destination_.lock().get()));
+    removed_.push_back(passenger->removed_);
+
+    passenger->table_ = this;
+    passenger->row_ = row;
+}
+
+void PassengerTable::erase(const Passenger& passenger)
+{
+    if (passenger.table_ == this) {
+        erase(passenger.row_);
+    }
+}
+
+void PassengerTable::erase(std::size_t row)
+{
+    Q_ASSERT(row < handles_.size());
+    handles_[row]->table_ = nullptr;
+
+    std::size_t last = handles_.size() - 1;
+    if (row != last) {
+        handles_[row] = std::move(handles_[last]);
+        stops_[row] = stops_[last];
+        vehicles_[row] = vehicles_[last];
+        destinations_[row] = destinations_[last];
+        removed_[row] = removed_[last];
+        handles_[row]->row_ = row;
+    }
+    handles_.pop_back();
+    stops_.pop_back();
+    vehicles_.pop_back();
+    destinations_.pop_back();
+    removed_.pop_back();
+}
+
+std::size_t PassengerTable::size() const
+{
+    return handles_.size();
+}
+
+std::int32_t PassengerTable::destinationOf(const Passenger& passenger) const
+{
+    return passenger.table_ == this ? destinations_[passenger.row_] : NO_STOP;
+}
+
+const std::vector<std::shared_ptr<Passenger>>& PassengerTable::handles() const
+{
+    return handles_;
+}
+
+const std::vector<std::int32_t>& PassengerTable::stops() const
+{
+    return stops_;
+}
+
+const std::vector<const Interface::IVehicle*>& PassengerTable::vehicles() const
+{
+    return vehicles_;
+}
+
+const std::vector<std::int32_t>& PassengerTable::destinations() const
+{
+    return destinations_;
+}
+
+const std::vector<std::uint8_t>& PassengerTable::removed() const
+{
+    return removed_;
+}
+
+void PassengerTable::setStop(std::size_t row, const Interface::IStop* stop)
+{
+    stops_[row] = stopIndex(stop);
+    vehicles_[row] = nullptr;
+}
+
+void PassengerTable::setVehicle(std::size_t row, const Interface::IVehicle* vehicle)
+{
+    stops_[row] = NO_STOP;
+    vehicles_[row] = vehicle;
+}
+
+void PassengerTable::setRemoved(std::size_t row)
+{
+    removed_[row] = 1;
+}
+
+}
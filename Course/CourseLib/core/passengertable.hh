@@ -0,0 +1,127 @@
+#ifndef PASSENGERTABLE_HH
+#define PASSENGERTABLE_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @file
+ * @brief Defines a structure-of-arrays table of the passenger state kept by Logic.
+ */
+
+
+namespace Interface
+{
+class IStop;
+class IVehicle;
+}
+
+namespace CourseSide
+{
+
+class Passenger;
+class Stop;
+
+/**
+ * @brief PassengerTable keeps the state of passengers in separate contiguous columns.
+ *
+ * Row i of each column belongs to the same passenger. Passenger objects stay as the
+ * Interface::IPassenger adapters for the game side; a passenger added to the table writes
+ * every change of its state through to its row. Rows are removed by moving the last row
+ * into their place, so walking the table backwards while removing visits every row once.
+ */
+class PassengerTable
+{
+public:
+    // Stop index of a passenger that is in a vehicle or at a stop not known to the table
+    static const std::int32_t NO_STOP = -1;
+
+    PassengerTable();
+
+    /**
+     * @brief Destructor detaches the remaining passengers from the table.
+     */
+    ~PassengerTable();
+
+    PassengerTable(const PassengerTable&) = delete;
+    PassengerTable& operator=(const PassengerTable&) = delete;
+
+    /**
+     * @brief setStops gives the stops whose positions in stops are used as stop indices.
+     * @param stops stops known to the table
+     * @post Stop and destination indices of present rows are not updated.
+     * Exception guarantee: basic.
+     */
+    void setStops(const std::vector<std::shared_ptr<Stop>>& stops);
+
+    /**
+     * @brief stopIndex tells the index of the given stop.
+     * @param stop stop to look up
+     * @return index of stop, NO_STOP if the stop is not known
+     * @post Exception guarantee: nothrow.
+     */
+    std::int32_t stopIndex(const Interface::IStop* stop) const;
+
+    /**
+     * @brief add adds a row for the passenger, filled from its current state.
+     * @param passenger passenger to be added
+     * @pre passenger is not in any table.
+     * @post Passenger writes its state through to the table. Exception guarantee: strong.
+     */
+    void add(const std::shared_ptr<Passenger>& passenger);
+
+    /**
+     * @brief erase removes the row of the passenger, if it is in this table.
+     * @param passenger passenger to be removed
+     * @post Last row has moved into the place of the removed one. Exception guarantee: nothrow.
+     */
+    void erase(const Passenger& passenger);
+
+    /**
+     * @brief erase removes the given row.
+     * @param row row to be removed
+     * @pre row < size()
+     * @post Last row has moved into the place of the removed one. Exception guarantee: nothrow.
+     */
+    void erase(std::size_t row);
+
+    std::size_t size() const;
+
+    /**
+     * @brief destinationOf tells the destination stop index of the passenger.
+     * @param passenger passenger to look up
+     * @return destination index, NO_STOP if the passenger is not in this table
+     * @post Exception guarantee: nothrow.
+     */
+    std::int32_t destinationOf(const Passenger& passenger) const;
+
+    // Columns, element i of each belongs to the passenger at row i
+    const std::vector<std::shared_ptr<Passenger>>& handles() const;
+    const std::vector<std::int32_t>& stops() const;
+    const std::vector<const Interface::IVehicle*>& vehicles() const;
+    const std::vector<std::int32_t>& destinations() const;
+    const std::vector<std::uint8_t>& removed() const;
+
+private:
+    friend class Passenger;
+
+    // Write-through from Passenger
+    void setStop(std::size_t row, const Interface::IStop* stop);
+    void setVehicle(std::size_t row, const Interface::IVehicle* vehicle);
+    void setRemoved(std::size_t row);
+
+    std::vector<std::shared_ptr<Passenger>> handles_;
+    std::vector<std::int32_t> stops_;
+    std::vector<const Interface::IVehicle*> vehicles_;
+    std::vector<std::int32_t> destinations_;
+    std::vector<std::uint8_t> removed_;
+
+    std::unordered_map<const Interface::IStop*, std::int32_t> stopIndices_;
+};
+
+}
+
+#endif // PASSENGERTABLE_HH
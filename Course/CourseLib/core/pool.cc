@@ -0,0 +1,89 @@
+#include "core/pool.hh"
+
+#include <new>
+
+namespace CourseSide
+{
+
+const std::size_t Pool::ALIGNMENT;
+const std::size_t Pool::MAX_BLOCK;
+const std::size_t Pool::SLAB_SIZE;
+
+Pool::Pool() : cursor_(nullptr), end_(nullptr)
+{
+    freeLists_.fill(nullptr);
+}
+
+Pool::~Pool()
+{
+    for (void* slab : slabs_) {
+        ::operator delete(slab);
+    }
+}
+
+void* Pool::allocate(std::size_t size)
+{
+    if (size == 0) {
+        size = 1;
+    }
+    if (size > MAX_BLOCK) {
+        void* block = ::operator new(size);
+        ++statistics_.allocations;
+        ++statistics_.fallbacks;
+        return block;
+    }
+
+    std::size_t sizeClass = (size - 1) / ALIGNMENT;
+    FreeBlock*& freeList = freeLists_[sizeClass];
+    if (freeList != nullptr) {
+        FreeBlock* block = freeList;
+        freeList = block->next;
+        ++statistics_.allocations;
+        ++statistics_.reuses;
+        return block;
+    }
+
+    std::size_t blockSize = (sizeClass + 1) * ALIGNMENT;
+    if (static_cast<std::size_t>(end_ - cursor_) < blockSize) {
+        // The rest of the current slab is left unused
+        slabs_.reserve(slabs_.size() + 1);
+        char* slab = static_cast<char*>(::operator new(SLAB_SIZE));
+        slabs_.push_back(slab);
+        cursor_ = slab;
+        end_ = slab + SLAB_SIZE;
+        ++statistics_.slabs;
+        statistics_.reservedBytes += SLAB_SIZE;
+    }
+
+    void* block = cursor_;
+    cursor_ += blockSize;
+    ++statistics_.allocations;
+    return block;
+}
+
+void Pool::deallocate(void* block, std::size_t size) noexcept
+{
+    if (block == nullptr) {
+        return;
+    }
+    ++statistics_.deallocations;
+    if (size == 0) {
+        size = 1;
+    }
+    if (size > MAX_BLOCK) {
+        ::operator delete(block);
+        return;
+    }
+
+    FreeBlock* freed = static_cast<FreeBlock*>(block);
+    FreeBlock*& freeList = freeLists_[(size - 1) / ALIGNMENT];
+    freed->next = freeList;
+    freeList = freed;
+}
+
+const PoolStatistics& Pool::statistics() const
+{
+    return statistics_;
+}
+
+}
@@ -0,0 +1,160 @@
+#ifndef POOL_HH
+#define POOL_HH
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/**
+ * @file
+ * @brief Defines a slab pool for the actors of a simulation and an allocator that uses it.
+ */
+
+
+namespace CourseSide
+{
+
+/**
+ * @brief PoolStatistics tells how a Pool has been used.
+ */
+struct PoolStatistics
+{
+    // Blocks handed out and given back
+    std::size_t allocations = 0;
+    std::size_t deallocations = 0;
+    // Allocations that were served from the free lists
+    std::size_t reuses = 0;
+    // Allocations too large for the pool, served by the general heap
+    std::size_t fallbacks = 0;
+    // Slabs taken from the general heap and their total size
+    std::size_t slabs = 0;
+    std::size_t reservedBytes = 0;
+
+    std::size_t live() const
+    {
+        return allocations - deallocations;
+    }
+};
+
+/**
+ * @brief Pool hands out small blocks carved from large slabs.
+ *
+ * Block sizes are rounded up to size classes of ALIGNMENT bytes. A freed block goes to the
+ * free list of its class and is handed out again before new memory is carved, so an
+ * allocation is a free list pop or a pointer bump, and a deallocation is a free list push.
+ * Memory returns to the general heap only when the pool is destroyed.
+ *
+ * The pool is not thread safe.
+ */
+class Pool
+{
+public:
+    // Alignment of every block, and the granularity of the size classes
+    static const std::size_t ALIGNMENT = alignof(std::max_align_t);
+    // Largest block served from the slabs
+    static const std::size_t MAX_BLOCK = 512;
+    // Size of the slabs taken from the general heap
+    static const std::size_t SLAB_SIZE = 64 * 1024;
+
+    Pool();
+    ~Pool();
+
+    Pool(const Pool&) = delete;
+    Pool& operator=(const Pool&) = delete;
+
+    /**
+     * @brief allocate returns a block of at least the given size.
+     * @param size size of the block in bytes
+     * @return Block aligned to ALIGNMENT.
+     * @post Exception guarantee: strong.
+     * @exception std::bad_alloc A new slab could not be allocated.
+     */
+    void* allocate(std::size_t size);
+
+    /**
+     * @brief deallocate gives a block back to the pool.
+     * @param block block returned by allocate
+     * @param size the size given to allocate
+     * @post Exception guarantee: nothrow.
+     */
+    void deallocate(void* block, std::size_t size) noexcept;
+
+    /**
+     * @brief statistics returns the allocation counters of the pool.
+     * @return Counters since the pool was created.
+     * @post Exception guarantee: nothrow.
+     */
+    const PoolStatistics& statistics() const;
+
+private:
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    static const std::size_t CLASSES = MAX_BLOCK / ALIGNMENT;
+
+    std::array<FreeBlock*, CLASSES> freeLists_;
+    std::vector<void*> slabs_;
+    char* cursor_;
+    char* end_;
+    PoolStatistics statistics_;
+};
+
+
+/**
+ * @brief PoolAllocator is a standard allocator that takes its memory from a shared Pool.
+ *
+ * Intended for std::allocate_shared. The allocator is stored in the control block of the
+ * object, so the pool lives until the last object allocated from it has been freed.
+ */
+template <typename T>
+class PoolAllocator
+{
+public:
+    using value_type = T;
+
+    explicit PoolAllocator(std::shared_ptr<Pool> pool) : pool_(std::move(pool))
+    {
+    }
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>& other) : pool_(other.pool())
+    {
+    }
+
+    T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(pool_->allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* block, std::size_t n) noexcept
+    {
+        pool_->deallocate(block, n * sizeof(T));
+    }
+
+    const std::shared_ptr<Pool>& pool() const
+    {
+        return pool_;
+    }
+
+private:
+    std::shared_ptr<Pool> pool_;
+};
+
+template <typename T, typename U>
+bool operator==(const PoolAllocator<T>& a, const PoolAllocator<U>& b)
+{
+    return a.pool() == b.pool();
+}
+
+template <typename T, typename U>
+bool operator!=(const PoolAllocator<T>& a, const PoolAllocator<U>& b)
+{
+    return !(a == b);
+}
+
+}
+
+#endif // POOL_HH
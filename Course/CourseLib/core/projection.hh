@@ -0,0 +1,76 @@
+#ifndef PROJECTION_HH
+#define PROJECTION_HH
+
+#include <cstddef>
+
+/**
+  * @file
+  * @brief Defines compile-time transforms between map coordinates and pixel coordinates of a map image.
+  */
+
+namespace Interface
+{
+
+/**
+ * @brief Projection transforms KKJ3 map coordinates to pixel coordinates of a map image and back.
+ *
+ * All constants are template parameters, so single transforms are constexpr and inline to a
+ * subtraction and a multiply. The batch versions work on contiguous arrays and are simple
+ * enough for the compiler to vectorize.
+ *
+ * @tparam EAST eastern coordinate of the bottom left corner of the map
+ * @tparam NORTH northern coordinate of the bottom left corner of the map
+ * @tparam SCALE_MICROS pixels per metre, in millionths
+ */
+template <int EAST, int NORTH, int SCALE_MICROS>
+struct Projection
+{
+    static constexpr double scale()
+    {
+        return SCALE_MICROS / 1000000.0;
+    }
+
+    static constexpr int xFromEast(double east)
+    {
+        return static_cast<int>((east - EAST) * scale());
+    }
+
+    static constexpr int yFromNorth(double north)
+    {
+        return static_cast<int>((north - NORTH) * scale());
+    }
+
+    static constexpr double eastFromX(int x)
+    {
+        return x / scale() + EAST;
+    }
+
+    static constexpr double northFromY(int y)
+    {
+        return y / scale() + NORTH;
+    }
+
+    static void xFromEast(const double* east, int* x, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i) {
+            x[i] = xFromEast(east[i]);
+        }
+    }
+
+    static void yFromNorth(const double* north, int* y, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i) {
+            y[i] = yFromNorth(north[i]);
+        }
+    }
+};
+
+// Small map of the course, 500x500 pixels covering 1500x1500 metres
+using SmallMapProjection = Projection<3327034, 6824642, 333333>;
+
+// Map of the game, 1013x570 pixels
+using GameMapProjection = Projection<3326932, 6824973, 711805>;
+
+}
+
+#endif // PROJECTION_HH
@@ -0,0 +1,147 @@
+#include "core/statisticspolicy.hh"
+#include "core/trace.hh"
+#include "interfaces/istatistics.hh"
+
+namespace CourseSide
+{
+
+const bool NoStatistics::SAMPLES;
+const bool BatchedStatistics::SAMPLES;
+const bool TracingStatistics::SAMPLES;
+const bool NoStatistics::EVENTS;
+const bool BatchedStatistics::EVENTS;
+const bool TracingStatistics::EVENTS;
+
+BatchedStatistics::BatchedStatistics()
+    : sink_(nullptr),
+      busesAdded_(0),
+      busesLeft_(0),
+      passengersAdded_(0)
+{
+}
+
+void BatchedStatistics::waiting(unsigned int stopId, int num)
+{
+    if (sink_ != nullptr) {
+        sink_->passengersWaiting(stopId, num);
+    }
+}
+
+void BatchedStatistics::load(unsigned int line, int num)
+{
+    if (sink_ != nullptr) {
+        sink_->busLoad(line, num);
+    }
+}
+
+void BatchedStatistics::minutePassed()
+{
+    flush();
+    if (sink_ != nullptr) {
+        sink_->minutePassed();
+    }
+}
+
+void BatchedStatistics::flush()
+{
+    if (sink_ != nullptr) {
+        if (busesAdded_ > 0) {
+            sink_->nyssesAdded(busesAdded_);
+        }
+        if (busesLeft_ > 0) {
+            sink_->nyssesLeft(busesLeft_);
+        }
+        if (passengersAdded_ > 0) {
+            sink_->morePassengers(passengersAdded_);
+        }
+        for (const auto& line : boardings_) {
+            sink_->passengersBoarded(line.first, line.second);
+        }
+        for (const auto& line : alightings_) {
+            sink_->passengersAlighted(line.first, line.second);
+        }
+    }
+    busesAdded_ = 0;
+    busesLeft_ = 0;
+    passengersAdded_ = 0;
+    // Capacity is kept, later ticks do not allocate
+    boardings_.clear();
+    alightings_.clear();
+}
+
+void BatchedStatistics::count(LineCounts& counts, unsigned int line)
+{
+    for (auto& count : counts) {
+        if (count.first == line) {
+            ++count.second;
+            return;
+        }
+    }
+    counts.push_back({line, 1});
+}
+
+TracingStatistics::TracingStatistics()
+    : sink_(nullptr)
+{
+}
+
+void TracingStatistics::busAdded()
+{
+    if (sink_ != nullptr) {
+        sink_->newNysse();
+    }
+}
+
+void TracingStatistics::busLeft()
+{
+    if (sink_ != nullptr) {
+        sink_->nysseLeft();
+    }
+}
+
+void TracingStatistics::passengersAdded(int num)
+{
+    COURSE_TRACE(Trace::Event::PASSENGERS_ADDED, num, 0);
+    if (sink_ != nullptr && num > 0) {
+        sink_->morePassengers(num);
+    }
+}
+
+void TracingStatistics::boarded(unsigned int line)
+{
+    COURSE_TRACE(Trace::Event::PASSENGER_BOARDED, static_cast<std::int32_t>(line), 0);
+    if (sink_ != nullptr) {
+        sink_->passengerBoarded(line);
+    }
+}
+
+void TracingStatistics::alighted(unsigned int line)
+{
+    COURSE_TRACE(Trace::Event::PASSENGER_ALIGHTED, static_cast<std::int32_t>(line), 0);
+    if (sink_ != nullptr) {
+        sink_->passengerAlighted(line);
+    }
+}
+
+void TracingStatistics::waiting(unsigned int stopId, int num)
+{
+    if (sink_ != nullptr) {
+        sink_->passengersWaiting(stopId, num);
+    }
+}
+
+void TracingStatistics::load(unsigned int line, int num)
+{
+    if (sink_ != nullptr) {
+        sink_->busLoad(line, num);
+    }
+}
+
+void TracingStatistics::minutePassed()
+{
+    if (sink_ != nullptr) {
+        sink_->minutePassed();
+    }
+}
+
+}
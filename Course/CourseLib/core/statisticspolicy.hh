@@ -0,0 +1,166 @@
+#ifndef STATISTICSPOLICY_HH
+#define STATISTICSPOLICY_HH
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/**
+ * @file
+ * @brief Defines the policies Logic uses to tell an IStatistics about the simulation.
+ *
+ * The policy is chosen when the library is built, see statistics.pri:
+ * - NoStatistics with CONFIG+=nostatistics,
+ * - TracingStatistics with CONFIG+=tracestatistics,
+ * - BatchedStatistics otherwise.
+ *
+ * All policies have the same member functions, so Logic calls them unconditionally. Samples
+ * of stops and buses are taken only when SAMPLES of the policy is true, and events whose
+ * line has to be looked up are told only when EVENTS is true.
+ */
+
+
+namespace Interface
+{
+class IStatistics;
+}
+
+namespace CourseSide
+{
+
+/**
+ * @brief NoStatistics does nothing. Its calls are inlined away, statistics cost nothing.
+ */
+class NoStatistics
+{
+public:
+    static const bool SAMPLES = false;
+    static const bool EVENTS = false;
+
+    void setSink(Interface::IStatistics*) {}
+    void busAdded() {}
+    void busLeft() {}
+    void passengersAdded(int) {}
+    void boarded(unsigned int) {}
+    void alighted(unsigned int) {}
+    void waiting(unsigned int, int) {}
+    void load(unsigned int, int) {}
+    void minutePassed() {}
+    void flush() {}
+};
+
+/**
+ * @brief BatchedStatistics counts the events of a tick and gives them to the sink in flush.
+ *
+ * Event calls only increment counters, so the boarding and removal loops of Logic make no
+ * virtual calls. A flush makes one call for each counter and line that has events. Samples are taken once a minute and are given to the sink directly.
+ */
+class BatchedStatistics
+{
+public:
+    static const bool SAMPLES = true;
+    static const bool EVENTS = true;
+
+    BatchedStatistics();
+
+    void setSink(Interface::IStatistics* sink)
+    {
+        sink_ = sink;
+    }
+
+    void busAdded()
+    {
+        ++busesAdded_;
+    }
+
+    void busLeft()
+    {
+        ++busesLeft_;
+    }
+
+    void passengersAdded(int num)
+    {
+        passengersAdded_ += num;
+    }
+
+    void boarded(unsigned int line)
+    {
+        count(boardings_, line);
+    }
+
+    void alighted(unsigned int line)
+    {
+        count(alightings_, line);
+    }
+
+    void waiting(unsigned int stopId, int num);
+    void load(unsigned int line, int num);
+
+    /**
+     * @brief minutePassed flushes the counted events and closes the minute of the sink.
+     * @post Exception guarantee: nothrow.
+     */
+    void minutePassed();
+
+    /**
+     * @brief flush gives the counted events to the sink, called at the end of every tick.
+     * @post Counters are reset. Exception guarantee: nothrow.
+     */
+    void flush();
+
+private:
+    // Lines with events in a tick are few, a flat vector is searched
+    using LineCounts = std::vector<std::pair<unsigned int, int>>;
+
+    static void count(LineCounts& counts, unsigned int line);
+
+    Interface::IStatistics* sink_;
+    int busesAdded_;
+    int busesLeft_;
+    int passengersAdded_;
+    LineCounts boardings_;
+    LineCounts alightings_;
+};
+
+/**
+ * @brief TracingStatistics gives every event to the sink as it happens and records it with
+ * COURSE_TRACE. Meant for debugging the statistics, not for speed.
+ */
+class TracingStatistics
+{
+public:
+    static const bool SAMPLES = true;
+    static const bool EVENTS = true;
+
+    TracingStatistics();
+
+    void setSink(Interface::IStatistics* sink)
+    {
+        sink_ = sink;
+    }
+
+    void busAdded();
+    void busLeft();
+    void passengersAdded(int num);
+    void boarded(unsigned int line);
+    void alighted(unsigned int line);
+    void waiting(unsigned int stopId, int num);
+    void load(unsigned int line, int num);
+    void minutePassed();
+    void flush() {}
+
+private:
+    Interface::IStatistics* sink_;
+};
+
+#if defined(COURSE_STATISTICS_NONE)
+using StatisticsPolicy = NoStatistics;
+#elif defined(COURSE_STATISTICS_TRACE)
+using StatisticsPolicy = TracingStatistics;
+#else
+using StatisticsPolicy = BatchedStatistics;
+#endif
+
+}
+
+#endif // STATISTICSPOLICY_HH
@@ -0,0 +1,171 @@
+#include "core/trace.hh"
+
+#include <QDataStream>
+#include <QFile>
+#include <QTime>
+
+#include <array>
+
+Q_LOGGING_CATEGORY(courseLogic, "nysse.logic", QtWarningMsg)
+Q_LOGGING_CATEGORY(nysseGame, "nysse.game", QtWarningMsg)
+
+
+namespace CourseSide
+{
+
+namespace Trace
+{
+
+namespace
+{
+
+// Identifies binary trace files
+const quint32 MAGIC = 0x4e545243; // "NTRC"
+const quint16 VERSION = 1;
+
+std::array<Record, CAPACITY> ring;
+// Total number of records pushed, next write position is count % CAPACITY
+std::size_t count = 0;
+std::int32_t clock = 0;
+
+const char* eventName(Event event)
+{
+    switch (event) {
+    case Event::BUS_ADDED:
+        return "Bus added";
+    case Event::BUS_REMOVED:
+        return "Bus removed";
+    case Event::BUS_LEFT:
+        return "Bus left the game";
+    case Event::BUSES_IN_TRAFFIC:
+        return "Buses in traffic";
+    case Event::NYSSE_DESTROYED:
+        return "Nysse destroyed";
+    case Event::PASSENGER_DROPPED:
+        return "Passenger dropped";
+    case Event::PASSENGERS_ADDED:
+        return "Passengers added";
+    case Event::PASSENGER_BOARDED:
+        return "Passenger boarded";
+    case Event::PASSENGER_ALIGHTED:
+        return "Passenger alighted";
+    }
+    return "Unknown";
+}
+
+}
+
+namespace detail
+{
+
+bool enabled = qEnvironmentVariableIsSet("NYSSE_TRACE");
+
+void push(Event event, std::int32_t a, std::int32_t b)
+{
+    Record& record = ring[count % CAPACITY];
+    record.gameTime = clock;
+    record.a = a;
+    record.b = b;
+    record.event = event;
+    ++count;
+}
+
+}
+
+void setEnabled(bool enabled)
+{
+    detail::enabled = enabled;
+}
+
+void setClock(std::int32_t msecs)
+{
+    clock = msecs;
+}
+
+std::vector<Record> records()
+{
+    std::vector<Record> result;
+    std::size_t first = count > CAPACITY ? count - CAPACITY : 0;
+    result.reserve(count - first);
+    for (std::size_t i = first; i < count; ++i) {
+        result.push_back(ring[i % CAPACITY]);
+    }
+    return result;
+}
+
+void clear()
+{
+    count = 0;
+}
+
+QString format(const Record& record)
+{
+    return QString("%1 %2: %3 %4")
+            .arg(QTime::fromMSecsSinceStartOfDay(record.gameTime).toString("hh:mm:ss"))
+            .arg(eventName(record.event))
+            .arg(record.a)
+            .arg(record.b);
+}
+
+void dump(QTextStream& out)
+{
+    for (const Record& record : records()) {
+        out << format(record) << '\n';
+    }
+}
+
+bool writeBinary(QIODevice& device)
+{
+    std::vector<Record> all = records();
+
+    QDataStream out(&device);
+    out << MAGIC << VERSION << static_cast<quint32>(all.size());
+    for (const Record& record : all) {
+        out << record.gameTime << record.a << record.b << static_cast<quint8>(record.event);
+    }
+    return out.status() == QDataStream::Ok;
+}
+
+std::vector<Record> readBinary(QIODevice& device)
+{
+    QDataStream in(&device);
+    quint32 magic = 0;
+    quint16 version = 0;
+    quint32 size = 0;
+    in >> magic >> version >> size;
+    if (magic != MAGIC || version != VERSION) {
+        return {};
+    }
+
+    std::vector<Record> result;
+    for (quint32 i = 0; i < size && in.status() == QDataStream::Ok; ++i) {
+        Record record;
+        quint8 event = 0;
+        in >> record.gameTime >> record.a >> record.b >> event;
+        record.event = static_cast<Event>(event);
+        result.push_back(record);
+    }
+    if (in.status() != QDataStream::Ok) {
+        return {};
+    }
+    return result;
+}
+
+void flushToFile()
+{
+    QString path = qEnvironmentVariable("NYSSE_TRACE");
+    if (!isEnabled() || path.isEmpty()) {
+        return;
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(courseLogic) << "Could not write trace to" << path;
+        return;
+    }
+    writeBinary(file);
+}
+
+}
+
+}
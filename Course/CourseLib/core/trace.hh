@@ -0,0 +1,158 @@
+#ifndef TRACE_HH
+#define TRACE_HH
+
+#include <QIODevice>
+#include <QLoggingCategory>
+#include <QString>
+#include <QTextStream>
+
+#include <cstdint>
+#include <vector>
+
+/**
+  * @file
+  * @brief Defines a low-overhead event trace for the simulation hot paths.
+  *
+  * Events are stored as fixed-size records in a ring buffer and formatted
+  * only when the trace is dumped. When tracing is disabled, COURSE_TRACE
+  * costs a single branch.
+  */
+
+/**
+ * @brief courseLogic is the logging category for infrequent messages of the courseside logic.
+ * Debug output is disabled by default, enable it with QT_LOGGING_RULES="nysse.logic.debug=true".
+ */
+Q_DECLARE_LOGGING_CATEGORY(courseLogic)
+
+/**
+ * @brief nysseGame is the logging category for infrequent messages of the game side.
+ * Debug output is disabled by default, enable it with QT_LOGGING_RULES="nysse.game.debug=true".
+ */
+Q_DECLARE_LOGGING_CATEGORY(nysseGame)
+
+
+namespace CourseSide
+{
+
+namespace Trace
+{
+
+/**
+ * @brief Event tells what a trace record describes. Meaning of the payload fields a and b depends on the event.
+ */
+enum class Event : std::uint8_t
+{
+    BUS_ADDED,          // a = route number, b = bus SID
+    BUS_REMOVED,        // a = number of passengers removed with the bus
+    BUS_LEFT,           // a = passengers moved to the final stop
+    BUSES_IN_TRAFFIC,   // a = number of buses in traffic
+    NYSSE_DESTROYED,    // a = buses destroyed so far
+    PASSENGER_DROPPED,  // a = id of the stop passenger was moved to
+    PASSENGERS_ADDED,   // a = number of passengers added
+    PASSENGER_BOARDED,  // a = route number of the bus
+    PASSENGER_ALIGHTED  // a = route number of the bus
+};
+
+/**
+ * @brief Record is a single trace event, 16 bytes.
+ */
+struct Record
+{
+    std::int32_t gameTime;  // game time in milliseconds since midnight
+    std::int32_t a;
+    std::int32_t b;
+    Event event;
+};
+
+// Number of records kept, older records are overwritten
+const std::size_t CAPACITY = 4096;
+
+namespace detail
+{
+extern bool enabled;
+void push(Event event, std::int32_t a, std::int32_t b);
+}
+
+/**
+ * @brief isEnabled tells if events are recorded.
+ * @return true if tracing is on
+ * @post Exception guarantee: nothrow.
+ */
+inline bool isEnabled()
+{
+    return detail::enabled;
+}
+
+/**
+ * @brief setEnabled turns tracing on or off.
+ * Tracing is enabled at startup when environment variable NYSSE_TRACE is set.
+ * @param enabled new state
+ */
+void setEnabled(bool enabled);
+
+/**
+ * @brief setClock sets the game time stamped into following records.
+ * @param msecs game time in milliseconds since midnight
+ */
+void setClock(std::int32_t msecs);
+
+/**
+ * @brief records returns the recorded events from oldest to newest.
+ * @return copy of the ring buffer contents
+ */
+std::vector<Record> records();
+
+/**
+ * @brief clear removes all recorded events.
+ */
+void clear();
+
+/**
+ * @brief format formats a single record in human readable form.
+ * @param record record to be formatted
+ * @return one line description of the record
+ */
+QString format(const Record& record);
+
+/**
+ * @brief dump writes all recorded events as text, one event per line.
+ * @param out stream where the text is written
+ */
+void dump(QTextStream& out);
+
+/**
+ * @brief writeBinary writes all recorded events in binary form for offline formatting.
+ * @param device open writable device
+ * @return true if writing succeeded
+ */
+bool writeBinary(QIODevice& device);
+
+/**
+ * @brief readBinary reads records written by writeBinary.
+ * @param device open readable device
+ * @return records in the order they were written, empty if the data is invalid
+ */
+std::vector<Record> readBinary(QIODevice& device);
+
+/**
+ * @brief flushToFile writes the trace in binary form to the file named by
+ * environment variable NYSSE_TRACE, if tracing is enabled.
+ */
+void flushToFile();
+
+}
+
+}
+
+/**
+ * COURSE_TRACE records an event if tracing is enabled. Arguments are not
+ * evaluated when tracing is off.
+ */
+#define COURSE_TRACE(event, a, b) \
+    do { \
+        if (CourseSide::Trace::isEnabled()) { \
+            CourseSide::Trace::detail::push((event), (a), (b)); \
+        } \
+    } while (false)
+
+#endif // TRACE_HH
@@ -0,0 +1,161 @@
+#include "core/transitgraph.hh"
+#include "offlinereader.hh"
+
+#include <algorithm>
+
+namespace CourseSide
+{
+
+const std::uint8_t TransitGraph::UNREACHABLE;
+const std::int32_t TransitGraph::NONE;
+
+TransitGraph::TransitGraph()
+{
+}
+
+void TransitGraph::build(const OfflineData& data)
+{
+    patterns_.clear();
+    stopIndex_.clear();
+    patternIndex_.clear();
+    rides_.clear();
+
+    stopIndex_.reserve(data.stops.size());
+    for (std::size_t i = 0; i < data.stops.size(); ++i) {
+        stopIndex_.insert({data.stops[i].get(), static_cast<std::int32_t>(i)});
+    }
+
+    patterns_.reserve(data.buses.size());
+    for (const std::shared_ptr<BusData>& bus : data.buses) {
+        std::vector<std::int32_t> pattern;
+        // timeRoute2 is ordered by the time from the start of the line
+        for (const auto& point : bus->timeRoute2) {
+            std::int32_t stop = stopIndex(point.second.second.get());
+            if (stop != NONE && (pattern.empty() || pattern.back() != stop)) {
+                pattern.push_back(stop);
+            }
+        }
+        patternIndex_.insert({bus.get(), static_cast<std::int32_t>(patterns_.size())});
+        patterns_.push_back(std::move(pattern));
+    }
+
+    rides_.resize(data.stops.size());
+}
+
+std::int32_t TransitGraph::stopIndex(const Stop* stop) const
+{
+    auto found = stopIndex_.find(stop);
+    return found == stopIndex_.end() ? NONE : found->second;
+}
+
+std::int32_t TransitGraph::patternOf(const BusData* bus) const
+{
+    auto found = patternIndex_.find(bus);
+    return found == patternIndex_.end() ? NONE : found->second;
+}
+
+std::size_t TransitGraph::stopCount() const
+{
+    return rides_.size();
+}
+
+std::size_t TransitGraph::patternCount() const
+{
+    return patterns_.size();
+}
+
+std::uint8_t TransitGraph::rides(std::int32_t from, std::int32_t to) const
+{
+    return ridesTo(to)[from];
+}
+
+TransitGraph::Advice TransitGraph::board(std::int32_t pattern, std::int32_t stop,
+                                         std::int32_t destination) const
+{
+    if (pattern == NONE || stop == NONE || destination == NONE) {
+        return Advice::UNKNOWN;
+    }
+    if (stop == destination) {
+        return Advice::NO;
+    }
+
+    const std::vector<std::uint8_t>& rides = ridesTo(destination);
+    if (rides[stop] == UNREACHABLE) {
+        return Advice::UNKNOWN;
+    }
+    int best = bestAfter(pattern, stop, rides);
+    if (best == NONE) {
+        return Advice::UNKNOWN;
+    }
+    return best < rides[stop] ? Advice::YES : Advice::NO;
+}
+
+TransitGraph::Advice TransitGraph::alight(std::int32_t pattern, std::int32_t stop,
+                                          std::int32_t destination) const
+{
+    if (pattern == NONE || stop == NONE || destination == NONE) {
+        return Advice::UNKNOWN;
+    }
+    if (stop == destination) {
+        return Advice::YES;
+    }
+
+    const std::vector<std::uint8_t>& rides = ridesTo(destination);
+    int best = bestAfter(pattern, stop, rides);
+    if (best == NONE || (best == UNREACHABLE && rides[stop] == UNREACHABLE)) {
+        return Advice::UNKNOWN;
+    }
+    // Staying is better only if the bus still gets closer than transferring here
+    return best < rides[stop] ? Advice::NO : Advice::YES;
+}
+
+const std::vector<std::uint8_t>& TransitGraph::ridesTo(std::int32_t destination) const
+{
+    std::vector<std::uint8_t>& rides = rides_[destination];
+    if (!rides.empty()) {
+        return rides;
+    }
+
+    rides.assign(rides_.size(), UNREACHABLE);
+    rides[destination] = 0;
+
+    // Round k marks the stops from which one ride reaches a stop marked in rounds before k.
+    // Walking a pattern backwards tells if a later stop was marked before this round
+    for (std::uint8_t round = 1; round < UNREACHABLE; ++round) {
+        bool changed = false;
+        for (const std::vector<std::int32_t>& pattern : patterns_) {
+            bool reaches = false;
+            for (auto stop = pattern.rbegin(); stop != pattern.rend(); ++stop) {
+                if (reaches && rides[*stop] > round) {
+                    rides[*stop] = round;
+                    changed = true;
+                }
+                if (rides[*stop] < round) {
+                    reaches = true;
+                }
+            }
+        }
+        if (!changed) {
+            break;
+        }
+    }
+    return rides;
+}
+
+int TransitGraph::bestAfter(std::int32_t pattern, std::int32_t stop,
+                            const std::vector<std::uint8_t>& rides) const
+{
+    const std::vector<std::int32_t>& stops = patterns_[pattern];
+    auto position = std::find(stops.begin(), stops.end(), stop);
+    if (position == stops.end()) {
+        return NONE;
+    }
+
+    int best = UNREACHABLE;
+    for (++position; position != stops.end(); ++position) {
+        best = std::min<int>(best, rides[*position]);
+    }
+    return best;
+}
+
+}
@@ -0,0 +1,139 @@
+#ifndef TRANSITGRAPH_HH
+#define TRANSITGRAPH_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @file
+ * @brief Defines a graph of the stop sequences of bus lines, used to route passengers.
+ */
+
+
+namespace CourseSide
+{
+
+struct BusData;
+struct OfflineData;
+class Stop;
+
+/**
+ * @brief TransitGraph tells passengers which buses take them towards their destination.
+ *
+ * The graph is built from the stop sequences (patterns) of BusData::timeRoute2. Stops are
+ * identified by their index in OfflineData::stops and patterns by the index of their BusData
+ * in OfflineData::buses.
+ *
+ * For a destination, the graph computes in rounds the least number of rides from every stop:
+ * round k marks the stops from which some pattern reaches a stop marked in an earlier round.
+ * The result is cached per destination, so routing many passengers does not repeat searches.
+ * Timetables are not considered, only whether a bus goes towards the destination at all.
+ */
+class TransitGraph
+{
+public:
+    /**
+     * @brief Advice is the answer to a boarding or alighting question.
+     *
+     * UNKNOWN means the graph cannot tell, e.g. the destination is unreachable, and the
+     * passenger decides by itself.
+     */
+    enum class Advice : std::uint8_t
+    {
+        YES,
+        NO,
+        UNKNOWN
+    };
+
+    // Number of rides from a stop that cannot reach the destination
+    static const std::uint8_t UNREACHABLE = 255;
+    // Index of an unknown stop or pattern
+    static const std::int32_t NONE = -1;
+
+    TransitGraph();
+
+    /**
+     * @brief build replaces the graph with the patterns of the given data.
+     * @param data offline data with stops and buses
+     * @post Cached searches are forgotten. Exception guarantee: basic.
+     */
+    void build(const OfflineData& data);
+
+    /**
+     * @brief stopIndex tells the index of the given stop.
+     * @param stop stop to look up
+     * @return index of the stop, NONE if it is not known
+     * @post Exception guarantee: nothrow.
+     */
+    std::int32_t stopIndex(const Stop* stop) const;
+
+    /**
+     * @brief patternOf tells the pattern of the given bus line.
+     * @param bus bus line to look up
+     * @return index of the pattern, NONE if it is not known
+     * @post Exception guarantee: nothrow.
+     */
+    std::int32_t patternOf(const BusData* bus) const;
+
+    std::size_t stopCount() const;
+    std::size_t patternCount() const;
+
+    /**
+     * @brief rides tells the least number of rides between two stops.
+     * @param from index of the origin stop
+     * @param to index of the destination stop
+     * @pre Both stops are known.
+     * @return number of rides, UNREACHABLE if there is no route
+     * @post Search towards to is cached. Exception guarantee: basic.
+     */
+    std::uint8_t rides(std::int32_t from, std::int32_t to) const;
+
+    /**
+     * @brief board tells if a passenger at stop should board a bus of pattern.
+     *
+     * Advice is YES if the bus reaches a stop with fewer rides left than stop has.
+     *
+     * @param pattern pattern of the bus
+     * @param stop index of the stop the passenger is at
+     * @param destination index of the stop the passenger is going to
+     * @return advice for boarding
+     * @post Exception guarantee: basic.
+     */
+    Advice board(std::int32_t pattern, std::int32_t stop, std::int32_t destination) const;
+
+    /**
+     * @brief alight tells if a passenger on a bus of pattern should alight at stop.
+     *
+     * Advice is YES at the destination, and when the rest of the pattern has no stop with
+     * fewer rides left than stop has.
+     *
+     * @param pattern pattern of the bus
+     * @param stop index of the stop the bus is at
+     * @param destination index of the stop the passenger is going to
+     * @return advice for alighting
+     * @post Exception guarantee: basic.
+     */
+    Advice alight(std::int32_t pattern, std::int32_t stop, std::int32_t destination) const;
+
+private:
+    // Rides left from every stop to destination, computed on first use
+    const std::vector<std::uint8_t>& ridesTo(std::int32_t destination) const;
+
+    // Least rides left from the stops after stop on pattern, NONE if stop is not on it
+    int bestAfter(std::int32_t pattern, std::int32_t stop,
+                  const std::vector<std::uint8_t>& rides) const;
+
+    // Stop indices of each pattern in driving order
+    std::vector<std::vector<std::int32_t>> patterns_;
+    std::unordered_map<const Stop*, std::int32_t> stopIndex_;
+    std::unordered_map<const BusData*, std::int32_t> patternIndex_;
+
+    // Searches per destination, empty if not computed yet
+    mutable std::vector<std::vector<std::uint8_t>> rides_;
+};
+
+}
+
+#endif // TRANSITGRAPH_HH
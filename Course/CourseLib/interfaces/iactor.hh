@@ -13,6 +13,18 @@
 namespace Interface
 {
 
+/**
+ * @brief ActorKind tells what kind of an actor is, so that actors can be told apart without RTTI.
+ */
+enum class ActorKind : unsigned char
+{
+    UNKNOWN,
+    PASSENGER,
+    VEHICLE,
+    PLAYER,
+    POLICE
+};
+
 /**
  * @brief ActorIF is an interface, which every single actor moving in the game implements.
  *
@@ -66,6 +78,30 @@ public:
      */
     virtual void remove() = 0;
 
+    /**
+     * @brief getKind tells the kind of the actor.
+     * @pre -
+     * @return Kind set by the interface or class the actor implements, ActorKind::UNKNOWN by default.
+     * @post Exception guarantee: nothrow.
+     */
+    ActorKind getKind() const
+    {
+        return kind_;
+    }
+
+protected:
+    /**
+     * @brief setKind sets the kind of the actor. Called from constructors of derived classes.
+     * @param kind Kind of the actor.
+     * @post Exception guarantee: nothrow.
+     */
+    void setKind(ActorKind kind)
+    {
+        kind_ = kind;
+    }
+
+private:
+    ActorKind kind_ = ActorKind::UNKNOWN;
 };
 
 }
@@ -65,6 +65,23 @@ public:
      */
     virtual void addStop(std::shared_ptr<IStop> stop) = 0;
 
+    /**
+     * @brief addStops adds many stops to the city at once.
+     * @param stops pointers to stop objects.
+     * @pre City is in init state.
+     * @post Stops are added to the city. Exception guarantee: basic
+     * @exception InitError Position of a stop is not valid.
+     *
+     * Default implementation calls addStop for each stop. Cities can override it to
+     * register the stops in one pass.
+     */
+    virtual void addStops(const std::vector<std::shared_ptr<IStop>>& stops)
+    {
+        for (const std::shared_ptr<IStop>& stop : stops) {
+            addStop(stop);
+        }
+    }
+
     /**
      * @brief startGame shofts city from init state to the gamestate.
      * @pre City is in init state. setBackground() and setClock() have been called.
@@ -81,6 +98,23 @@ public:
      */
     virtual void addActor(std::shared_ptr<IActor> newactor) = 0;
 
+    /**
+     * @brief addActors adds many new actors to the city at once.
+     * @param newactors actors to be added to the city that fulfill ActorIF.
+     * @pre -
+     * @post Actors are added to the city. Exception guarantee: basic.
+     * @exception GameError An actor is already in the city.
+     *
+     * Default implementation calls addActor for each actor. Cities can override it to
+     * register the actors in one pass.
+     */
+    virtual void addActors(const std::vector<std::shared_ptr<IActor>>& newactors)
+    {
+        for (const std::shared_ptr<IActor>& newactor : newactors) {
+            addActor(newactor);
+        }
+    }
+
     /**
      * @brief removeActor removes the actor from the city.
      * @param actor Actor to be removed.
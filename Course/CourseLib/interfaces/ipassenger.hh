@@ -28,9 +28,12 @@ public:
     /**
       * @brief Default constructor for the Interface.(For documentation).
       * @post Passenger is not in any vehicle by default. Passengers destination is set.
+      * Actors kind is ActorKind::PASSENGER.
       */
-
-    IPassenger() = default;
+    IPassenger()
+    {
+        setKind(ActorKind::PASSENGER);
+    }
 
     /**
       * @brief Interface has default virtual destructor (base class needs to have a virtual destructor).
@@ -56,6 +56,104 @@ public:
      * @post Exception guarantee: strong
      */
     virtual void nysseLeft() = 0;
+
+    // Hooks below are optional, statistics that do not keep time series can ignore them
+
+    /**
+     * @brief nyssesAdded notifies, that new nysses were added to the game.
+     * @param num how many nysses were added.
+     * @pre num > 0
+     * @post Exception guarantee: strong. By default calls newNysse num times.
+     */
+    virtual void nyssesAdded(int num)
+    {
+        for (int i = 0; i < num; ++i) {
+            newNysse();
+        }
+    }
+
+    /**
+     * @brief nyssesLeft notifies, that nysses left the game.
+     * @param num how many nysses left.
+     * @pre num > 0
+     * @post Exception guarantee: strong. By default calls nysseLeft num times.
+     */
+    virtual void nyssesLeft(int num)
+    {
+        for (int i = 0; i < num; ++i) {
+            nysseLeft();
+        }
+    }
+
+    /**
+     * @brief passengerBoarded notifies, that a passenger boarded a bus.
+     * @param line number of the line of the bus.
+     * @pre -
+     * @post Exception guarantee: nothrow
+     */
+    virtual void passengerBoarded(unsigned int /*line*/) {}
+
+    /**
+     * @brief passengerAlighted notifies, that a passenger left a bus at a stop.
+     * @param line number of the line of the bus.
+     * @pre -
+     * @post Exception guarantee: nothrow
+     */
+    virtual void passengerAlighted(unsigned int /*line*/) {}
+
+    /**
+     * @brief passengersBoarded notifies, that passengers boarded buses of a line.
+     * @param line number of the line of the buses.
+     * @param num how many passengers boarded.
+     * @pre num > 0
+     * @post Exception guarantee: nothrow. By default calls passengerBoarded num times.
+     */
+    virtual void passengersBoarded(unsigned int line, int num)
+    {
+        for (int i = 0; i < num; ++i) {
+            passengerBoarded(line);
+        }
+    }
+
+    /**
+     * @brief passengersAlighted notifies, that passengers left buses of a line at stops.
+     * @param line number of the line of the buses.
+     * @param num how many passengers left.
+     * @pre num > 0
+     * @post Exception guarantee: nothrow. By default calls passengerAlighted num times.
+     */
+    virtual void passengersAlighted(unsigned int line, int num)
+    {
+        for (int i = 0; i < num; ++i) {
+            passengerAlighted(line);
+        }
+    }
+
+    /**
+     * @brief passengersWaiting tells how many passengers wait at a stop.
+     * @param stopId id of the stop.
+     * @param num number of waiting passengers.
+     * @pre num >= 0
+     * @post Exception guarantee: basic, memory is allocated only for a stop not seen before
+     */
+    virtual void passengersWaiting(unsigned int /*stopId*/, int /*num*/) {}
+
+    /**
+     * @brief busLoad tells how many passengers are in a bus.
+     * @param line number of the line of the bus.
+     * @param num number of passengers in the bus.
+     * @pre num >= 0
+     * @post Exception guarantee: basic, memory is allocated only for a line not seen before
+     */
+    virtual void busLoad(unsigned int /*line*/, int /*num*/) {}
+
+    /**
+     * @brief minutePassed notifies, that a minute of game time has passed. Events and
+     * samples given since the previous call belong to the minute that ended.
+     * @pre -
+     * @post Exception guarantee: nothrow
+     */
+    virtual void minutePassed() {}
 };
 
 }
@@ -2,6 +2,7 @@
 #define ISTOP_HH
 
 #include "ipassenger.hh"
+#include "passengerview.hh"
 
 #include <memory>
 
@@ -66,6 +67,14 @@ public:
      * @post Exception guarantee: strong
      */
     virtual std::vector<std::shared_ptr<Interface::IPassenger>> getPassengers() const = 0;
+
+    /**
+     * @brief passengers returns all passengers in the stop without copying them.
+     * @pre -
+     * @return View to the passengers in the stop. Adding passengers to the stop invalidates the view.
+     * @post Exception guarantee: nothrow
+     */
+    virtual PassengerView passengers() const = 0;
 };
 
 }
@@ -2,6 +2,7 @@
 #define IVEHICLE_HH
 
 #include "iactor.hh"
+#include "passengerview.hh"
 
 #include <string>
 #include <vector>
@@ -30,9 +31,12 @@ class IVehicle : public virtual IActor
 public:
     /**
       * @brief Default constructor (For documentation).
-      * @post vehicle has no passengers by default
+      * @post vehicle has no passengers by default. Actors kind is ActorKind::VEHICLE.
       */
-    IVehicle() = default;
+    IVehicle()
+    {
+        setKind(ActorKind::VEHICLE);
+    }
 
     /**
       * @brief Interface has default virtual destructor (base class needs to have a virtual destructor).
@@ -55,6 +59,23 @@ public:
      */
     virtual std::vector<std::shared_ptr<IPassenger> > getPassengers() const = 0;
 
+    /**
+     * @brief passengers returns all passengers in the vehicle without copying them.
+     *
+     * Vehicles that store their passengers contiguously should override this. The default
+     * implementation views a snapshot taken with getPassengers(); the snapshot reuses its
+     * storage, so it doesn't allocate once it has grown to the size of the vehicle.
+     *
+     * @pre -
+     * @return View to the passengers in the vehicle. Adding passengers to the vehicle invalidates the view.
+     * @post Exception guarantee: basic.
+     */
+    virtual PassengerView passengers() const
+    {
+        passengerSnapshot_ = getPassengers();
+        return PassengerView(passengerSnapshot_);
+    }
+
     /**
      * @brief addPassenger adds a new passenger to the vehicle.
      * @param passenger an passenger object to be added to the Vehicle.
@@ -72,6 +93,9 @@ public:
      */
     virtual void removePassenger(std::shared_ptr<IPassenger> passenger) = 0;
 
+private:
+    // Storage for the default implementation of passengers()
+    mutable std::vector<std::shared_ptr<IPassenger> > passengerSnapshot_;
 };
 
 }
@@ -0,0 +1,92 @@
+#ifndef PASSENGERVIEW_HH
+#define PASSENGERVIEW_HH
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+
+/**
+  * @file
+  * @brief Defines a non-owning view to passengers of a stop or a vehicle.
+  */
+
+
+namespace Interface
+{
+
+class IPassenger;
+
+/**
+ * @brief PassengerView is a read-only, non-owning range of passengers stored contiguously.
+ *
+ * The view does not copy the passengers or touch their reference counts. It stays valid
+ * until passengers are added to its owner. Removing a passenger only changes the positions
+ * at and after the removed one, so a view can be walked backwards while removing the
+ * current passenger.
+ */
+class PassengerView
+{
+public:
+    using value_type = std::shared_ptr<IPassenger>;
+    using const_iterator = const value_type*;
+
+    /**
+     * @brief Default constructor
+     * @post View is empty.
+     */
+    PassengerView() : begin_(nullptr), end_(nullptr)
+    {
+    }
+
+    /**
+     * @brief Constructor that views all elements of a vector.
+     * @param passengers vector that outlives the view
+     */
+    explicit PassengerView(const std::vector<value_type>& passengers) :
+        begin_(passengers.data()), end_(passengers.data() + passengers.size())
+    {
+    }
+
+    const_iterator begin() const
+    {
+        return begin_;
+    }
+
+    const_iterator end() const
+    {
+        return end_;
+    }
+
+    std::size_t size() const
+    {
+        return static_cast<std::size_t>(end_ - begin_);
+    }
+
+    bool empty() const
+    {
+        return begin_ == end_;
+    }
+
+    const value_type& operator[](std::size_t i) const
+    {
+        return begin_[i];
+    }
+
+    /**
+     * @brief toVector copies the viewed passengers.
+     * @return Vector containing all viewed passengers.
+     */
+    std::vector<value_type> toVector() const
+    {
+        return std::vector<value_type>(begin_, end_);
+    }
+
+private:
+    const_iterator begin_;
+    const_iterator end_;
+};
+
+}
+
+#endif // PASSENGERVIEW_HH
@@ -14,41 +14,74 @@
 namespace CourseSide
 {
 
-OfflineReader::OfflineReader()
+OfflineReader::OfflineReader() : done_(0), total_(0)
 {
 }
 
 std::shared_ptr<OfflineData> OfflineReader::readFiles(const QString& busfile,
-                                                         const QString& stopfile)
+                                                         const QString& stopfile,
+                                                         ProgressCallback progress)
 {
     offlinedata_ = std::make_shared<OfflineData>();
-    readStopFile(stopfile);
-    readBusFile(busfile);
-
+    stopsById_.clear();
+    progress_ = progress;
+    done_ = 0;
+    total_ = 0;
+
+    // Both files are parsed before reading so that progress has its final total
+    QJsonArray stopArray;
+    QJsonArray busArray;
+    bool ok = readDocument(stopfile, stopArray) && readDocument(busfile, busArray);
+    if (ok) {
+        total_ = stopArray.size() + busArray.size();
+        readStops(stopArray);
+        readBuses(busArray);
+    }
 
+    stopsById_.clear();
+    progress_ = nullptr;
+    // A game without stops can't place its passengers
+    if (!ok || offlinedata_->stops.empty()) {
+        offlinedata_ = nullptr;
+    }
     return offlinedata_;
 }
 
-void OfflineReader::readBusFile(const QString &busfile)
+bool OfflineReader::readDocument(const QString& path, QJsonArray& array)
 {
-    QString filecontent;
-    QFile file;
-    file.setFileName(busfile);
-    file.open(QIODevice::ReadOnly | QIODevice::Text);
-    filecontent = file.readAll();
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qWarning() << "Cannot open" << path << ":" << file.errorString();
+        return false;
+    }
+    QByteArray filecontent = file.readAll();
     file.close();
 
     QJsonParseError parse_error;
-    QJsonDocument document = QJsonDocument::fromJson( filecontent.toUtf8()  , &parse_error);
+    QJsonDocument document = QJsonDocument::fromJson(filecontent, &parse_error);
     if (parse_error.error != QJsonParseError::NoError) {
-        qDebug() << "Error parsing bus JSON: " << parse_error.errorString() << " at: " << filecontent.mid(parse_error.offset-3, parse_error.offset+3);
-        return;
+        qWarning() << "Error parsing" << path << ":" << parse_error.errorString()
+                   << "at offset" << parse_error.offset;
+        return false;
     }
-    QJsonObject jsonObject = document.object();
-    QJsonArray jsonArray = document.array();
+    if (!document.isArray()) {
+        qWarning() << "Expected a JSON array in" << path;
+        return false;
+    }
+    array = document.array();
+    return true;
+}
 
-    qDebug() << busfile;
+void OfflineReader::reportProgress()
+{
+    ++done_;
+    if (progress_) {
+        progress_(done_, total_);
+    }
+}
 
+void OfflineReader::readBuses(const QJsonArray& jsonArray)
+{
     for (int i = 0; i < jsonArray.size(); i++) {
 
         QJsonObject o = jsonArray.at(i).toObject();
@@ -99,22 +132,14 @@ void OfflineReader::readBusFile(const QString &busfile)
         }
 
         offlinedata_->buses.push_back(bus);
+        reportProgress();
     }
 }
 
-void OfflineReader::readStopFile(const QString &stopfile)
+void OfflineReader::readStops(const QJsonArray& jsonArray)
 {
-    QString filecontent;
-    QFile file;
-    file.setFileName(stopfile);
-    file.open(QIODevice::ReadOnly | QIODevice::Text);
-    filecontent = file.readAll();
-    file.close();
-
-    QJsonDocument document = QJsonDocument::fromJson(filecontent.toUtf8());
-    QJsonObject jsonObject = document.object();
-    QJsonArray jsonArray = document.array();
-
+    offlinedata_->stops.reserve(jsonArray.size());
+    stopsById_.reserve(jsonArray.size());
     for (int i = 0; i < jsonArray.size(); i++) {
         QJsonObject o = jsonArray.at(i).toObject();
 
@@ -123,6 +148,8 @@ void OfflineReader::readStopFile(const QString &stopfile)
                                                                      (unsigned int)o.value("stationId").toString().toInt());
 
         offlinedata_->stops.push_back(pysakki);
+        stopsById_.insert({static_cast<int>(pysakki->getId()), pysakki});
+        reportProgress();
     }
 }
 
@@ -141,13 +168,12 @@ void OfflineReader::readRoute(std::shared_ptr<BusData> bus, QJsonObject& o)
 
 std::shared_ptr<Stop> OfflineReader::findStops(int id)
 {
-    std::shared_ptr<Stop> stop = NULL;
-    for (unsigned int i = 0; i < offlinedata_->stops.size(); i++) {
-        stop = offlinedata_->stops.at(i);
-        int current = stop->getId();
-        if (current == id) break;
+    // Unknown ids give no stop instead of the last stop of the file
+    auto found = stopsById_.find(id);
+    if (found == stopsById_.end()) {
+        return nullptr;
     }
-    return stop;
+    return found->second;
 }
 
 QTime OfflineReader::calculateQTime(int time)
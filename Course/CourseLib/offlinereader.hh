@@ -5,10 +5,13 @@
 #include "core/location.hh"
 #include "actors/nysse.hh"
 
+#include <functional>
 #include <list>
 #include <QString>
 #include <map>
+#include <unordered_map>
 #include <QJsonObject>
+#include <QJsonArray>
 
 
 namespace CourseSide
@@ -40,15 +43,30 @@ struct OfflineData {
 class OfflineReader
 {
 public:
+    // Called with the number of read items (stops and bus lines) and their total count
+    using ProgressCallback = std::function<void(int done, int total)>;
+
     OfflineReader();
 
-    std::shared_ptr<OfflineData> readFiles(const QString& busfile, const QString& stopfile);
+    // Safe to call from a worker thread, progress is called from the same thread.
+    // Returns nullptr if a file can't be opened or parsed, or if it has no stops.
+    std::shared_ptr<OfflineData> readFiles(const QString& busfile, const QString& stopfile,
+                                           ProgressCallback progress = nullptr);
 
 private:
     std::shared_ptr<OfflineData> offlinedata_;
+    // Stops by their stationId, for finding the stops of bus lines
+    std::unordered_map<int, std::shared_ptr<Stop>> stopsById_;
+    ProgressCallback progress_;
+    int done_;
+    int total_;
+
+    void reportProgress();
 
-    void readBusFile(const QString& busfile);
-    void readStopFile(const QString& stopfile);
+    // Reads the JSON array of the file, false if the file isn't one
+    bool readDocument(const QString& path, QJsonArray& array);
+    void readBuses(const QJsonArray& jsonArray);
+    void readStops(const QJsonArray& jsonArray);
     void readDepartureTimes(const QJsonArray& timearray, BusData* bus);
     void readRoute(std::shared_ptr<BusData> bus, QJsonObject& o);
     std::shared_ptr<Stop> findStops(int id);
@@ -0,0 +1,6 @@
+# Chooses how Logic delivers events to IStatistics, see core/statisticspolicy.hh.
+# Included by every project that includes core/logic.hh, so that all of them
+# see the same Logic. Build with CONFIG+=nostatistics to leave the events out,
+# or with CONFIG+=tracestatistics to record each of them in the trace.
+nostatistics: DEFINES += COURSE_STATISTICS_NONE
+else:tracestatistics: DEFINES += COURSE_STATISTICS_TRACE
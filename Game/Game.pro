@@ -1,7 +1,7 @@
 TEMPLATE = app
 TARGET = NYSSE
 
-QT += core gui widgets network multimedia
+QT += core gui widgets network multimedia concurrent
 
 CONFIG += c++14
 
@@ -9,12 +9,17 @@ SOURCES += \
     city.cpp \
     coordinates.cpp \
     creategame.cc \
+    flowfield.cpp \
     gamewindow.cpp \
+    heldkeys.cpp \
+    inputlog.cpp \
     main.cc \
+    metrics.cpp \
     player.cpp \
-    police.cpp \
+    policeforce.cpp \
     settings.cpp \
-    statistics.cpp
+    statistics.cpp \
+    timeseries.cpp
 
 win32:CONFIG(release, debug|release): LIBS += \
     -L$$OUT_PWD/../Course/CourseLib/release/ -lCourseLib
@@ -29,6 +34,8 @@ INCLUDEPATH += \
 DEPENDPATH += \
     $$PWD/../Course/CourseLib
 
+include($$PWD/../Course/CourseLib/statistics.pri)
+
 win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += \
     $$OUT_PWD/../Course/CourseLib/release/libCourseLib.a
 else:win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += \
@@ -47,8 +54,13 @@ FORMS += \
 HEADERS += \
     city.hh \
     coordinates.h \
+    flowfield.h \
     gamewindow.h \
+    heldkeys.h \
+    inputlog.hh \
+    metrics.hh \
     player.h \
-    police.h \
+    policeforce.h \
     settings.h \
-    statistics.hh
+    statistics.hh \
+    timeseries.hh
@@ -2,6 +2,7 @@
 #include "errors/gameerror.hh"
 #include "errors/initerror.hh"
 #include "coordinates.h"
+#include <QDataStream>
 #include <QDebug>
 namespace Game
 {
@@ -16,8 +17,8 @@ City::~City()
 {
     for( auto actor : actorsInCity_ )
     {
-        delete actor.second;
-        actor.second = nullptr;
+        delete actor.second.graphics;
+        actor.second.graphics = nullptr;
     }
     for( auto stop : stopsInCity_ )
     {
@@ -49,7 +50,7 @@ void City::addStop(std::shared_ptr<Interface::IStop> stop)
 
         emit newStopNeededInScene( stop, stopGraphics );
 
-        stopsInCity_.insert( { stop, stopGraphics } );
+        registerStop( stop, stopGraphics );
     }
     catch (...)
     {
@@ -57,20 +58,67 @@ void City::addStop(std::shared_ptr<Interface::IStop> stop)
     }
 }
 
+void City::addStops(const std::vector<std::shared_ptr<Interface::IStop> > &stops)
+{
+    try
+    {
+        std::vector< QGraphicsRectItem* > stopGraphics( stops.size(), nullptr );
+
+        emit newStopsNeededInScene( stops, stopGraphics );
+
+        stopsInCity_.reserve( stopsInCity_.size() + stops.size() );
+        stopsInBorders_.reserve( stopsInBorders_.size() + stops.size() );
+        stopLocations_.reserve( stopLocations_.size() + stops.size() );
+        for( std::size_t i = 0; i < stops.size(); ++i )
+        {
+            registerStop( stops[i], stopGraphics[i] );
+        }
+    }
+    catch (...)
+    {
+        throw Interface::InitError( "Stops position is not valid." );
+    }
+}
+
+void City::registerStop(const std::shared_ptr<Interface::IStop> &stop,
+                        QGraphicsRectItem *stopGraphics)
+{
+    stopsInCity_.insert( { stop, stopGraphics } );
+
+    Interface::Location loc = stop->getLocation();
+    if( firstStop_ == nullptr )
+    {
+        firstStop_ = stop;
+    }
+    if( loc.giveX() >= Coordinates::BORDER_LEFT &&
+        loc.giveX() <= Coordinates::BORDER_RIGHT &&
+        loc.giveY() >= Coordinates::BORDER_UP &&
+        loc.giveY() <= Coordinates::BORDER_DOWN )
+    {
+        stopsInBorders_.push_back( stop );
+        stopLocations_.push_back( loc );
+    }
+}
+
+void City::appendActor(const std::shared_ptr<Interface::IActor> &actor)
+{
+    actors_.push_back( actor );
+    actorLocations_.push_back( actor->giveLocation() );
+}
+
 void City::addTramStops()
 {
-    Game::Coordinates c;
     Interface::Location loc = Interface::Location();
 
-    int east1 = c.EastFromX(tramStop1XCoord);
-    int north1 = c.NorthFromY(tramStop1YCoord);
+    int east1 = Coordinates::EastFromX(tramStop1XCoord);
+    int north1 = Coordinates::NorthFromY(tramStop1YCoord);
     loc.setNorthEast(north1, east1);
     tramStop1_ = std::make_shared< CourseSide::Stop >(
                 CourseSide::Stop( loc, "Ratikka 1", 10001) );
     emit tramStopNeededInScene( tramStop1_ );
 
-    int east2 = c.EastFromX(tramStop2XCoord);
-    int north2 = c.NorthFromY(tramStop2YCoord);
+    int east2 = Coordinates::EastFromX(tramStop2XCoord);
+    int north2 = Coordinates::NorthFromY(tramStop2YCoord);
     loc.setNorthEast(north2, east2);
     tramStop2_ = std::make_shared< CourseSide::Stop >(
                 CourseSide::Stop( loc, "Ratikka 2", 10002 ) );
@@ -93,21 +141,60 @@ void City::addActor(std::shared_ptr<Interface::IActor> newactor)
 
     emit newActorNeededInScene( newactor, actorGraphics );
 
-    actorsInCity_.insert( { newactor, actorGraphics } );
+    appendActor( newactor );
+    actorsInCity_.insert( { newactor, ActorEntry{ actorGraphics, actors_.size() - 1 } } );
+}
+
+void City::addActors(const std::vector<std::shared_ptr<Interface::IActor> > &newactors)
+{
+    std::size_t first = actors_.size();
+    actorsInCity_.reserve( actorsInCity_.size() + newactors.size() );
+    actors_.reserve( first + newactors.size() );
+    actorLocations_.reserve( first + newactors.size() );
+    for( std::size_t i = 0; i < newactors.size(); ++i )
+    {
+        if( !actorsInCity_.insert( { newactors[i], ActorEntry{ nullptr, first + i } } ).second )
+        {
+            // Actors inserted before the duplicate are taken out again
+            for( std::size_t j = 0; j < i; ++j )
+            {
+                actorsInCity_.erase( newactors[j] );
+            }
+            throw Interface::GameError( "Actor is already in the city.");
+        }
+    }
+    for( const std::shared_ptr< Interface::IActor >& actor : newactors )
+    {
+        appendActor( actor );
+    }
+
+    std::vector< QGraphicsPixmapItem* > actorGraphics( newactors.size(), nullptr );
+
+    emit newActorsNeededInScene( newactors, actorGraphics );
+
+    for( std::size_t i = 0; i < newactors.size(); ++i )
+    {
+        actorsInCity_[ newactors[i] ].graphics = actorGraphics[i];
+    }
 }
 
 void City::removeActor(std::shared_ptr<Interface::IActor> actor)
 {
-    std::map< std::shared_ptr< Interface::IActor >,
-              QGraphicsPixmapItem* >::iterator actorPos =
-            actorsInCity_.find( actor );
+    auto actorPos = actorsInCity_.find( actor );
 
     if( actorPos != actorsInCity_.end() )
     {
         actor->remove();
 
-        delete actorPos->second;
-        actorPos->second = nullptr;
+        delete actorPos->second.graphics;
+        actorPos->second.graphics = nullptr;
+
+        // Last actor takes the index of the removed one
+        std::size_t index = actorPos->second.index;
+        actors_[index] = actors_.back();
+        actorsInCity_.at( actors_[index] ).index = index;
+        actors_.pop_back();
+        actorLocations_.swapRemove( index );
 
         actorsInCity_.erase( actorPos );
     }
@@ -124,9 +211,7 @@ void City::actorRemoved(std::shared_ptr<Interface::IActor> actor)
 
 bool City::findActor(std::shared_ptr<Interface::IActor> actor) const
 {
-    std::map< std::shared_ptr< Interface::IActor >,
-              QGraphicsPixmapItem* >::const_iterator actorIter =
-            actorsInCity_.find( actor );
+    auto actorIter = actorsInCity_.find( actor );
 
     if( actorIter == actorsInCity_.end() )
     {
@@ -137,7 +222,9 @@ bool City::findActor(std::shared_ptr<Interface::IActor> actor) const
 
 void City::actorMoved(std::shared_ptr<Interface::IActor> actor)
 {
-    emit actorMovedInCity( actor, actorsInCity_.at( actor ) );
+    ActorEntry& entry = actorsInCity_.at( actor );
+    actorLocations_.set( entry.index, actor->giveLocation() );
+    emit actorMovedInCity( actor, entry.graphics );
 }
 
 std::vector<std::shared_ptr<Interface::IActor> > City::getNearbyActors(
@@ -145,11 +232,13 @@ std::vector<std::shared_ptr<Interface::IActor> > City::getNearbyActors(
 {
    std::vector<std::shared_ptr<Interface::IActor> > nearbyActors = {};
 
-   for( auto actor : actorsInCity_ )
+   Interface::Location::closeMask( loc, actorLocations_, closeMask_ );
+
+   for( std::size_t i = 0; i < actors_.size(); ++i )
    {
-       if( actor.first ->giveLocation().isClose( loc ) )
+       if( ( closeMask_[i / 64] >> ( i % 64 ) ) & 1 )
        {
-           nearbyActors.push_back( actor.first );
+           nearbyActors.push_back( actors_[i] );
        }
    }
    return nearbyActors;
@@ -165,36 +254,41 @@ void City::gameIsOver()
     gameOver_ = true;
 }
 
+void City::saveState(QDataStream &out) const
+{
+    out << gameOver_;
+}
+
+bool City::restoreState(QDataStream &in)
+{
+    bool gameOver = false;
+    in >> gameOver;
+    if( in.status() != QDataStream::Ok )
+    {
+        return false;
+    }
+    gameOver_ = gameOver;
+    return true;
+}
+
 std::shared_ptr<Interface::IStop> City::getNearestStop(Interface::Location loc) const
 {
-    Coordinates c;
-    std::map< std::shared_ptr< Interface::IStop >,
-              QGraphicsRectItem* >::const_iterator stopIter = stopsInCity_.begin();
-    std::shared_ptr<Interface::IStop> nearestStop = stopIter->first;
-
-    double currentShortestDistance = Interface::Location::calcDistance( loc,
-                                        stopIter->first->getLocation());
-    ++stopIter;
-    double distance = 0.0;
-    for( stopIter; stopIter != stopsInCity_.end(); ++stopIter )
-    {
-        if( stopIter->first->getLocation().giveX() < c.BORDER_LEFT ||
-            stopIter->first->getLocation().giveX() > c.BORDER_RIGHT ||
-            stopIter->first->getLocation().giveY() < c.BORDER_UP ||
-            stopIter->first->getLocation().giveY() > c.BORDER_DOWN )
-        {
-            continue;
-        }
+    if( stopsInBorders_.empty() )
+    {
+        return firstStop_;
+    }
+
+    Interface::Location::calcDistances( loc, stopLocations_, stopDistances_ );
 
-        distance = Interface::Location::calcDistance(
-                    loc, stopIter->first->getLocation() );
-        if( distance < currentShortestDistance )
+    std::size_t nearest = 0;
+    for( std::size_t i = 1; i < stopDistances_.size(); ++i )
+    {
+        if( stopDistances_[i] < stopDistances_[nearest] )
         {
-            nearestStop = stopIter->first;
-            currentShortestDistance = distance;
+            nearest = i;
         }
     }
-    return nearestStop;
+    return stopsInBorders_.at( nearest );
 }
 
 std::shared_ptr<CourseSide::Stop> City::giveTramStop1()
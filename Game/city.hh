@@ -3,10 +3,13 @@
 
 #include "actors/nysse.hh"
 #include "interfaces/icity.hh"
-#include <map>
+#include "core/locationbuffer.hh"
+#include <unordered_map>
 #include <QGraphicsRectItem>
 #include <QTime>
 
+class QDataStream;
+
 
 /**
   * @file
@@ -79,6 +82,18 @@ public:
      */
     void addStop( std::shared_ptr< Interface::IStop > stop );
 
+    /**
+     * @brief addStops function
+     * @param stops pointers to stop objects.
+     * @pre City is in init state.
+     * @post Stops are added to the city. Exception guarantee: basic
+     * @exception InitError Position of a stop is not valid.
+     *
+     * adds stops to stopsInCity_ like addStop, but reserves room for all of
+     * them and sends a single signal to gamewindow.
+     */
+    void addStops( const std::vector< std::shared_ptr< Interface::IStop > >& stops );
+
     /**
      * @brief addTramStops
      *
@@ -106,6 +121,17 @@ public:
      */
     void addActor( std::shared_ptr< Interface::IActor > newactor );
 
+    /**
+     * @brief addActors function
+     * @param newactors actors to be added to the city that fulfill ActorIF.
+     * @post Actors are added to the city. Exception guarantee: strong.
+     * @exception GameError An actor is already in the city or given twice.
+     *
+     * Adds actors to actorsInCity_ like addActor, but reserves room for all
+     * of them and sends a single signal to gamewindow.
+     */
+    void addActors( const std::vector< std::shared_ptr< Interface::IActor > >& newactors );
+
     /**
      * @brief removeActor function
      * @param actor Actor to be removed.
@@ -166,6 +192,29 @@ public:
      */
     void gameIsOver();
 
+    /**
+     * @brief saveState function
+     * @param out stream the state is written to
+     *
+     * Writes whether the game has ended. Clock, stops and actors are given
+     * again by Logic::restoreSnapshot.
+     */
+    void saveState( QDataStream& out ) const;
+
+    /**
+     * @brief restoreState function
+     * @param in stream to read a state written by saveState from
+     * @return true if the state was read, nothing is changed on false
+     */
+    bool restoreState( QDataStream& in );
+
+    /**
+     * @brief getNearestStop function
+     * @param loc Location for finding the nearest stop
+     * @pre At least one stop has been added
+     * @return nearest stop inside the game borders, or the first added stop
+     * if none of the stops is inside the borders
+     */
     std::shared_ptr< Interface::IStop > getNearestStop(
             Interface::Location loc ) const;
 
@@ -201,6 +250,16 @@ signals:
     void newStopNeededInScene( std::shared_ptr< Interface::IStop > stop,
                                QGraphicsRectItem*& stopGraphics );
 
+    /**
+     * @brief newStopsNeededInScene signal
+     * @param stops data pointers
+     * @param stopGraphics stored graphics for each stop, same size as stops
+     *
+     * emitted when adding many stops to the map at once
+     */
+    void newStopsNeededInScene( const std::vector< std::shared_ptr< Interface::IStop > >& stops,
+                                std::vector< QGraphicsRectItem* >& stopGraphics );
+
     void tramStopNeededInScene( std::shared_ptr< Interface::IStop >  );
 
     /**
@@ -213,6 +272,16 @@ signals:
     void newActorNeededInScene( const std::shared_ptr< Interface::IActor >& newactor,
                                 QGraphicsPixmapItem*& newactorGraphics);
 
+    /**
+     * @brief newActorsNeededInScene signal
+     * @param newactors datapointers
+     * @param newactorGraphics graphics data for each actor, same size as newactors
+     *
+     * emitted when adding many actors to city at once
+     */
+    void newActorsNeededInScene( const std::vector< std::shared_ptr< Interface::IActor > >& newactors,
+                                 std::vector< QGraphicsPixmapItem* >& newactorGraphics );
+
     /**
      * @brief actorMovedInCity signal
      * @param actor data pointer
@@ -228,11 +297,34 @@ private:
     State state_;
     bool gameOver_;
 
+    // Graphics of an actor and its index in actors_ and actorLocations_
+    struct ActorEntry
+    {
+        QGraphicsPixmapItem* graphics;
+        std::size_t index;
+    };
+
     // Below are buses and passangers that are currently in game
-    std::map< std::shared_ptr< Interface::IActor >,
-              QGraphicsPixmapItem* > actorsInCity_;
-    std::map< std::shared_ptr< Interface::IStop >,
-              QGraphicsRectItem* > stopsInCity_;
+    std::unordered_map< std::shared_ptr< Interface::IActor >,
+                        ActorEntry > actorsInCity_;
+
+    // Actors in a dense order and their locations, kept up to date when
+    // actors are added, moved and removed, for the batch query of
+    // getNearbyActors. Removing an actor moves the last one to its index.
+    std::vector< std::shared_ptr< Interface::IActor > > actors_;
+    Interface::LocationBuffer actorLocations_;
+    std::unordered_map< std::shared_ptr< Interface::IStop >,
+                        QGraphicsRectItem* > stopsInCity_;
+
+    // Stops inside the game borders in insertion order and their locations,
+    // for the batch distance calculation of getNearestStop
+    std::vector< std::shared_ptr< Interface::IStop > > stopsInBorders_;
+    Interface::LocationBuffer stopLocations_;
+    std::shared_ptr< Interface::IStop > firstStop_;
+
+    // Reused by the queries to avoid allocating on every call
+    mutable std::vector< std::uint64_t > closeMask_;
+    mutable std::vector< double > stopDistances_;
     std::shared_ptr< CourseSide::Stop > tramStop1_;
     std::shared_ptr< CourseSide::Stop > tramStop2_;
 
@@ -241,6 +333,14 @@ private:
     const int tramStop2XCoord = 811;
     const int tramStop2YCoord = 549;
 
+    // Appends an actor to actors_ and actorLocations_, its entry in
+    // actorsInCity_ gets the index actors_.size() before the call
+    void appendActor( const std::shared_ptr< Interface::IActor >& actor );
+
+    // Stores stop and its graphics, and its location if inside the borders
+    void registerStop( const std::shared_ptr< Interface::IStop >& stop,
+                       QGraphicsRectItem* stopGraphics );
+
 };
 }
 #endif // CITY_HH
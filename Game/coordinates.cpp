@@ -1,28 +1,9 @@
 #include "coordinates.h"
 namespace Game
 {
-Coordinates::Coordinates()
-{
-
-}
-
-int Coordinates::xFromEast(double eastcoord)
-{
-    return (eastcoord - EASTERN_COORD) * COORD_MULT;
-}
-
-int Coordinates::yFromNorth(double northcoord)
-{
-    return (northcoord - NORTHERN_COORD) * COORD_MULT;
-}
-
-double Coordinates::EastFromX(int x)
-{
-    return x/COORD_MULT + EASTERN_COORD;
-}
-
-double Coordinates::NorthFromY(int y)
-{
-    return y/COORD_MULT + NORTHERN_COORD;
-}
+// Definitions for the constants in case they are bound to a reference
+constexpr int Coordinates::BORDER_UP;
+constexpr int Coordinates::BORDER_DOWN;
+constexpr int Coordinates::BORDER_LEFT;
+constexpr int Coordinates::BORDER_RIGHT;
 }
@@ -1,49 +1,65 @@
 #ifndef COORDINATES_H
 #define COORDINATES_H
 
+#include "core/projection.hh"
+
 namespace Game
 {
+/**
+ * @brief The Coordinates class
+ *
+ * Transforms between map coordinates and pixel coordinates of the game map.
+ * All members are static and compile-time constants, so no object is needed.
+ */
 class Coordinates
 {
 public:
-    Coordinates();
+    using Projection = Interface::GameMapProjection;
 
     /**
      * @brief xFromEast function
      * @param eastcoord eastern coordinate
      * @return integer that represents map x-coordinates
      */
-    int xFromEast(double eastcoord);
+    static constexpr int xFromEast(double eastcoord)
+    {
+        return Projection::xFromEast(eastcoord);
+    }
 
     /**
      * @brief yFromNorth function
      * @param northcoord eastern coordinate
      * @return integer that represents map y-coordinate
      */
-    int yFromNorth(double northcoord);
+    static constexpr int yFromNorth(double northcoord)
+    {
+        return Projection::yFromNorth(northcoord);
+    }
 
     /**
      * @brief EastFromX function
      * @param x integer coordinate
      * @return double value of the east coordinate
      */
-    double EastFromX(int x);
+    static constexpr double EastFromX(int x)
+    {
+        return Projection::eastFromX(x);
+    }
 
     /**
      * @brief NorthFromY function
      * @param y integer coordinate
      * @return double value of the north coordinate
      */
-    double NorthFromY(int y);
+    static constexpr double NorthFromY(int y)
+    {
+        return Projection::northFromY(y);
+    }
 
-    const int BORDER_UP = 0;
-    const int BORDER_DOWN = 570;
-    const int BORDER_LEFT = 0;
-    const int BORDER_RIGHT = 1013;
-private:
-    const int EASTERN_COORD = 3326932;
-    const int NORTHERN_COORD = 6824973;
-    const double COORD_MULT = 0.711805;
+    static constexpr int BORDER_UP = 0;
+    static constexpr int BORDER_DOWN = 570;
+    static constexpr int BORDER_LEFT = 0;
+    static constexpr int BORDER_RIGHT = 1013;
 };
 }
 #endif // COORDINATES_H
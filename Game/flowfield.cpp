@@ -0,0 +1,198 @@
+#include "flowfield.h"
+
+#include <QImage>
+#include <algorithm>
+#include <utility>
+
+namespace Game
+{
+
+const int FlowField::CELL_SIZE;
+const std::int32_t FlowField::NONE;
+
+namespace
+{
+
+// Lakes and rapids are pale cyan on the map: blue and green equal and
+// clearly above red. Parks are green only and buildings red.
+bool isWater( QRgb pixel )
+{
+    int r = qRed( pixel );
+    int g = qGreen( pixel );
+    int b = qBlue( pixel );
+    return g > r + 10 && b > r + 10 && qAbs( g - b ) < 8;
+}
+
+}
+
+FlowField::FlowField():
+    columns_(0), rows_(0), targetCell_(NONE)
+{
+}
+
+std::vector<std::uint8_t> FlowField::walkableCells(const QImage &map,
+                                                   int width, int height)
+{
+    const int columns = ( width + CELL_SIZE - 1 ) / CELL_SIZE;
+    const int rows = ( height + CELL_SIZE - 1 ) / CELL_SIZE;
+    std::vector< int > water( std::size_t( columns * rows ), 0 );
+    std::vector< int > pixels( water.size(), 0 );
+
+    QImage image = map.convertToFormat( QImage::Format_RGB32 );
+    const int imageWidth = qMin( image.width(), width );
+    const int imageHeight = qMin( image.height(), height );
+    for( int row = 0; row < imageHeight; ++row )
+    {
+        // Image rows go down, y of the game goes up
+        int y = height - 1 - row;
+        const QRgb* line = reinterpret_cast< const QRgb* >( image.constScanLine( row ) );
+        for( int x = 0; x < imageWidth; ++x )
+        {
+            std::size_t cell = std::size_t( ( y / CELL_SIZE ) * columns + x / CELL_SIZE );
+            water[cell] += isWater( line[x] ) ? 1 : 0;
+            pixels[cell] += 1;
+        }
+    }
+
+    std::vector< std::uint8_t > walkable( water.size() );
+    for( std::size_t cell = 0; cell < walkable.size(); ++cell )
+    {
+        walkable[cell] = 2 * water[cell] <= pixels[cell] ? 1 : 0;
+    }
+    return walkable;
+}
+
+void FlowField::setWalkable(int width, int height, std::vector<std::uint8_t> walkable)
+{
+    columns_ = ( width + CELL_SIZE - 1 ) / CELL_SIZE;
+    rows_ = ( height + CELL_SIZE - 1 ) / CELL_SIZE;
+    Q_ASSERT( walkable.size() == cellCount() );
+
+    walkable_ = std::move( walkable );
+    next_.assign( cellCount(), NONE );
+    distance_.assign( cellCount(), NONE );
+    queue_.clear();
+    queue_.reserve( cellCount() );
+    targetCell_ = NONE;
+}
+
+bool FlowField::setTarget(int x, int y)
+{
+    std::int32_t cell = cellOf( float( x ), float( y ) );
+    if( cell == targetCell_ )
+    {
+        return false;
+    }
+    targetCell_ = cell;
+    search();
+    return true;
+}
+
+bool FlowField::isEmpty() const
+{
+    return walkable_.empty();
+}
+
+std::int32_t FlowField::cellOf(float x, float y) const
+{
+    if( x < 0.0f || y < 0.0f )
+    {
+        return NONE;
+    }
+    int column = int( x ) / CELL_SIZE;
+    int row = int( y ) / CELL_SIZE;
+    if( column >= columns_ || row >= rows_ )
+    {
+        return NONE;
+    }
+    return row * columns_ + column;
+}
+
+float FlowField::centerX(std::int32_t cell) const
+{
+    return float( ( cell % columns_ ) * CELL_SIZE ) + CELL_SIZE / 2.0f;
+}
+
+float FlowField::centerY(std::int32_t cell) const
+{
+    return float( ( cell / columns_ ) * CELL_SIZE ) + CELL_SIZE / 2.0f;
+}
+
+std::int32_t FlowField::targetCell() const
+{
+    return targetCell_;
+}
+
+bool FlowField::isWalkable(std::int32_t cell) const
+{
+    return walkable_[ std::size_t( cell ) ] != 0;
+}
+
+int FlowField::columns() const
+{
+    return columns_;
+}
+
+int FlowField::rows() const
+{
+    return rows_;
+}
+
+std::size_t FlowField::cellCount() const
+{
+    return std::size_t( columns_ ) * std::size_t( rows_ );
+}
+
+void FlowField::search()
+{
+    std::fill( next_.begin(), next_.end(), NONE );
+    std::fill( distance_.begin(), distance_.end(), NONE );
+    queue_.clear();
+    if( targetCell_ == NONE )
+    {
+        return;
+    }
+
+    // Straight neighbours first, so that ties prefer straight moves
+    const int DX[] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+    const int DY[] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+
+    // Target may be blocked, the player is not kept out of water
+    distance_[ std::size_t( targetCell_ ) ] = 0;
+    queue_.push_back( targetCell_ );
+    for( std::size_t head = 0; head < queue_.size(); ++head )
+    {
+        std::int32_t cell = queue_[head];
+        int column = cell % columns_;
+        int row = cell / columns_;
+
+        for( int i = 0; i < 8; ++i )
+        {
+            int c = column + DX[i];
+            int r = row + DY[i];
+            if( c < 0 || r < 0 || c >= columns_ || r >= rows_ )
+            {
+                continue;
+            }
+            std::int32_t neighbour = r * columns_ + c;
+            if( !walkable_[ std::size_t( neighbour ) ] ||
+                    distance_[ std::size_t( neighbour ) ] != NONE )
+            {
+                continue;
+            }
+            // Diagonal moves do not cut past blocked corners
+            if( DX[i] != 0 && DY[i] != 0 &&
+                    ( !walkable_[ std::size_t( row * columns_ + c ) ] ||
+                      !walkable_[ std::size_t( r * columns_ + column ) ] ) )
+            {
+                continue;
+            }
+            distance_[ std::size_t( neighbour ) ] = distance_[ std::size_t( cell ) ] + 1;
+            // Search goes out from the target, the way back is the next cell
+            next_[ std::size_t( neighbour ) ] = cell;
+            queue_.push_back( neighbour );
+        }
+    }
+}
+
+}
@@ -0,0 +1,124 @@
+#ifndef FLOWFIELD_H
+#define FLOWFIELD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class QImage;
+
+/**
+  * @file
+  * @brief Defines a flow field that guides chasers to the player.
+  */
+
+namespace Game
+{
+
+/**
+ * @brief The FlowField class
+ *
+ * Divides the play area into square cells. Each walkable cell knows the
+ * next cell on a shortest path to the target cell, so any number of agents
+ * reads its way with one lookup. Paths are found with a breadth-first
+ * search over the eight neighbours of a cell; diagonal moves past a blocked
+ * cell are not allowed. The search is run again only when the target moves
+ * to another cell, reusing its buffers.
+ *
+ * Coordinates are pixels of the game map with y growing upwards, like in
+ * Coordinates.
+ */
+class FlowField
+{
+public:
+    // Width and height of a cell in pixels
+    static const int CELL_SIZE = 8;
+    // Cell of a point outside the field, or next of a cell without a path
+    static const std::int32_t NONE = -1;
+
+    /**
+     * @brief FlowField constructor
+     *
+     * Creates an empty field, isEmpty() is true until setWalkable.
+     */
+    FlowField();
+
+    /**
+     * @brief walkableCells derives a walkability mask from a map image
+     * @param map background map as drawn, its top left corner at the top
+     * left corner of the play area
+     * @param width width of the play area in pixels
+     * @param height height of the play area in pixels
+     * @return one value for each cell, row by row from y = 0, 1 if the cell
+     * can be walked. Cells that are mostly water are blocked, the area not
+     * covered by the map is walkable.
+     */
+    static std::vector< std::uint8_t > walkableCells( const QImage& map,
+                                                      int width, int height );
+
+    /**
+     * @brief setWalkable sets the area of the field
+     * @param width width of the area in pixels
+     * @param height height of the area in pixels
+     * @param walkable mask from walkableCells, row by row
+     * @pre walkable has a value for every cell of the area
+     * @post Field has no target. Exception guarantee: basic
+     */
+    void setWalkable( int width, int height, std::vector< std::uint8_t > walkable );
+
+    /**
+     * @brief setTarget moves the target of the field
+     * @param x target coordinate in pixels
+     * @param y target coordinate in pixels
+     * @return true if the target changed cell and paths were searched again
+     * @post Exception guarantee: nothrow
+     */
+    bool setTarget( int x, int y );
+
+    bool isEmpty() const;
+
+    /**
+     * @brief cellOf
+     * @param x coordinate in pixels
+     * @param y coordinate in pixels
+     * @return cell of the point, NONE if it is outside the field
+     */
+    std::int32_t cellOf( float x, float y ) const;
+
+    /**
+     * @brief next
+     * @param cell cell of the field
+     * @pre 0 <= cell < cellCount()
+     * @return next cell toward the target, NONE if the cell is the target
+     * or the target cannot be reached from it
+     */
+    std::int32_t next( std::int32_t cell ) const
+    {
+        return next_[ std::size_t( cell ) ];
+    }
+
+    float centerX( std::int32_t cell ) const;
+    float centerY( std::int32_t cell ) const;
+
+    std::int32_t targetCell() const;
+    bool isWalkable( std::int32_t cell ) const;
+    int columns() const;
+    int rows() const;
+    std::size_t cellCount() const;
+
+private:
+    // Breadth-first search from targetCell_, fills next_
+    void search();
+
+    int columns_;
+    int rows_;
+    std::int32_t targetCell_;
+    std::vector< std::uint8_t > walkable_;
+    std::vector< std::int32_t > next_;
+    // Buffers of search, kept to avoid allocating per search
+    std::vector< std::int32_t > distance_;
+    std::vector< std::int32_t > queue_;
+};
+}
+
+#endif // FLOWFIELD_H
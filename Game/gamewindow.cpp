@@ -2,42 +2,73 @@
 #include "gamewindow.h"
 #include "ui_gamewindow.h"
 
+#include "core/trace.hh"
+
 #include <QtDebug>
+#include <QDataStream>
+#include <QFile>
 #include <QGraphicsPixmapItem>
 #include <QGraphicsRectItem>
-#include <typeinfo>
+#include <QMessageBox>
+#include <QProgressDialog>
+#include <QSaveFile>
+#include <QTextStream>
 
 const int STOP_SIZE = 7;
 const QBrush STOP_COLOR( Qt::yellow );
 const QBrush TRAM_STOP_COLOR( Qt::red );
+// "NYSG" and the version of the snapshot of a game
+const quint32 SNAPSHOT_MAGIC = 0x4E595347;
+const quint16 SNAPSHOT_VERSION = 1;
 
 GameWindow::GameWindow(QWidget *parent) :
     QDialog(parent),
-    ui(new Ui::GameWindow), sec_(0), min_(0)
+    ui(new Ui::GameWindow), simulatedMs_(0), rotationCarry_(0.0),
+    unshownInputUsecs_(-1), unpaintedInputUsecs_(-1), gameEndingTimer_(nullptr),
+    sec_(0), min_(0), logic_(nullptr), loadingDialog_(nullptr), gameStarted_(false)
 {
+    startClock_.start();
+    inputClock_.start();
     ui->setupUi(this);
     scene_ = new QGraphicsScene(this);
     const int left_margin = 1;
     const int top_margin = 1;
 
-    Game::Coordinates c;
     ui->graphicsView->setGeometry(left_margin, top_margin,
-                                  c.BORDER_RIGHT+2, c.BORDER_DOWN+2);
+                                  Game::Coordinates::BORDER_RIGHT+2,
+                                  Game::Coordinates::BORDER_DOWN+2);
     ui->graphicsView->setScene(scene_);
-    scene_->setSceneRect(0, 0, c.BORDER_RIGHT, c.BORDER_DOWN);
+    ui->graphicsView->viewport()->installEventFilter(this);
+    scene_->setSceneRect(0, 0, Game::Coordinates::BORDER_RIGHT,
+                         Game::Coordinates::BORDER_DOWN);
 
     ui->actionButton->setEnabled( true );
     ui->PointsPlaceholder->setNum(0);
 
+    // Clicks are recorded from the signals, moveQueue calls the slots directly.
+    // A click acts on the player where the input simulation has got to.
+    for( qint32 button = qint32( Game::Button::WALKER );
+         button <= qint32( Game::Button::QUIT ); ++button )
+    {
+        connect( inputButton( Game::Button( button ) ), &QAbstractButton::clicked,
+                 this, [this, button]() {
+            recordInput( Game::InputType::BUTTON, button, simulatedMs_ );
+        });
+    }
+
     gameCity_ = std::dynamic_pointer_cast< Game::City >(
                 Interface::createGame() );
 
     connect( gameCity_.get(), &Game::City::newStopNeededInScene, this,
              &GameWindow::addStopToScene );
+    connect( gameCity_.get(), &Game::City::newStopsNeededInScene, this,
+             &GameWindow::addStopsToScene );
     connect( gameCity_.get(), &Game::City::tramStopNeededInScene, this,
              &GameWindow::addTramStopToScene );
     connect( gameCity_.get(), &Game::City::newActorNeededInScene, this,
              &GameWindow::addActorToScene );
+    connect( gameCity_.get(), &Game::City::newActorsNeededInScene, this,
+             &GameWindow::addActorsToScene );
     connect( gameCity_.get(), &Game::City::givenMapsAreValid, this,
              &GameWindow::setMap );
     connect( gameCity_.get(), &Game::City::actorMovedInCity, this,
@@ -63,14 +94,21 @@ GameWindow::GameWindow(QWidget *parent) :
     rotateIcon();
 
     gameSpeed = new QTimer(this);
-    gameSpeed->start(100);
+    gameSpeed->setTimerType(Qt::PreciseTimer);
+    gameSpeed->start(FRAME_MS);
     connect(gameSpeed, SIGNAL(timeout()), this, SLOT(moveQueue()));
 
-    police_ = new Game::Police();
-    policeIcon_ = scene_->addPixmap(QPixmap("images/police.png"));
-    connect( police_, &Game::Police::playerCaught, gameCity_.get(),
+    police_ = new Game::PoliceForce();
+    police_->addUnits( POLICE_UNITS );
+    police_->setFlowField( &flowField_ );
+    QPixmap policePix = QPixmap("images/police.png");
+    for( std::size_t i = 0; i < police_->size(); ++i )
+    {
+        policeIcons_.push_back( scene_->addPixmap(policePix) );
+    }
+    connect( police_, &Game::PoliceForce::playerCaught, gameCity_.get(),
              &Game::City::gameIsOver );
-    connect( police_, &Game::Police::playerCaught, this,
+    connect( police_, &Game::PoliceForce::playerCaught, this,
              &GameWindow::showGameEnded);
     movePoliceIcon();
     movePolice();
@@ -85,6 +123,29 @@ GameWindow::GameWindow(QWidget *parent) :
 
 GameWindow::~GameWindow()
 {
+    if( !recordPath_.isEmpty() )
+    {
+        inputLog_.finish( logic_ != nullptr ? logic_->ticks() : 0, simulatedMs_ );
+        if( !inputLog_.save( recordPath_ ) )
+        {
+            qCWarning(nysseGame) << "Could not write inputs to" << recordPath_;
+        }
+    }
+    if( !snapshotPath_.isEmpty() && gameStarted_ )
+    {
+        // Written aside and renamed, so a failed write keeps the old snapshot
+        QSaveFile file( snapshotPath_ );
+        bool saved = false;
+        if( file.open( QIODevice::WriteOnly ) )
+        {
+            QDataStream out( &file );
+            saved = saveGame( out ) && file.commit();
+        }
+        if( !saved )
+        {
+            qCWarning(nysseGame) << "Could not write a snapshot to" << snapshotPath_;
+        }
+    }
     delete ui;
     delete gameSpeed;
     delete player_;
@@ -117,19 +178,348 @@ void GameWindow::setGameMode( GameMode gameMode )
 
 void GameWindow::createGameLogic(QTime gameTime)
 {
+    // Game time does not run while loading
+    gameSpeed->stop();
+    playingTimer_->stop();
+    if( gameEndingTimer_ != nullptr )
+    {
+        gameEndingTimer_->stop();
+    }
+
+    loadingDialog_ = new QProgressDialog( tr("Loading bus data..."), QString(),
+                                          0, 100, this );
+    loadingDialog_->setWindowModality( Qt::WindowModal );
+    loadingDialog_->setMinimumDuration( 0 );
+    loadingDialog_->setValue( 0 );
+
     logic_ = new CourseSide::Logic();
+    if( !recordPath_.isEmpty() )
+    {
+        inputLog_.setStart( quint32( QTime::currentTime().msecsSinceStartOfDay() ),
+                            gameTime, gameMode_ );
+        logic_->setSeed( inputLog_.seed() );
+    }
+    connect( logic_, &CourseSide::Logic::loadingProgress, loadingDialog_,
+             &QProgressDialog::setValue );
+    connect( logic_, &CourseSide::Logic::offlineDataLoaded, this,
+             &GameWindow::startLoadedGame );
     logic_->takeCity( gameCity_ );
-    logic_->fileConfig();
+    logic_->takeStatistics( statistics_ );
+    // Passengers persuaded to the tram stops are saved in snapshots too
+    logic_->addGameStop( gameCity_->giveTramStop1() );
+    logic_->addGameStop( gameCity_->giveTramStop2() );
     logic_->setTime( gameTime.hour(), gameTime.minute() );
+    logic_->fileConfigAsync();
+}
+
+void GameWindow::recordTo(const QString &path)
+{
+    recordPath_ = path;
+}
+
+void GameWindow::snapshotTo(const QString &path)
+{
+    snapshotPath_ = path;
+}
+
+void GameWindow::statisticsTo(const QString &path)
+{
+    statisticsPath_ = path;
+}
+
+bool GameWindow::writeStatistics() const
+{
+    QSaveFile file( statisticsPath_ );
+    if( statisticsPath_.endsWith( ".csv", Qt::CaseInsensitive ) )
+    {
+        if( !file.open( QIODevice::WriteOnly | QIODevice::Text ) )
+        {
+            return false;
+        }
+        QTextStream out( &file );
+        statistics_->writeCsv( out );
+        out.flush();
+        return out.status() == QTextStream::Ok && file.commit();
+    }
+
+    if( !file.open( QIODevice::WriteOnly ) )
+    {
+        return false;
+    }
+    QDataStream out( &file );
+    return statistics_->writeBinary( out ) && file.commit();
+}
+
+bool GameWindow::resumeFrom(const QString &path)
+{
+    QFile file( path );
+    if( !file.open( QIODevice::ReadOnly ) )
+    {
+        return false;
+    }
+    QByteArray snapshot = file.readAll();
+
+    // The game mode is needed before the data is loaded, the rest is read
+    // when the game starts
+    QDataStream in( snapshot );
+    in.setVersion( QDataStream::Qt_5_15 );
+    quint32 magic = 0;
+    quint16 version = 0;
+    qint32 gameMode = -1;
+    in >> magic >> version >> gameMode;
+    if( in.status() != QDataStream::Ok || magic != SNAPSHOT_MAGIC ||
+            version != SNAPSHOT_VERSION ||
+            ( gameMode != TIME_GOAL && gameMode != PASSENGER_GOAL ) )
+    {
+        return false;
+    }
+
+    // A recording would start from the middle of a game it cannot replay
+    recordPath_.clear();
+    resumeSnapshot_ = snapshot;
+    setGameMode( GameMode( gameMode ) );
+    createGameLogic( QTime( 0, 0 ) );
+    return true;
+}
+
+bool GameWindow::saveGame(QDataStream &out) const
+{
+    out.setVersion( QDataStream::Qt_5_15 );
+    out << SNAPSHOT_MAGIC << SNAPSHOT_VERSION << qint32( gameMode_ )
+        << qint32( min_ ) << qint32( sec_ );
+    if( !logic_->saveSnapshot( out ) )
+    {
+        return false;
+    }
+    player_->saveState( out );
+    police_->saveState( out );
+    gameCity_->saveState( out );
+    statistics_->saveState( out );
+    return out.status() == QDataStream::Ok;
+}
+
+bool GameWindow::restoreGame(QDataStream &in)
+{
+    in.setVersion( QDataStream::Qt_5_15 );
+    quint32 magic = 0;
+    quint16 version = 0;
+    qint32 gameMode = -1;
+    qint32 min = 0;
+    qint32 sec = 0;
+    in >> magic >> version >> gameMode >> min >> sec;
+    if( in.status() != QDataStream::Ok || magic != SNAPSHOT_MAGIC ||
+            version != SNAPSHOT_VERSION || gameMode != gameMode_ ||
+            min < 0 || sec < 0 || sec >= 60 )
+    {
+        return false;
+    }
+
+    // Logic gives the city its stops and actors and tells the statistics
+    // about them, the saved statistics then replace those counts
+    if( !logic_->restoreSnapshot( in ) || !player_->restoreState( in ) ||
+            !police_->restoreState( in ) || !gameCity_->restoreState( in ) ||
+            !statistics_->restoreState( in ) )
+    {
+        return false;
+    }
+
+    min_ = min;
+    sec_ = sec;
+    ui->lcdMinutes->display( min_ );
+    ui->lcdSeconds->display( sec_ );
+    playerIcon_->setPixmap( QPixmap( player_->getPix() ) );
+    changeActionText();
+    movePlayerIcon();
+    rotateIcon();
+    movePoliceIcon();
+    bool tram = player_->getType() == 2;
+    ui->rightRotateButton->setDisabled( tram );
+    ui->leftRotateButton->setDisabled( tram );
+    ui->actionButton->setDisabled( tram );
+    updateScores();
+    return true;
+}
+
+int GameWindow::replay(const Game::InputLog &log)
+{
+    setGameMode( GameMode( log.gameMode() ) );
+    gameSpeed->stop();
+    playingTimer_->stop();
+    if( gameEndingTimer_ != nullptr )
+    {
+        gameEndingTimer_->stop();
+    }
+
+    logic_ = new CourseSide::Logic();
+    logic_->setSeed( log.seed() );
+    logic_->takeCity( gameCity_ );
+    logic_->takeStatistics( statistics_ );
+    logic_->fileConfig();
+    logic_->setTime( log.startTime().hour(), log.startTime().minute() );
     logic_->finalizeGameStart();
+
+    // Timers of the window and the logic do not fire, events are not processed.
+    // Each input is applied after the logic ticks and the input steps that
+    // were run before it in the recorded game.
+    QElapsedTimer replayClock;
+    replayClock.start();
+    simulatedMs_ = 0;
+    heldKeys_.restart( simulatedMs_ );
+    auto next = log.events().begin();
+    for( ;; )
+    {
+        for( ; next != log.events().end() && next->tick == logic_->ticks(); ++next )
+        {
+            runInputSteps( next->msecs );
+            applyInput( *next );
+        }
+        if( logic_->ticks() >= log.endTick() || gameCity_->isGameOver() )
+        {
+            break;
+        }
+        logic_->increaseTime();
+        renderFrame();
+    }
+    runInputSteps( log.endMsecs() );
+    renderFrame();
+
+    qCInfo(nysseGame) << "Replayed" << logic_->ticks() << "ticks and"
+                      << ( next - log.events().begin() ) << "inputs in"
+                      << replayClock.elapsed() << "ms, score"
+                      << statistics_->getScore();
+    return 0;
+}
+
+void GameWindow::recordInput(Game::InputType type, qint32 value, qint64 msecs)
+{
+    if( recordPath_.isEmpty() || logic_ == nullptr )
+    {
+        return;
+    }
+    inputLog_.append( logic_->ticks(), msecs, type, value );
+}
+
+void GameWindow::applyInput(const Game::InputEvent &event)
+{
+    switch( event.type )
+    {
+    case Game::InputType::KEY_PRESS:
+        heldKeys_.press( event.value, event.msecs );
+        break;
+    case Game::InputType::KEY_RELEASE:
+        heldKeys_.release( event.value, event.msecs );
+        break;
+    case Game::InputType::SKIP:
+        simulatedMs_ += event.value;
+        heldKeys_.restart( simulatedMs_ );
+        break;
+    case Game::InputType::BUTTON:
+        if( QAbstractButton* button = inputButton( Game::Button( event.value ) ) )
+        {
+            button->click();
+        }
+        break;
+    }
+}
+
+QAbstractButton *GameWindow::inputButton(Game::Button button) const
+{
+    switch( button )
+    {
+    case Game::Button::WALKER:
+        return ui->walkerButton;
+    case Game::Button::BIKER:
+        return ui->bikerButton;
+    case Game::Button::TRAM:
+        return ui->tramButton;
+    case Game::Button::FORWARD:
+        return ui->forwardButton;
+    case Game::Button::BACKWARD:
+        return ui->backwardButton;
+    case Game::Button::LEFT_ROTATE:
+        return ui->leftRotateButton;
+    case Game::Button::RIGHT_ROTATE:
+        return ui->rightRotateButton;
+    case Game::Button::ACTION:
+        return ui->actionButton;
+    case Game::Button::QUIT:
+        return ui->quitButton;
+    }
+    return nullptr;
+}
+
+void GameWindow::startLoadedGame( bool success )
+{
+    loadingDialog_->close();
+    loadingDialog_->deleteLater();
+    loadingDialog_ = nullptr;
+    if( !success )
+    {
+        // Back to the settings, which stay open under the game window. A
+        // game that never started leaves no recording behind.
+        QMessageBox::critical( this, tr("Nysse"),
+                               tr("The bus and stop data could not be read.") );
+        recordPath_.clear();
+        close();
+        deleteLater();
+        return;
+    }
+
+    // Stops and actors are added to the scene in one batch: the view is
+    // repainted and the scene index built once instead of for every item.
+    ui->graphicsView->setUpdatesEnabled( false );
+    scene_->setItemIndexMethod( QGraphicsScene::NoIndex );
+    bool started = true;
+    if( resumeSnapshot_.isEmpty() )
+    {
+        logic_->finalizeGameStart();
+    }
+    else
+    {
+        QDataStream in( resumeSnapshot_ );
+        started = restoreGame( in );
+        resumeSnapshot_.clear();
+    }
+    scene_->setItemIndexMethod( QGraphicsScene::BspTreeIndex );
+    ui->graphicsView->setUpdatesEnabled( true );
+    if( !started )
+    {
+        QMessageBox::critical( this, tr("Nysse"),
+                               tr("The snapshot is corrupt or was saved with other bus and stop data.") );
+        snapshotPath_.clear();
+        close();
+        deleteLater();
+        return;
+    }
+    gameStarted_ = true;
+
+    restartInput();
+    gameSpeed->start( FRAME_MS );
+    playingTimer_->start( 1000 );
+    if( gameEndingTimer_ != nullptr )
+    {
+        // The whole playing time in a new game, what was left in a resumed one
+        gameEndingTimer_->start( ( min_ * 60 + sec_ ) * 1000 );
+    }
+
+    qint64 readyMs = startClock_.elapsed();
+    qCInfo(nysseGame) << "Time to interactive:" << readyMs << "ms";
+    setWindowTitle( tr("%1 (ready in %2 ms)").arg( windowTitle() ).arg( readyMs ) );
 }
 
 void GameWindow::setMap(QImage &basicbackground, QImage &bigbackground)
 {
     int w = scene_->width();
     int h = scene_->height();
-    scene_->addPixmap( QPixmap::fromImage( basicbackground ).scaled(
-                           w,h,Qt::KeepAspectRatio, Qt::SmoothTransformation));
+    QImage shown = basicbackground.scaled( w, h, Qt::KeepAspectRatio,
+                                           Qt::SmoothTransformation );
+    scene_->addPixmap( QPixmap::fromImage( shown ) );
+
+    // Police follow the streets of the shown map around water
+    int width = Game::Coordinates::BORDER_RIGHT + 1;
+    int height = Game::Coordinates::BORDER_DOWN + 1;
+    flowField_.setWalkable( width, height,
+                            Game::FlowField::walkableCells( shown, width, height ) );
 }
 
 void GameWindow::on_walkerButton_clicked()
@@ -196,35 +586,168 @@ void GameWindow::rotateIcon()
 
 void GameWindow::keyPressEvent(QKeyEvent* event)
 {
-    keysPressed_ += event->key();
+    // Held keys are down already, repeats are not recorded or measured. Keys
+    // are not timed while the game is loading or has ended.
+    if( event->isAutoRepeat() || !gameSpeed->isActive() )
+    {
+        return;
+    }
+    // Steps before the press are run first, in the same order as a replay
+    qint64 now = inputClock_.elapsed();
+    simulateInput( now );
+    recordInput( Game::InputType::KEY_PRESS, event->key(), now );
+    heldKeys_.press( event->key(), now );
+    if( unshownInputUsecs_ < 0 )
+    {
+        unshownInputUsecs_ = inputClock_.nsecsElapsed() / 1000;
+    }
 }
 
 void GameWindow::keyReleaseEvent(QKeyEvent* event)
 {
-    keysPressed_ -= event->key();
+    if( event->isAutoRepeat() || !gameSpeed->isActive() )
+    {
+        return;
+    }
+    qint64 now = inputClock_.elapsed();
+    simulateInput( now );
+    recordInput( Game::InputType::KEY_RELEASE, event->key(), now );
+    heldKeys_.release( event->key(), now );
 }
 
 void GameWindow::moveQueue()
 {
-    foreach(int key, keysPressed_)
+    QElapsedTimer frameClock;
+    frameClock.start();
+
+    simulateInput( inputClock_.elapsed() );
+    renderFrame();
+
+    statistics_->metrics().record( Game::Metrics::Histogram::FRAME_USECS,
+                                   quint64( frameClock.nsecsElapsed() / 1000 ) );
+}
+
+void GameWindow::restartInput()
+{
+    // Inputs are timed from the start of the game
+    inputClock_.restart();
+    simulatedMs_ = 0;
+    heldKeys_.restart( simulatedMs_ );
+    unshownInputUsecs_ = -1;
+    unpaintedInputUsecs_ = -1;
+}
+
+void GameWindow::simulateInput(qint64 msecs)
+{
+    if( msecs - simulatedMs_ > MAX_STEPS_PER_FRAME * STEP_MS )
     {
-        if(ui->forwardButton->isEnabled() and key == Qt::Key_W)
-        {
-            on_forwardButton_clicked();
-        }
-        else if(ui->leftRotateButton->isEnabled() and key == Qt::Key_A)
-        {
-            on_leftRotateButton_clicked();
-        }
-        else if(ui->backwardButton->isEnabled() and key == Qt::Key_S)
-        {
-            on_backwardButton_clicked();
-        }
-        else if(ui->rightRotateButton->isEnabled() and key == Qt::Key_D)
+        // Dropped time is recorded, a replay drops the same steps
+        qint64 skipped = msecs - MAX_STEPS_PER_FRAME * STEP_MS - simulatedMs_;
+        recordInput( Game::InputType::SKIP, qint32( skipped ), simulatedMs_ );
+        simulatedMs_ += skipped;
+        heldKeys_.restart( simulatedMs_ );
+    }
+    runInputSteps( msecs );
+}
+
+void GameWindow::runInputSteps(qint64 msecs)
+{
+    while( simulatedMs_ + STEP_MS <= msecs )
+    {
+        simulatedMs_ += STEP_MS;
+        stepInput( simulatedMs_ );
+    }
+}
+
+void GameWindow::stepInput(qint64 end)
+{
+    // Held time is taken also when it is not used, so it does not pile up
+    qint64 forward = heldKeys_.take( Qt::Key_W, end );
+    qint64 backward = heldKeys_.take( Qt::Key_S, end );
+    qint64 left = heldKeys_.take( Qt::Key_A, end );
+    qint64 right = heldKeys_.take( Qt::Key_D, end );
+    if( gameCity_->isGameOver() )
+    {
+        return;
+    }
+
+    if( !ui->leftRotateButton->isEnabled() )
+    {
+        left = 0;
+    }
+    if( !ui->rightRotateButton->isEnabled() )
+    {
+        right = 0;
+    }
+    rotationCarry_ += double( ROTATION_STEP * ( left - right ) ) / MOVE_INTERVAL_MS;
+    int degrees = int( rotationCarry_ );
+    if( degrees != 0 )
+    {
+        player_->changeRotation( degrees, true );
+        rotationCarry_ -= degrees;
+    }
+
+    if( !ui->forwardButton->isEnabled() )
+    {
+        forward = 0;
+    }
+    if( !ui->backwardButton->isEnabled() )
+    {
+        backward = 0;
+    }
+    if( forward > 0 )
+    {
+        player_->movePlayer( 1, double( forward ) / MOVE_INTERVAL_MS );
+    }
+    if( backward > 0 )
+    {
+        player_->movePlayer( -1, double( backward ) / MOVE_INTERVAL_MS );
+    }
+    // Police chase at their own pace, also while the player stands still
+    stepPolice( float( STEP_MS ) / MOVE_INTERVAL_MS );
+}
+
+void GameWindow::renderFrame()
+{
+    movePlayerIcon();
+    rotateIcon();
+    movePoliceIcon();
+    updateScores();
+
+    if( unshownInputUsecs_ >= 0 )
+    {
+        if( unpaintedInputUsecs_ < 0 )
         {
-            on_rightRotateButton_clicked();
+            unpaintedInputUsecs_ = unshownInputUsecs_;
         }
+        unshownInputUsecs_ = -1;
+        // Measured also when the input changed nothing on the scene
+        ui->graphicsView->viewport()->update();
+    }
+}
+
+bool GameWindow::eventFilter(QObject *watched, QEvent *event)
+{
+    if( event->type() == QEvent::Paint && unpaintedInputUsecs_ >= 0 &&
+            watched == ui->graphicsView->viewport() )
+    {
+        qint64 input = unpaintedInputUsecs_;
+        unpaintedInputUsecs_ = -1;
+        // Runs after the paint has been flushed to the window
+        QMetaObject::invokeMethod( this, [this, input]() {
+            statistics_->metrics().record(
+                        Game::Metrics::Histogram::INPUT_LATENCY_USECS,
+                        quint64( inputClock_.nsecsElapsed() / 1000 - input ) );
+        }, Qt::QueuedConnection );
     }
+    return QDialog::eventFilter( watched, event );
+}
+
+void GameWindow::updateScores()
+{
+    ui->PointsPlaceholder->setNum(statistics_->getScore());
+    ui->BusDestroyedScore->setText(QString::number(
+                                       statistics_->getDestroyedBuses()));
 }
 
 void GameWindow::on_forwardButton_clicked()
@@ -233,7 +756,6 @@ void GameWindow::on_forwardButton_clicked()
     {
         player_->movePlayer(1);
         movePlayerIcon();
-        movePolice();
     }
 }
 
@@ -252,7 +774,6 @@ void GameWindow::on_backwardButton_clicked()
     {
         player_->movePlayer(-1);
         movePlayerIcon();
-        movePolice();
     }
 }
 
@@ -274,9 +795,6 @@ void GameWindow::on_actionButton_clicked()
         {
             statistics_->nysseRemoved();
         }
-        ui->PointsPlaceholder->setNum(statistics_->getScore());
-        ui->BusDestroyedScore->setText(QString::number(
-                                           statistics_->getDestroyedBuses()));
     }
     else if(player_->getType() == 1)
     {
@@ -290,85 +808,110 @@ void GameWindow::on_actionButton_clicked()
 
 void GameWindow::addStopToScene(std::shared_ptr<Interface::IStop> stop)
 {
-    Game::Coordinates c;
     double east = stop->getLocation().giveEasternCoord();
     double north = stop->getLocation().giveNorthernCoord();
-    int xCoord = c.xFromEast(east);
-    int yCoord = c.yFromNorth(north);
+    int xCoord = Game::Coordinates::xFromEast(east);
+    int yCoord = Game::Coordinates::yFromNorth(north);
     int deltaX = STOP_SIZE/2;
     int deltaY = STOP_SIZE/2;
 
-    if( xCoord < c.BORDER_LEFT || xCoord > c.BORDER_RIGHT ||
-            yCoord < c.BORDER_UP || yCoord > c.BORDER_DOWN )
+    if( xCoord < Game::Coordinates::BORDER_LEFT ||
+            xCoord > Game::Coordinates::BORDER_RIGHT ||
+            yCoord < Game::Coordinates::BORDER_UP ||
+            yCoord > Game::Coordinates::BORDER_DOWN )
     {
         return;
     }
-    scene_->addRect( xCoord - deltaX, c.BORDER_DOWN-yCoord - deltaY,
+    scene_->addRect( xCoord - deltaX, Game::Coordinates::BORDER_DOWN-yCoord - deltaY,
                      STOP_SIZE, STOP_SIZE, QPen(Qt::black),STOP_COLOR);
 }
 
+void GameWindow::addStopsToScene(
+        const std::vector<std::shared_ptr<Interface::IStop> > &stops)
+{
+    for( const auto& stop : stops )
+    {
+        addStopToScene( stop );
+    }
+}
+
 void GameWindow::addTramStopToScene(std::shared_ptr<Interface::IStop> tramStop)
 {
-    Game::Coordinates c;
     double east = tramStop->getLocation().giveEasternCoord();
     double north = tramStop->getLocation().giveNorthernCoord();
-    int xCoord = c.xFromEast(east);
-    int yCoord = c.yFromNorth(north);
+    int xCoord = Game::Coordinates::xFromEast(east);
+    int yCoord = Game::Coordinates::yFromNorth(north);
     int deltaX = STOP_SIZE/2;
     int deltaY = STOP_SIZE/2;
 
-    scene_->addRect(xCoord-deltaX, c.BORDER_DOWN-yCoord-deltaY,
+    scene_->addRect(xCoord-deltaX, Game::Coordinates::BORDER_DOWN-yCoord-deltaY,
                      STOP_SIZE, STOP_SIZE, QPen(Qt::black), TRAM_STOP_COLOR );
 }
 
 void GameWindow::addActorToScene(const std::shared_ptr<Interface::IActor> &newactor,
                                  QGraphicsPixmapItem *&newactorGraphics)
 {
-    Game::Coordinates c;
     double east = newactor->giveLocation().giveEasternCoord();
     double north = newactor->giveLocation().giveNorthernCoord();
-    int xCoord = c.xFromEast(east);
-    int yCoord = c.yFromNorth(north);
+    int xCoord = Game::Coordinates::xFromEast(east);
+    int yCoord = Game::Coordinates::yFromNorth(north);
     int deltaX = 0;
     int deltaY = 0;
 
-    if( typeid ( *newactor) == typeid ( CourseSide::Nysse) )
+    switch( newactor->getKind() )
     {
+    case Interface::ActorKind::VEHICLE:
         deltaX = BUS_PICTURE.size().width()/2;
         deltaY = BUS_PICTURE.size().height()/2;
         newactorGraphics = scene_->addPixmap( BUS_PICTURE );
-    }
-    else if( typeid ( *newactor ) == typeid ( CourseSide::Passenger ) )
-    {
+        break;
+    case Interface::ActorKind::PASSENGER:
         deltaX = PASSENGER_PICTURE.size().width()/2;
         deltaY = PASSENGER_PICTURE.size().height()/2;
         newactorGraphics = scene_->addPixmap( PASSENGER_PICTURE );
+        break;
+    default:
+        break;
+    }
+    newactorGraphics->setPos(xCoord-deltaX,
+                             Game::Coordinates::BORDER_DOWN-yCoord-deltaY);
+}
+
+void GameWindow::addActorsToScene(
+        const std::vector<std::shared_ptr<Interface::IActor> > &newactors,
+        std::vector<QGraphicsPixmapItem *> &newactorGraphics)
+{
+    for( std::size_t i = 0; i < newactors.size(); ++i )
+    {
+        addActorToScene( newactors[i], newactorGraphics[i] );
     }
-    newactorGraphics->setPos(xCoord-deltaX, c.BORDER_DOWN-yCoord-deltaY);
 }
 
 void GameWindow::moveActorOnScene(const std::shared_ptr<Interface::IActor>&
                                   actor, QGraphicsPixmapItem *&actorGraphics)
 {
-    Game::Coordinates c;
     double east = actor->giveLocation().giveEasternCoord();
     double north = actor->giveLocation().giveNorthernCoord();
-    int newXCoord = c.xFromEast(east);
-    int newYCoord = c.yFromNorth(north);
+    int newXCoord = Game::Coordinates::xFromEast(east);
+    int newYCoord = Game::Coordinates::yFromNorth(north);
     int deltaX = 0;
     int deltaY = 0;
 
-    if( typeid ( *actor) == typeid ( CourseSide::Nysse) )
+    switch( actor->getKind() )
     {
+    case Interface::ActorKind::VEHICLE:
         deltaX = BUS_PICTURE.size().width()/2;
         deltaY = BUS_PICTURE.size().height()/2;
-    }
-    else if( typeid ( *actor ) == typeid ( CourseSide::Passenger ) )
-    {
+        break;
+    case Interface::ActorKind::PASSENGER:
         deltaX = PASSENGER_PICTURE.size().width()/2;
         deltaY = PASSENGER_PICTURE.size().height()/2;
+        break;
+    default:
+        break;
     }
-    actorGraphics->setPos(newXCoord-deltaX, c.BORDER_DOWN-newYCoord-deltaY);
+    actorGraphics->setPos(newXCoord-deltaX,
+                          Game::Coordinates::BORDER_DOWN-newYCoord-deltaY);
 }
 
 void GameWindow::isTramNearStops()
@@ -378,7 +921,7 @@ void GameWindow::isTramNearStops()
     if( player_->giveLocation().isClose(
                 gameCity_->giveTramStop1()->getLocation() ) )
     {
-        if( player_->getPassengers().empty() )
+        if( player_->passengers().empty() )
         {
             ui->actionButton->setEnabled( true );
         }
@@ -386,7 +929,7 @@ void GameWindow::isTramNearStops()
     else if( player_->giveLocation().isClose(
                  gameCity_->giveTramStop2()->getLocation() ) )
     {
-        if( !( player_->getPassengers().empty() ) )
+        if( !( player_->passengers().empty() ) )
         {
             ui->actionButton->setEnabled( true );
         }
@@ -428,16 +971,23 @@ void GameWindow::changePlayingTime()
 void GameWindow::movePoliceIcon()
 {
     int h = scene_->height();
-    int dy = policeIcon_->boundingRect().height()/2;
-    int dx = policeIcon_->boundingRect().width()/2;
-    policeIcon_->setPos(police_->getX()-dx, h-police_->getY()-dy);
+    for( std::size_t i = 0; i < policeIcons_.size(); ++i )
+    {
+        int dy = policeIcons_[i]->boundingRect().height()/2;
+        int dx = policeIcons_[i]->boundingRect().width()/2;
+        policeIcons_[i]->setPos(police_->getX(i)-dx, h-police_->getY(i)-dy);
+    }
 }
 void GameWindow::movePolice()
 {
-    police_->updateRotation(player_->getX(), player_->getY());
-    police_->approachPlayer();
+    stepPolice(1.0f);
     movePoliceIcon();
-    //qDebug() << "Police location: X:" << police_->getX() << " Y:" << police_->getY() << " Rotation:" << police_->getRotation();
+}
+
+void GameWindow::stepPolice(float portion)
+{
+    flowField_.setTarget(player_->getX(), player_->getY());
+    police_->steer(player_->getX(), player_->getY(), portion);
 }
 
 void GameWindow::showGameEnded()
@@ -449,6 +999,16 @@ void GameWindow::showGameEnded()
     }
     gameSpeed->stop();
     playingTimer_->stop();
+    updateScores();
+
+    const Game::Metrics& metrics = statistics_->metrics();
+    qCInfo(nysseGame) << "Input to photon latency p50"
+                      << metrics.percentile( Game::Metrics::Histogram::INPUT_LATENCY_USECS, 0.5 )
+                      << "us, p99"
+                      << metrics.percentile( Game::Metrics::Histogram::INPUT_LATENCY_USECS, 0.99 )
+                      << "us; frame p99"
+                      << metrics.percentile( Game::Metrics::Histogram::FRAME_USECS, 0.99 )
+                      << "us";
 
     ui->forwardButton->setDisabled(true);
     ui->backwardButton->setDisabled(true);
@@ -460,6 +1020,11 @@ void GameWindow::showGameEnded()
     ui->tramButton->setDisabled(true);
 
     ui->actionButton->setDisabled(true);
+
+    if( !statisticsPath_.isEmpty() && !writeStatistics() )
+    {
+        qCWarning(nysseGame) << "Could not write statistics to" << statisticsPath_;
+    }
     qDebug() << "GG WP";
 }
 
@@ -2,18 +2,22 @@
 #define GAMEWINDOW_H
 
 #include "city.hh"
+#include "inputlog.hh"
 #include "player.h"
-#include "police.h"
+#include "policeforce.h"
 #include "statistics.hh"
 #include "core/location.hh"
 #include "core/logic.hh"
 #include "coordinates.h"
+#include "flowfield.h"
+#include "heldkeys.h"
 
+#include <QByteArray>
 #include <QDialog>
+#include <QElapsedTimer>
 #include <QGraphicsScene>
 #include <QGraphicsPixmapItem>
 #include <QKeyEvent>
-#include <QSet>
 #include <QTimer>
 
 enum GameMode { TIME_GOAL, PASSENGER_GOAL };
@@ -22,6 +26,10 @@ namespace Ui {
 class GameWindow;
 }
 
+class QAbstractButton;
+class QDataStream;
+class QProgressDialog;
+
 /**
  * @brief The GameWindow class, the window where the whole game happens.
  *
@@ -65,9 +73,79 @@ public:
      * @param gameTime is the starting time in game
      *
      * Creates and initiates a logic objec that handles the game logic.
+     * Offline data is read in a worker thread while a progress dialog is
+     * shown, the game starts in startLoadedGame when the data has been read.
      */
     void createGameLogic( QTime gameTime );
 
+    /**
+     * @brief recordTo function
+     * @param path file the inputs of the game are written to
+     * @pre called before createGameLogic
+     * @post Key and button inputs are recorded with a random seed and the
+     * log is written when the window is destroyed.
+     */
+    void recordTo( const QString& path );
+
+    /**
+     * @brief snapshotTo function
+     * @param path file the state of the game is written to
+     * @post The snapshot is written when the window is destroyed, if the
+     * game was started. A failed write leaves an older file untouched.
+     */
+    void snapshotTo( const QString& path );
+
+    /**
+     * @brief statisticsTo function
+     * @param path file the statistics of the game are written to
+     * @post The minute series of the statistics are written when the game
+     * ends, as CSV if path ends with .csv, else in the binary format of
+     * Statistics::writeBinary.
+     */
+    void statisticsTo( const QString& path );
+
+    /**
+     * @brief resumeFrom function
+     * @param path snapshot written with snapshotTo
+     * @return false if the file cannot be read or is not a snapshot
+     * @post On true, the data files are loaded like in createGameLogic and
+     * the game continues from the snapshot instead of a new game. If the
+     * snapshot does not match the data, an error is shown and the window
+     * closes.
+     */
+    bool resumeFrom( const QString& path );
+
+    /**
+     * @brief saveGame function
+     * @param out stream the game is written to
+     * @return true if the game was written
+     *
+     * Writes the game mode and playing time, the simulation of Logic with
+     * its random numbers, the player, the police, the city and the
+     * statistics with the score.
+     */
+    bool saveGame( QDataStream& out ) const;
+
+    /**
+     * @brief restoreGame function
+     * @param in stream to read a game written by saveGame from
+     * @return true if the game was started from the stream
+     * @pre offline data is loaded and the game is not started
+     */
+    bool restoreGame( QDataStream& in );
+
+    /**
+     * @brief replay function
+     * @param log inputs recorded with recordTo
+     * @return 0 when the log has been replayed
+     *
+     * Plays the recorded game again without showing the window and without
+     * waiting for timers, as fast as possible. Logic::increaseTime is run
+     * up to the tick of each recorded input and the input simulation up to
+     * its time before the input is applied.
+     */
+    int replay( const Game::InputLog& log );
+
     /**
      * @brief playerChange function
      * @param type int value of the playertype
@@ -102,7 +180,7 @@ public:
     /**
      * @brief movePoliceIcon funtion
      *
-     * Updates policeIcon to new location on the scene from police location
+     * Updates policeIcons to new locations on the scene from police location
      * data.
      */
     void movePoliceIcon();
@@ -110,18 +188,90 @@ public:
     /**
      * @brief movePolice function
      *
-     * Updates police rotation pointing to the player and moves to that
-     * direction
+     * Steps the police a full step and shows them
      */
     void movePolice();
 
+    /**
+     * @brief stepPolice function
+     * @param portion portion of a full step the police move
+     *
+     * Moves the target of flowField_ to the player and steps every police
+     * unit along it in one batch
+     */
+    void stepPolice( float portion );
+
+    /**
+     * @brief updateScores function
+     *
+     * Shows the score and destroyed buses merged from the metrics of
+     * statistics_. Called once per frame, not for every counted event.
+     */
+    void updateScores();
+
+    /**
+     * @brief restartInput function
+     *
+     * Starts inputClock_ and the input simulation from 0 when the game
+     * starts, so that loading time is not simulated.
+     */
+    void restartInput();
+
+    /**
+     * @brief simulateInput function
+     * @param msecs time of inputClock_ to simulate to
+     *
+     * Runs fixed steps of STEP_MS until msecs. At most MAX_STEPS_PER_FRAME
+     * steps are run, older time is dropped and recorded as a skip.
+     */
+    void simulateInput( qint64 msecs );
+
+    /**
+     * @brief runInputSteps function
+     * @param msecs time to simulate to
+     *
+     * Runs all fixed steps of STEP_MS that end at or before msecs. Replays
+     * use this directly, their dropped time comes from the recorded skips.
+     */
+    void runInputSteps( qint64 msecs );
+
+    /**
+     * @brief stepInput function
+     * @param end time the step ends at
+     *
+     * Moves and rotates the player for the time W, S, A and D were held
+     * during the step, and steps the police for the length of the step.
+     * Icons are not updated, see renderFrame.
+     */
+    void stepInput( qint64 end );
+
+    /**
+     * @brief renderFrame function
+     *
+     * Updates the icons and scores once after the steps of a frame. Marks
+     * the oldest input not yet shown to be measured when the view is
+     * painted.
+     */
+    void renderFrame();
+
+    /**
+     * @brief eventFilter
+     * @param watched object the event is for
+     * @param event event to filter
+     * @return false, events are not filtered out
+     *
+     * Measures input to photon latency when the viewport of the view is
+     * painted after an input.
+     */
+    bool eventFilter( QObject* watched, QEvent* event ) override;
+
 private slots:
     /**
      * @brief keyPressEvent
      * @param event that registers a keyboard keypress
      *
      * Runs when key is pressed in keyboard
-     * calls forward or backward moving functions if key W or S is pressed
+     * Marks the key held from the current time of inputClock_
      */
     void keyPressEvent(QKeyEvent *event);
 
@@ -130,17 +280,18 @@ private slots:
      * @param event that registers a keyboard keypress
      *
      * Runs when key is released
-     * Clears released keys from keysPressed if they are NOT A or D
+     * Marks the key released at the current time of inputClock_
      */
     void keyReleaseEvent(QKeyEvent *event);
 
     /**
      * @brief moveQueue
      *
-     * Reads set (keysPressed_) and empties keysPressed on A or D
-     * Causes a continuous movement on the map and must be done this way.
-     * Othervice the movement couldn't handle multiple keypresses at once.
-     * This will be run on every 100 ms with gameSpeed timeout-signal
+     * Runs a frame: simulates the held keys up to the current time in fixed
+     * steps and renders the result once. Movement depends on how long keys
+     * were held, not on how often frames run.
+     * This will be run on every FRAME_MS with gameSpeed timeout-signal
+     * Time spent in the frame is recorded in the FRAME_USECS histogram.
      */
     void moveQueue();
 
@@ -208,6 +359,14 @@ private slots:
      */
     void addStopToScene( std::shared_ptr< Interface::IStop > stop );
 
+    /**
+     * @brief addStopsToScene
+     * @param stops data pointers
+     *
+     * Adds stops that are within the game borders on screen
+     */
+    void addStopsToScene( const std::vector< std::shared_ptr< Interface::IStop > >& stops );
+
     /**
      * @brief addTramStopToScene
      * @param tramStop tram stop pointer
@@ -228,6 +387,16 @@ private slots:
     void addActorToScene( const std::shared_ptr< Interface::IActor >& newactor,
                           QGraphicsPixmapItem*& newactorGraphics );
 
+    /**
+     * @brief addActorsToScene
+     * @param newactors data pointers
+     * @param newactorGraphics graphics for each actor, same size as newactors
+     *
+     * Adds actors (buses or passengers) to screen like addActorToScene
+     */
+    void addActorsToScene( const std::vector< std::shared_ptr< Interface::IActor > >& newactors,
+                           std::vector< QGraphicsPixmapItem* >& newactorGraphics );
+
     /**
      * @brief setMap
      * @param basicbackground
@@ -276,18 +445,89 @@ private slots:
      */
     void on_quitButton_clicked();
 
+    /**
+     * @brief startLoadedGame
+     * @param success true if offline data was read
+     *
+     * Populates the scene in a single batch from a new game or the snapshot
+     * given to resumeFrom, starts the game timers and shows the time it took
+     * from the start click to a playable game. If the data could not be read
+     * or the snapshot does not fit it, shows an error and closes the window,
+     * which returns to the settings.
+     */
+    void startLoadedGame( bool success );
+
+    /**
+     * @brief recordInput
+     * @param type kind of the input
+     * @param value key, button or skipped milliseconds of the input
+     * @param msecs time of the input simulation at the input
+     *
+     * Adds the input to inputLog_ at the current logic tick when recording
+     */
+    void recordInput( Game::InputType type, qint32 value, qint64 msecs );
+
+    /**
+     * @brief applyInput
+     * @param event recorded input
+     *
+     * Does what the recorded key event, button click or skip did
+     */
+    void applyInput( const Game::InputEvent& event );
+
+    /**
+     * @brief inputButton
+     * @param button button of an input event
+     * @return the button of the window
+     */
+    QAbstractButton* inputButton( Game::Button button ) const;
+
+    /**
+     * @brief writeStatistics
+     * @return false if the file given to statisticsTo cannot be written
+     *
+     * Writes the series of statistics_ to the file given to statisticsTo
+     */
+    bool writeStatistics() const;
+
 private:
     Ui::GameWindow *ui;
     QGraphicsScene *scene_;
     Game::Player* player_;
-    Game::Police* police_;
+    Game::PoliceForce* police_;
     Interface::Location targetLocation_;
     QGraphicsPixmapItem *playerIcon_;
-    QGraphicsPixmapItem *policeIcon_;
+    std::vector<QGraphicsPixmapItem*> policeIcons_;
+    // Shortest ways to the player around water, searched when the player
+    // moves to another cell
+    Game::FlowField flowField_;
     QGraphicsPixmapItem *directionIcon_;
-    QSet<int> keysPressed_;
     QTimer* gameSpeed;
 
+    // Time between frames, each frame renders once
+    const int FRAME_MS = 16;
+    // Length of a fixed step of the input simulation
+    const qint64 STEP_MS = 20;
+    // Holding a key this long moves a full step or rotates ROTATION_STEP
+    const qint64 MOVE_INTERVAL_MS = 100;
+    const int ROTATION_STEP = 15;
+    // Steps run by one frame at most, after a stall the rest is dropped
+    const qint64 MAX_STEPS_PER_FRAME = 10;
+
+    // Clock of input timestamps and the input simulation
+    QElapsedTimer inputClock_;
+    Game::HeldKeys heldKeys_;
+    // Time the input simulation has reached
+    qint64 simulatedMs_;
+    // Rotation not yet applied, the player turns in whole degrees
+    double rotationCarry_;
+    // Time of the oldest input not rendered, -1 if none
+    qint64 unshownInputUsecs_;
+    // Time of the rendered input waiting for a paint, -1 if none
+    qint64 unpaintedInputUsecs_;
+    // Police units chasing the player
+    const std::size_t POLICE_UNITS = 1;
+
     const std::vector<QString> ACTIONTEXT=
     {
         "As a walker, you can break stationary bus and all the passengers have to exit the bus.",
@@ -305,6 +545,18 @@ private:
     Game::Statistics* statistics_;
     CourseSide::Logic* logic_;
 
+    // Started when the game is created from the settings
+    QElapsedTimer startClock_;
+    QProgressDialog* loadingDialog_;
+
+    Game::InputLog inputLog_;
+    QString recordPath_;
+    QString snapshotPath_;
+    QString statisticsPath_;
+    // Snapshot the game is resumed from, empty for a new game
+    QByteArray resumeSnapshot_;
+    bool gameStarted_;
+
     const QPixmap BUS_PICTURE = QPixmap( "images/bus.png" );
     const QPixmap PASSENGER_PICTURE = QPixmap( "images/passenger.png" );
 
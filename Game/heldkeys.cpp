@@ -0,0 +1,66 @@
+#include "heldkeys.h"
+
+namespace Game
+{
+
+HeldKeys::HeldKeys()
+{
+}
+
+void HeldKeys::press(int key, qint64 msecs)
+{
+    State& state = keys_[key];
+    if( state.down )
+    {
+        return;
+    }
+    state.down = true;
+    state.since = msecs;
+}
+
+void HeldKeys::release(int key, qint64 msecs)
+{
+    auto found = keys_.find( key );
+    if( found == keys_.end() || !found->second.down )
+    {
+        return;
+    }
+    State& state = found->second;
+    state.held += qMax( msecs - state.since, qint64( 0 ) );
+    state.down = false;
+}
+
+qint64 HeldKeys::take(int key, qint64 msecs)
+{
+    auto found = keys_.find( key );
+    if( found == keys_.end() )
+    {
+        return 0;
+    }
+    State& state = found->second;
+    if( state.down && msecs > state.since )
+    {
+        state.held += msecs - state.since;
+        state.since = msecs;
+    }
+    qint64 held = state.held;
+    state.held = 0;
+    return held;
+}
+
+bool HeldKeys::isHeld(int key) const
+{
+    auto found = keys_.find( key );
+    return found != keys_.end() && found->second.down;
+}
+
+void HeldKeys::restart(qint64 msecs)
+{
+    for( auto& key : keys_ )
+    {
+        key.second.since = msecs;
+        key.second.held = 0;
+    }
+}
+
+}
@@ -0,0 +1,84 @@
+#ifndef HELDKEYS_H
+#define HELDKEYS_H
+
+#include <QtGlobal>
+#include <unordered_map>
+
+/**
+  * @file
+  * @brief Defines timestamped key states for integrating held keys.
+  */
+
+namespace Game
+{
+
+/**
+ * @brief The HeldKeys class
+ *
+ * Keeps when each key went down and how long it has been held since the
+ * simulation last asked. Times are milliseconds of the input clock of the
+ * window. A key pressed and released between two simulation steps still
+ * counts for the time it was down, so short taps are not lost and holding
+ * a key moves the same distance at any frame rate.
+ */
+class HeldKeys
+{
+public:
+    HeldKeys();
+
+    /**
+     * @brief press
+     * @param key key that went down
+     * @param msecs time of the event
+     *
+     * Repeated presses of a held key are ignored.
+     */
+    void press( int key, qint64 msecs );
+
+    /**
+     * @brief release
+     * @param key key that went up
+     * @param msecs time of the event
+     */
+    void release( int key, qint64 msecs );
+
+    /**
+     * @brief take
+     * @param key key to ask
+     * @param msecs end of the simulated step
+     * @return milliseconds the key was held since the previous take, up to
+     * msecs
+     * @post Held time of the key is consumed. Exception guarantee: nothrow
+     */
+    qint64 take( int key, qint64 msecs );
+
+    /**
+     * @brief isHeld
+     * @param key key to ask
+     * @return true if key is down
+     */
+    bool isHeld( int key ) const;
+
+    /**
+     * @brief restart forgets the held time before msecs
+     * @param msecs time the simulation continues from
+     *
+     * Used when the simulation was paused, held keys stay down.
+     */
+    void restart( qint64 msecs );
+
+private:
+    struct State
+    {
+        bool down;
+        // Start of the time not yet added to held
+        qint64 since;
+        // Time held and not yet taken
+        qint64 held;
+    };
+
+    std::unordered_map< int, State > keys_;
+};
+}
+
+#endif // HELDKEYS_H
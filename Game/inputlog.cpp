@@ -0,0 +1,157 @@
+#include "inputlog.hh"
+
+#include <QDataStream>
+#include <QFile>
+
+namespace Game
+{
+
+// "NYIL" and the version of the file format
+const quint32 InputLog::MAGIC = 0x4E59494C;
+const quint16 InputLog::VERSION = 2;
+
+InputLog::InputLog() : seed_(1), gameMode_(0), endTick_(0), endMsecs_(0)
+{
+
+}
+
+void InputLog::setStart(quint32 seed, QTime startTime, int gameMode)
+{
+    seed_ = seed;
+    startTime_ = startTime;
+    gameMode_ = gameMode;
+    endTick_ = 0;
+    endMsecs_ = 0;
+    events_.clear();
+}
+
+quint32 InputLog::seed() const
+{
+    return seed_;
+}
+
+QTime InputLog::startTime() const
+{
+    return startTime_;
+}
+
+int InputLog::gameMode() const
+{
+    return gameMode_;
+}
+
+void InputLog::append(quint64 tick, qint64 msecs, InputType type, qint32 value)
+{
+    Q_ASSERT( events_.empty() || events_.back().tick <= tick );
+    events_.push_back( InputEvent{ tick, msecs, type, value } );
+    endTick_ = tick;
+    endMsecs_ = qMax( endMsecs_, msecs );
+}
+
+void InputLog::finish(quint64 tick, qint64 msecs)
+{
+    endTick_ = qMax( endTick_, tick );
+    endMsecs_ = qMax( endMsecs_, msecs );
+}
+
+quint64 InputLog::endTick() const
+{
+    return endTick_;
+}
+
+qint64 InputLog::endMsecs() const
+{
+    return endMsecs_;
+}
+
+const std::vector<InputEvent> &InputLog::events() const
+{
+    return events_;
+}
+
+bool InputLog::save(const QString &path) const
+{
+    QFile file( path );
+    if( !file.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+    {
+        return false;
+    }
+    QDataStream out( &file );
+    out.setVersion( QDataStream::Qt_5_15 );
+    out << MAGIC << VERSION << seed_ << startTime_ << qint32( gameMode_ )
+        << endTick_ << endMsecs_ << quint32( events_.size() );
+
+    // A click is timed by the simulation, which can be slightly behind the
+    // key before it, so time differences are signed
+    quint64 previousTick = 0;
+    qint64 previousMsecs = 0;
+    for( const InputEvent& event : events_ )
+    {
+        out << quint32( event.tick - previousTick )
+            << qint32( event.msecs - previousMsecs ) << quint8( event.type )
+            << event.value;
+        previousTick = event.tick;
+        previousMsecs = event.msecs;
+    }
+    return out.status() == QDataStream::Ok;
+}
+
+bool InputLog::load(const QString &path)
+{
+    QFile file( path );
+    if( !file.open( QIODevice::ReadOnly ) )
+    {
+        return false;
+    }
+    QDataStream in( &file );
+    in.setVersion( QDataStream::Qt_5_15 );
+
+    quint32 magic = 0;
+    quint16 version = 0;
+    in >> magic >> version;
+    if( magic != MAGIC || version != VERSION )
+    {
+        return false;
+    }
+
+    quint32 seed = 0;
+    QTime startTime;
+    qint32 gameMode = 0;
+    quint64 endTick = 0;
+    qint64 endMsecs = 0;
+    quint32 count = 0;
+    in >> seed >> startTime >> gameMode >> endTick >> endMsecs >> count;
+
+    std::vector< InputEvent > events;
+    quint64 tick = 0;
+    qint64 msecs = 0;
+    for( quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i )
+    {
+        quint32 tickDelta = 0;
+        qint32 msecsDelta = 0;
+        quint8 type = 0;
+        qint32 value = 0;
+        in >> tickDelta >> msecsDelta >> type >> value;
+        if( type > quint8( InputType::SKIP ) )
+        {
+            in.setStatus( QDataStream::ReadCorruptData );
+        }
+        tick += tickDelta;
+        msecs += msecsDelta;
+        events.push_back( InputEvent{ tick, msecs, InputType( type ), value } );
+    }
+    if( in.status() != QDataStream::Ok || !startTime.isValid() )
+    {
+        return false;
+    }
+
+    seed_ = seed;
+    startTime_ = startTime;
+    gameMode_ = gameMode;
+    endTick_ = endTick;
+    endMsecs_ = endMsecs;
+    events_ = std::move( events );
+    return true;
+}
+
+}
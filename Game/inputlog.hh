@@ -0,0 +1,134 @@
+#ifndef INPUTLOG_HH
+#define INPUTLOG_HH
+
+#include <QString>
+#include <QTime>
+#include <QtGlobal>
+#include <vector>
+
+/**
+  * @file
+  * @brief Defines a log of player inputs for recording and replaying games.
+  */
+
+namespace Game
+{
+
+/**
+ * @brief InputType tells what kind of input an InputEvent is
+ */
+enum class InputType : quint8 { KEY_PRESS, KEY_RELEASE, BUTTON, SKIP };
+
+/**
+ * @brief Button identifies the buttons of the gamewindow in an InputEvent
+ */
+enum class Button : qint32
+{
+    WALKER, BIKER, TRAM, FORWARD, BACKWARD, LEFT_ROTATE, RIGHT_ROTATE,
+    ACTION, QUIT
+};
+
+/**
+ * @brief InputEvent is one input of the player
+ *
+ * tick is the number of logic ticks run before the input. msecs is the
+ * time of the input simulation the input happened at: the input clock for
+ * keys, the simulated time for clicks and skips. value is the Qt key of key
+ * events, the Button of button events and the milliseconds the simulation
+ * dropped after a stall for skips.
+ */
+struct InputEvent
+{
+    quint64 tick;
+    qint64 msecs;
+    InputType type;
+    qint32 value;
+};
+
+/**
+ * @brief The InputLog class
+ *
+ * Keeps the inputs of one game together with everything else needed to play
+ * it again: the seed of the random numbers, the starting time and the game
+ * mode. Events are keyed by logic tick and by the time of the input
+ * simulation instead of wall-clock time, so a replay does not depend on how
+ * fast it runs.
+ */
+class InputLog
+{
+public:
+    /**
+     * @brief InputLog constructor
+     *
+     * Creates an empty log with seed 1
+     */
+    InputLog();
+
+    /**
+     * @brief setStart function
+     * @param seed seed of the random numbers of the game
+     * @param startTime starting time in game
+     * @param gameMode game mode of the game
+     * @post Events are cleared.
+     */
+    void setStart( quint32 seed, QTime startTime, int gameMode );
+
+    quint32 seed() const;
+    QTime startTime() const;
+    int gameMode() const;
+
+    /**
+     * @brief append function
+     * @param tick logic ticks run before the input
+     * @param msecs time of the input simulation at the input
+     * @param type kind of the input
+     * @param value key, button or skipped milliseconds of the input
+     * @pre tick is not smaller than the tick of the previous event
+     */
+    void append( quint64 tick, qint64 msecs, InputType type, qint32 value );
+
+    /**
+     * @brief finish function
+     * @param tick logic ticks run when the game ended
+     * @param msecs time the input simulation had reached when the game ended
+     * @post Replay runs up to tick and msecs
+     */
+    void finish( quint64 tick, qint64 msecs );
+
+    quint64 endTick() const;
+    qint64 endMsecs() const;
+    const std::vector< InputEvent >& events() const;
+
+    /**
+     * @brief save function
+     * @param path file the log is written to
+     * @return true if the file was written, false otherwise
+     *
+     * Ticks and times are stored as differences to the previous event,
+     * which keeps the file a few bytes per input.
+     */
+    bool save( const QString& path ) const;
+
+    /**
+     * @brief load function
+     * @param path file written by save
+     * @return true if the file was a valid log, false otherwise
+     * @post On false the log is unchanged.
+     */
+    bool load( const QString& path );
+
+private:
+    quint32 seed_;
+    QTime startTime_;
+    int gameMode_;
+    quint64 endTick_;
+    qint64 endMsecs_;
+    std::vector< InputEvent > events_;
+
+    static const quint32 MAGIC;
+    static const quint16 VERSION;
+};
+
+}
+
+#endif // INPUTLOG_HH
@@ -1,14 +1,76 @@
+#include "gamewindow.h"
+#include "inputlog.hh"
 #include "settings.h"
+#include "core/trace.hh"
 
 #include <QApplication>
+#include <QCommandLineParser>
 
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
     Q_INIT_RESOURCE(offlinedata);
 
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption recordOption( "record",
+        "Records the key and button inputs of the game to <file>.", "file" );
+    QCommandLineOption replayOption( "replay",
+        "Replays the inputs recorded to <file> without a window and exits.", "file" );
+    QCommandLineOption snapshotOption( "snapshot",
+        "Writes the state of the game to <file> when the game window is closed.", "file" );
+    QCommandLineOption resumeOption( "resume",
+        "Continues the game saved to <file> with --snapshot.", "file" );
+    QCommandLineOption statsOption( "stats",
+        "Writes the minute statistics to <file> when the game ends, as CSV if "
+        "<file> ends with .csv, else in binary.", "file" );
+    parser.addOptions( { recordOption, replayOption, snapshotOption, resumeOption,
+                         statsOption } );
+    parser.process( a );
+
+    if( parser.isSet( replayOption ) )
+    {
+        Game::InputLog log;
+        if( !log.load( parser.value( replayOption ) ) )
+        {
+            qCCritical(nysseGame) << "Not an input log:" << parser.value( replayOption );
+            return 1;
+        }
+        GameWindow window;
+        int result = window.replay( log );
+        CourseSide::Trace::flushToFile();
+        return result;
+    }
+
     Settings w;
-    w.show();
+    if( parser.isSet( recordOption ) )
+    {
+        w.setRecordFile( parser.value( recordOption ) );
+    }
+    if( parser.isSet( snapshotOption ) )
+    {
+        w.setSnapshotFile( parser.value( snapshotOption ) );
+    }
+    if( parser.isSet( statsOption ) )
+    {
+        w.setStatisticsFile( parser.value( statsOption ) );
+    }
+    if( parser.isSet( resumeOption ) )
+    {
+        // The game window is the only one shown, settings stay hidden
+        if( !w.resume( parser.value( resumeOption ) ) )
+        {
+            qCCritical(nysseGame) << "Not a snapshot:" << parser.value( resumeOption );
+            return 1;
+        }
+    }
+    else
+    {
+        w.show();
+    }
+
+    int result = a.exec();
+    CourseSide::Trace::flushToFile();
 
-    return a.exec();
+    return result;
 }
@@ -0,0 +1,211 @@
+#include "metrics.hh"
+
+#include <new>
+
+namespace Game
+{
+
+const std::size_t Metrics::COUNTER_COUNT;
+const std::size_t Metrics::HISTOGRAM_COUNT;
+const std::size_t Metrics::BUCKET_COUNT;
+const std::size_t Metrics::SLOT_COUNT;
+const std::size_t Metrics::CACHE_LINE;
+
+namespace
+{
+
+// Slot indices held by live threads, shared by all Metrics objects
+std::atomic< bool > slotTaken[Metrics::SLOT_COUNT];
+
+// Holds a slot index for the lifetime of a thread and frees it when the
+// thread exits, so that threads started later can reuse it
+class SlotClaim
+{
+public:
+    SlotClaim():
+        index_( Metrics::SLOT_COUNT )
+    {
+        for( std::size_t i = 0; i < Metrics::SLOT_COUNT; ++i )
+        {
+            bool taken = false;
+            // Acquire pairs with the release of the previous owner, which
+            // orders its last writes to the slot before ours
+            if( slotTaken[i].compare_exchange_strong( taken, true,
+                                                      std::memory_order_acquire,
+                                                      std::memory_order_relaxed ) )
+            {
+                index_ = i;
+                break;
+            }
+        }
+    }
+
+    ~SlotClaim()
+    {
+        if( index_ < Metrics::SLOT_COUNT )
+        {
+            slotTaken[index_].store( false, std::memory_order_release );
+        }
+    }
+
+    SlotClaim( const SlotClaim& ) = delete;
+    SlotClaim& operator=( const SlotClaim& ) = delete;
+
+    std::size_t index() const
+    {
+        return index_;
+    }
+
+private:
+    std::size_t index_;
+};
+
+// Writer of an own slot is the only one, no read-modify-write is needed
+template< typename T >
+void addOwned( std::atomic< T >& value, T amount )
+{
+    value.store( value.load( std::memory_order_relaxed ) + amount,
+                 std::memory_order_relaxed );
+}
+
+}
+
+Metrics::Metrics():
+    storage_( new unsigned char[ ( SLOT_COUNT + 1 ) * sizeof( Slot ) + CACHE_LINE ] )
+{
+    static_assert( sizeof( Slot ) % CACHE_LINE == 0,
+                   "Slots must not share cache lines" );
+
+    std::size_t address = reinterpret_cast< std::size_t >( storage_.get() );
+    std::size_t offset = ( CACHE_LINE - address % CACHE_LINE ) % CACHE_LINE;
+    slots_ = reinterpret_cast< Slot* >( storage_.get() + offset );
+
+    for( std::size_t i = 0; i <= SLOT_COUNT; ++i )
+    {
+        Slot* slot = new( &slots_[i] ) Slot;
+        for( std::atomic< qint64 >& counter : slot->counters )
+        {
+            counter.store( 0, std::memory_order_relaxed );
+        }
+        for( auto& histogram : slot->buckets )
+        {
+            for( std::atomic< quint64 >& bucket : histogram )
+            {
+                bucket.store( 0, std::memory_order_relaxed );
+            }
+        }
+    }
+}
+
+Metrics::~Metrics()
+{
+    for( std::size_t i = 0; i <= SLOT_COUNT; ++i )
+    {
+        slots_[i].~Slot();
+    }
+}
+
+void Metrics::add(Counter counter, qint64 amount)
+{
+    std::size_t c = std::size_t( counter );
+    if( Slot* slot = ownSlot() )
+    {
+        addOwned( slot->counters[c], amount );
+    }
+    else
+    {
+        slots_[SLOT_COUNT].counters[c].fetch_add( amount, std::memory_order_relaxed );
+    }
+}
+
+void Metrics::record(Histogram histogram, quint64 value)
+{
+    std::size_t h = std::size_t( histogram );
+    std::size_t b = bucketOf( value );
+    if( Slot* slot = ownSlot() )
+    {
+        addOwned< quint64 >( slot->buckets[h][b], 1 );
+    }
+    else
+    {
+        slots_[SLOT_COUNT].buckets[h][b].fetch_add( 1, std::memory_order_relaxed );
+    }
+}
+
+qint64 Metrics::total(Counter counter) const
+{
+    std::size_t c = std::size_t( counter );
+    qint64 sum = 0;
+    for( std::size_t i = 0; i <= SLOT_COUNT; ++i )
+    {
+        sum += slots_[i].counters[c].load( std::memory_order_relaxed );
+    }
+    return sum;
+}
+
+std::vector<quint64> Metrics::buckets(Histogram histogram) const
+{
+    std::size_t h = std::size_t( histogram );
+    std::vector< quint64 > merged( BUCKET_COUNT, 0 );
+    for( std::size_t i = 0; i <= SLOT_COUNT; ++i )
+    {
+        for( std::size_t b = 0; b < BUCKET_COUNT; ++b )
+        {
+            merged[b] += slots_[i].buckets[h][b].load( std::memory_order_relaxed );
+        }
+    }
+    return merged;
+}
+
+quint64 Metrics::percentile(Histogram histogram, double fraction) const
+{
+    Q_ASSERT( fraction >= 0.0 && fraction <= 1.0 );
+    std::vector< quint64 > merged = buckets( histogram );
+
+    quint64 count = 0;
+    for( quint64 bucket : merged )
+    {
+        count += bucket;
+    }
+    if( count == 0 )
+    {
+        return 0;
+    }
+
+    quint64 wanted = quint64( fraction * double( count ) + 0.5 );
+    quint64 seen = 0;
+    for( std::size_t b = 0; b < BUCKET_COUNT; ++b )
+    {
+        seen += merged[b];
+        if( seen >= wanted && seen > 0 )
+        {
+            return b == 0 ? 0 : ( quint64( 1 ) << b ) - 1;
+        }
+    }
+    return ( quint64( 1 ) << ( BUCKET_COUNT - 1 ) ) - 1;
+}
+
+std::size_t Metrics::bucketOf(quint64 value)
+{
+    std::size_t bucket = 0;
+    while( value != 0 && bucket < BUCKET_COUNT - 1 )
+    {
+        value >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+std::size_t Metrics::threadIndex()
+{
+    thread_local SlotClaim claim;
+    return claim.index();
+}
+
+Metrics::Slot* Metrics::ownSlot()
+{
+    std::size_t index = threadIndex();
+    return index < SLOT_COUNT ? &slots_[index] : nullptr;
+}
+
+}
@@ -0,0 +1,143 @@
+#ifndef METRICS_HH
+#define METRICS_HH
+
+#include <QtGlobal>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/**
+  * @file
+  * @brief Defines counters and histograms that threads update without
+  * sharing cache lines.
+  */
+
+namespace Game
+{
+
+/**
+ * @brief The Metrics class
+ *
+ * Each thread that records a metric gets its own slot, padded to a cache
+ * line of its own. A thread only writes to its slot, so recording is a
+ * relaxed load and store without locked instructions or false sharing.
+ * Readers merge the slots of all threads, which is meant to be done once
+ * per frame, not per event.
+ *
+ * A thread claims a free slot at its first record and frees it when it
+ * exits. Its counts stay in the slot and the next thread to claim the slot
+ * continues from them. Threads that start while all SLOT_COUNT slots are
+ * claimed share one slot that is updated with atomic additions. Totals are
+ * exact in both cases, but a total read while threads are recording may
+ * miss their latest events.
+ */
+class Metrics
+{
+public:
+    /**
+     * @brief Counters summed over threads
+     */
+    enum class Counter
+    {
+        SCORE,
+        BUSES_DESTROYED,
+        PASSENGERS_CAPTURED
+    };
+
+    /**
+     * @brief Histograms of values, bucketed by powers of two
+     */
+    enum class Histogram
+    {
+        FRAME_USECS,            // time spent in a frame of the game window
+        INPUT_LATENCY_USECS     // from a key press to the paint showing it
+    };
+
+    static const std::size_t COUNTER_COUNT = 3;
+    static const std::size_t HISTOGRAM_COUNT = 2;
+    // Bucket 0 holds zeros, bucket b values in [2^(b-1), 2^b), last bucket
+    // also all larger values
+    static const std::size_t BUCKET_COUNT = 32;
+    // Live threads with a slot of their own
+    static const std::size_t SLOT_COUNT = 16;
+    // Size of the padding, covers the adjacent line prefetch of x86
+    static const std::size_t CACHE_LINE = 128;
+
+    Metrics();
+    ~Metrics();
+
+    Metrics( const Metrics& ) = delete;
+    Metrics& operator=( const Metrics& ) = delete;
+
+    /**
+     * @brief add adds to a counter in the slot of the calling thread
+     * @param counter counter to add to
+     * @param amount amount added
+     * @post Exception guarantee: nothrow
+     */
+    void add( Counter counter, qint64 amount = 1 );
+
+    /**
+     * @brief record adds a value to a histogram in the slot of the calling
+     * thread
+     * @param histogram histogram to add to
+     * @param value value to be counted
+     * @post Exception guarantee: nothrow
+     */
+    void record( Histogram histogram, quint64 value );
+
+    /**
+     * @brief total
+     * @param counter counter to read
+     * @return sum of the counter over all threads
+     */
+    qint64 total( Counter counter ) const;
+
+    /**
+     * @brief buckets
+     * @param histogram histogram to read
+     * @return BUCKET_COUNT counts merged over all threads
+     */
+    std::vector< quint64 > buckets( Histogram histogram ) const;
+
+    /**
+     * @brief percentile
+     * @param histogram histogram to read
+     * @param fraction fraction of values, e.g. 0.99
+     * @pre 0 <= fraction <= 1
+     * @return upper bound of the bucket that has the given fraction of
+     * values at or below it, 0 if nothing was recorded
+     */
+    quint64 percentile( Histogram histogram, double fraction ) const;
+
+    /**
+     * @brief bucketOf
+     * @param value value to be counted
+     * @return bucket the value is counted in
+     */
+    static std::size_t bucketOf( quint64 value );
+
+private:
+    struct alignas( CACHE_LINE ) Slot
+    {
+        std::atomic< qint64 > counters[COUNTER_COUNT];
+        std::atomic< quint64 > buckets[HISTOGRAM_COUNT][BUCKET_COUNT];
+    };
+
+    // Slot index claimed by the calling thread at its first record,
+    // SLOT_COUNT if all slots were claimed by live threads
+    static std::size_t threadIndex();
+
+    // Slot of the calling thread, nullptr for threads sharing the last slot
+    Slot* ownSlot();
+
+    // new does not align over 16 bytes before C++17, slots are placed in
+    // storage_ by hand. Last slot is shared by the threads without one
+    std::unique_ptr< unsigned char[] > storage_;
+    Slot* slots_;
+};
+
+}
+
+#endif // METRICS_HH
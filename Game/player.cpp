@@ -1,16 +1,16 @@
 #include "core/logic.hh"
+#include "core/trace.hh"
 #include "player.h"
+#include <QDataStream>
 #include <math.h>
-#include <QDebug>
 
 namespace Game
 {
 
 Player::Player() : passengersOnBoard_({})
 {
-    eastCoord_ = 3327703;
-    northCoord_ = 6825409;
-    location_.setNorthEast(northCoord_,eastCoord_);
+    setKind(Interface::ActorKind::PLAYER);
+    location_.setNorthEast(6825409, 3327703);
     type_ = 0;
     rotation_ = 0;
 }
@@ -26,7 +26,7 @@ Interface::Location Player::giveLocation() const
 
 void Player::move(Interface::Location loc)
 {
-    location_.setNorthEast(loc.giveNorthernCoord(),loc.giveEasternCoord());
+    location_ = loc;
 }
 
 bool Player::isRemoved() const
@@ -51,7 +51,12 @@ std::string Player::getName() const
 
 std::vector<std::shared_ptr<Interface::IPassenger>> Player::getPassengers() const
 {
-    return passengersOnBoard_;
+    return passengers().toVector();
+}
+
+Interface::PassengerView Player::passengers() const
+{
+    return Interface::PassengerView(passengersOnBoard_);
 }
 
 void Player::addPassenger(std::shared_ptr<Interface::IPassenger> passenger)
@@ -65,24 +70,28 @@ void Player::removePassenger(std::shared_ptr<Interface::IPassenger> passenger)
                                          passengersOnBoard_.end(), passenger),
                              passengersOnBoard_.end());
 }
-void Player::movePlayer(int dir)
+void Player::movePlayer(int dir, double portion)
 {
-    Coordinates c;
-    double newEast = eastCoord_+dir*SPEED.at(type_)*cos(rotation_*M_PI/180);
-    double newNorth = northCoord_+dir*SPEED.at(type_)*sin(rotation_*M_PI/180);
-    int newX = c.xFromEast(newEast);
-    int newY = c.yFromNorth(newNorth);
-
-    int BL = c.BORDER_LEFT;
-    int BR = c.BORDER_RIGHT;
-    int BU = c.BORDER_UP;
-    int BD = c.BORDER_DOWN;
+    // Rotation is in whole degrees, so full steps are a fixed set of
+    // quantized steps
+    double speed = SPEED.at(type_)*portion;
+    std::int32_t stepEast = dir*Interface::Location::toFixed(
+                speed*cos(rotation_*M_PI/180));
+    std::int32_t stepNorth = dir*Interface::Location::toFixed(
+                speed*sin(rotation_*M_PI/180));
+    targetLocation_.setNorthEastFixed(
+                location_.giveNorthernFixed() + stepNorth,
+                location_.giveEasternFixed() + stepEast );
+    int newX = Coordinates::xFromEast(targetLocation_.giveEasternCoord());
+    int newY = Coordinates::yFromNorth(targetLocation_.giveNorthernCoord());
+
+    int BL = Coordinates::BORDER_LEFT;
+    int BR = Coordinates::BORDER_RIGHT;
+    int BU = Coordinates::BORDER_UP;
+    int BD = Coordinates::BORDER_DOWN;
 
     if((BL<=newX and newX<=BR) and (BU<=newY and newY<=BD))
     {
-        eastCoord_ = newEast;
-        northCoord_ = newNorth;
-        targetLocation_.setNorthEast(northCoord_,eastCoord_);
         move(targetLocation_);
     }
     if( type_ == 2 )
@@ -107,21 +116,18 @@ QPixmap Player::getPix()
 
 int Player::getX()
 {
-    Coordinates c;
-    return c.xFromEast(location_.giveEasternCoord());
+    return Coordinates::xFromEast(location_.giveEasternCoord());
 }
 
 int Player::getY()
 {
-    Coordinates c;
-    return c.yFromNorth(location_.giveNorthernCoord());
+    return Coordinates::yFromNorth(location_.giveNorthernCoord());
 }
 void Player::setXY(int x,int y)
 {
-    Coordinates c;
-    northCoord_ = c.NorthFromY(y);
-    eastCoord_ = c.EastFromX(x);
-    location_.setNorthEast(northCoord_, eastCoord_);
+    location_.setNorthEastFixed(
+                Interface::Location::toFixed( Coordinates::NorthFromY(y) ),
+                Interface::Location::toFixed( Coordinates::EastFromX(x) ) );
 }
 
 void Player::changeRotation(int deg, bool isIncremental)
@@ -158,22 +164,28 @@ int Player::destroyBus( std::shared_ptr< Game::City > gameCity )
 
     for( auto actor : nearbyActors )
     {
-        if( typeid ( *actor) == typeid ( CourseSide::Nysse) )
+        if( actor->getKind() == Interface::ActorKind::VEHICLE )
         {
             Interface::Location loc = actor->giveLocation();
             std::shared_ptr<Interface::IStop> nearestStop =
                  gameCity->getNearestStop( loc );
-            std::shared_ptr< CourseSide::Nysse > busPtr =
-                    std::dynamic_pointer_cast< CourseSide::Nysse >(actor);
-
-            for( auto IPassenger : busPtr->getPassengers() )
+            // IActor is a virtual base, reaching the vehicle needs a cast
+            // but only for the buses that are actually destroyed
+            std::shared_ptr< Interface::IVehicle > busPtr =
+                    std::dynamic_pointer_cast< Interface::IVehicle >(actor);
+
+            // Backwards, so that removing keeps the rest of the view valid
+            Interface::PassengerView onboard = busPtr->passengers();
+            for( std::size_t i = onboard.size(); i-- > 0; )
             {
+                std::shared_ptr< Interface::IPassenger > IPassenger = onboard[i];
                 busPtr->removePassenger(IPassenger);
                 std::shared_ptr< CourseSide::Passenger > passenger =
-                 std::dynamic_pointer_cast< CourseSide::Passenger >(IPassenger);
+                 std::static_pointer_cast< CourseSide::Passenger >(IPassenger);
                 passenger->enterStop( nearestStop );
                 gameCity->actorMoved( passenger );
-                qDebug() << "Moved passenger from bus to stop " << nearestStop->getName();
+                COURSE_TRACE(CourseSide::Trace::Event::PASSENGER_DROPPED,
+                             static_cast<std::int32_t>(nearestStop->getId()), 0);
             }
             gameCity->removeActor( actor );
             ++destroyedBuses;
@@ -189,7 +201,7 @@ void Player::persuadePassengers(std::shared_ptr<City> gameCity)
 
     for( auto actor : nearbyActors )
     {
-        if( typeid( *actor ) == typeid( CourseSide::Passenger ) )
+        if( actor->getKind() == Interface::ActorKind::PASSENGER )
         {
             std::shared_ptr< CourseSide::Passenger > passenger =
                  std::dynamic_pointer_cast< CourseSide::Passenger >( actor );
@@ -243,6 +255,30 @@ void Player::enterOrExitPassengers(std::shared_ptr<City> gameCity)
     }
     */
 }
+void Player::saveState(QDataStream &out) const
+{
+    out << qint32( location_.giveNorthernFixed() ) << qint32( location_.giveEasternFixed() )
+        << qint32( rotation_ ) << qint32( type_ );
+}
+
+bool Player::restoreState(QDataStream &in)
+{
+    qint32 north = 0;
+    qint32 east = 0;
+    qint32 rotation = 0;
+    qint32 type = 0;
+    in >> north >> east >> rotation >> type;
+    if( in.status() != QDataStream::Ok || rotation < 0 || rotation >= 360 ||
+            type < 0 || type >= int( PLAYERICONS.size() ) )
+    {
+        in.setStatus( QDataStream::ReadCorruptData );
+        return false;
+    }
+    location_.setNorthEastFixed( north, east );
+    rotation_ = rotation;
+    type_ = type;
+    return true;
+}
 }
 
 
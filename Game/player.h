@@ -8,6 +8,8 @@
 #include "core/location.hh"
 #include "coordinates.h"
 
+class QDataStream;
+
 /**
   * @file
   * @brief Defines player actor.
@@ -94,6 +96,13 @@ public:
      */
     std::vector<std::shared_ptr<Interface::IPassenger>> getPassengers() const;
 
+    /**
+     * @brief passengers returns all passengers in the vehicle without copying.
+     * @return View to passengersOnBoard_
+     * @post Exception guarantee: nothrow.
+     */
+    Interface::PassengerView passengers() const;
+
     /**
      * @brief addPassenger adds a new passenger to the vehicle.
      * @param passenger an passenger object to be added to the Vehicle.
@@ -148,8 +157,8 @@ public:
      * @param x integer coordinate value
      * @param y integer coordinate value
      *
-     * Sets player north and east coordinates to playerdata and updates
-     * location_
+     * Sets location_ to the fixed-point map coordinates of the given
+     * game map pixel
      */
     void setXY(int x, int y);
 
@@ -196,17 +205,32 @@ public:
     /**
      * @brief movePlayer function
      * @param dir direction forwards or backwards (int -1 or 1)
+     * @param portion portion of a full step moved, 1 by default
      *
      * calculates new location coordinates (x,y) and updates them to north- and
      * eastcoords and to location_ if the new location is withing the game area
      */
-    void movePlayer(int dir);
+    void movePlayer(int dir, double portion = 1.0);
+
+    /**
+     * @brief saveState function
+     * @param out stream the state is written to
+     *
+     * Writes the location, rotation and type of the player to a snapshot
+     */
+    void saveState( QDataStream& out ) const;
+
+    /**
+     * @brief restoreState function
+     * @param in stream to read a state written by saveState from
+     * @return true if the state was read, false if it is not valid.
+     * Nothing is changed on false
+     */
+    bool restoreState( QDataStream& in );
 signals:
     void tramMoved();
 
 private:
-    double northCoord_;
-    double eastCoord_;
     Interface::Location targetLocation_;
     Interface::Location location_;
     int rotation_;
@@ -0,0 +1,227 @@
+#include "policeforce.h"
+#include "coordinates.h"
+#include "flowfield.h"
+#include "core/trace.hh"
+
+#include <QDataStream>
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace Game
+{
+
+namespace
+{
+
+// Where the single police of the game started, in map coordinates
+const int START_NORTH = 6824987;
+const int START_EAST = 3326946;
+
+}
+
+PoliceForce::PoliceForce():
+    field_( nullptr ),
+    step_( float( SPEED_METRES * Coordinates::Projection::scale() ) )
+{
+}
+
+PoliceForce::~PoliceForce()
+{
+
+}
+
+void PoliceForce::addUnit(int x, int y)
+{
+    // Columns grow together, so neither push_back can throw
+    if( x_.size() == x_.capacity() || y_.size() == y_.capacity() )
+    {
+        std::size_t capacity = 2 * x_.size() + 1;
+        x_.reserve( capacity );
+        y_.reserve( capacity );
+    }
+    x_.push_back( float( x ) );
+    y_.push_back( float( y ) );
+}
+
+void PoliceForce::addUnits(std::size_t count)
+{
+    const int width = Coordinates::BORDER_RIGHT - Coordinates::BORDER_LEFT;
+    const int height = Coordinates::BORDER_DOWN - Coordinates::BORDER_UP;
+    const int perimeter = 2 * ( width + height );
+
+    for( std::size_t i = 0; i < count; ++i )
+    {
+        if( x_.empty() )
+        {
+            addUnit( Coordinates::xFromEast( START_EAST ),
+                     Coordinates::yFromNorth( START_NORTH ) );
+            continue;
+        }
+        // Walk the border clockwise from the top left corner
+        int along = int( i * perimeter / count );
+        if( along < width )
+        {
+            addUnit( Coordinates::BORDER_LEFT + along, Coordinates::BORDER_DOWN );
+        }
+        else if( ( along -= width ) < height )
+        {
+            addUnit( Coordinates::BORDER_RIGHT, Coordinates::BORDER_DOWN - along );
+        }
+        else if( ( along -= height ) < width )
+        {
+            addUnit( Coordinates::BORDER_RIGHT - along, Coordinates::BORDER_UP );
+        }
+        else
+        {
+            addUnit( Coordinates::BORDER_LEFT, Coordinates::BORDER_UP + along - width );
+        }
+    }
+}
+
+void PoliceForce::setFlowField(const FlowField *field)
+{
+    field_ = field;
+}
+
+void PoliceForce::steer(int x, int y, float portion)
+{
+    const float px = float( x );
+    const float py = float( y );
+    const float step = step_ * portion;
+    const float left = float( Coordinates::BORDER_LEFT );
+    const float right = float( Coordinates::BORDER_RIGHT );
+    const float up = float( Coordinates::BORDER_UP );
+    const float down = float( Coordinates::BORDER_DOWN );
+
+    float* ux = x_.data();
+    float* uy = y_.data();
+    const std::size_t count = x_.size();
+
+    // One lookup per unit, the field was searched when the player moved
+    aimX_.resize( count );
+    aimY_.resize( count );
+    float* ax = aimX_.data();
+    float* ay = aimY_.data();
+    const bool follow = field_ != nullptr && !field_->isEmpty();
+    for( std::size_t i = 0; i < count; ++i )
+    {
+        ax[i] = px;
+        ay[i] = py;
+        std::int32_t cell = follow ? field_->cellOf( ux[i], uy[i] ) : FlowField::NONE;
+        if( cell != FlowField::NONE && field_->next( cell ) != FlowField::NONE )
+        {
+            ax[i] = field_->centerX( field_->next( cell ) );
+            ay[i] = field_->centerY( field_->next( cell ) );
+        }
+    }
+
+    std::size_t i = 0;
+    int caught = 0;
+
+    // Direction is the vector to the aim scaled to a step, units closer
+    // than a step arrive on the aim. Same float operations in both loops
+#if defined(__SSE2__)
+    const __m128 qx = _mm_set1_ps( px );
+    const __m128 qy = _mm_set1_ps( py );
+    const __m128 st = _mm_set1_ps( step );
+    const __m128 one = _mm_set1_ps( 1.0f );
+    const __m128 absMask = _mm_castsi128_ps( _mm_set1_epi32( 0x7fffffff ) );
+    for( ; i + 4 <= count; i += 4 )
+    {
+        __m128 ox = _mm_loadu_ps( ux + i );
+        __m128 oy = _mm_loadu_ps( uy + i );
+        __m128 px4 = _mm_sub_ps( qx, ox );
+        __m128 py4 = _mm_sub_ps( qy, oy );
+        __m128 onPlayer = _mm_and_ps( _mm_cmplt_ps( _mm_and_ps( px4, absMask ), one ),
+                                      _mm_cmplt_ps( _mm_and_ps( py4, absMask ), one ) );
+        caught |= _mm_movemask_ps( onPlayer );
+
+        __m128 dx = _mm_sub_ps( _mm_loadu_ps( ax + i ), ox );
+        __m128 dy = _mm_sub_ps( _mm_loadu_ps( ay + i ), oy );
+
+        __m128 distance = _mm_sqrt_ps( _mm_add_ps( _mm_mul_ps( dx, dx ),
+                                                   _mm_mul_ps( dy, dy ) ) );
+        __m128 scale = _mm_div_ps( st, _mm_max_ps( distance, st ) );
+        ox = _mm_add_ps( ox, _mm_mul_ps( dx, scale ) );
+        oy = _mm_add_ps( oy, _mm_mul_ps( dy, scale ) );
+        _mm_storeu_ps( ux + i, _mm_min_ps( _mm_max_ps( ox, _mm_set1_ps( left ) ),
+                                           _mm_set1_ps( right ) ) );
+        _mm_storeu_ps( uy + i, _mm_min_ps( _mm_max_ps( oy, _mm_set1_ps( up ) ),
+                                           _mm_set1_ps( down ) ) );
+    }
+#endif
+
+    for( ; i < count; ++i )
+    {
+        // Same rule as the whole pixels of the old police
+        caught |= int( std::fabs( px - ux[i] ) < 1.0f && std::fabs( py - uy[i] ) < 1.0f );
+
+        float dx = ax[i] - ux[i];
+        float dy = ay[i] - uy[i];
+
+        float distance = std::sqrt( dx * dx + dy * dy );
+        float scale = step / std::max( distance, step );
+        ux[i] = std::min( std::max( ux[i] + dx * scale, left ), right );
+        uy[i] = std::min( std::max( uy[i] + dy * scale, up ), down );
+    }
+
+    if( caught )
+    {
+        qCInfo(nysseGame) << "Police caught the player";
+        emit playerCaught();
+    }
+}
+
+std::size_t PoliceForce::size() const
+{
+    return x_.size();
+}
+
+int PoliceForce::getX(std::size_t unit) const
+{
+    return int( x_[unit] );
+}
+
+int PoliceForce::getY(std::size_t unit) const
+{
+    return int( y_[unit] );
+}
+
+void PoliceForce::saveState(QDataStream &out) const
+{
+    out << quint32( x_.size() );
+    for( std::size_t i = 0; i < x_.size(); ++i )
+    {
+        out << x_[i] << y_[i];
+    }
+}
+
+bool PoliceForce::restoreState(QDataStream &in)
+{
+    quint32 count = 0;
+    in >> count;
+    if( in.status() != QDataStream::Ok || count != x_.size() )
+    {
+        in.setStatus( QDataStream::ReadCorruptData );
+        return false;
+    }
+    std::vector< float > x( count );
+    std::vector< float > y( count );
+    for( std::size_t i = 0; i < count; ++i )
+    {
+        in >> x[i] >> y[i];
+    }
+    if( in.status() != QDataStream::Ok )
+    {
+        return false;
+    }
+    x_.swap( x );
+    y_.swap( y );
+    return true;
+}
+
+}
@@ -0,0 +1,137 @@
+#ifndef POLICEFORCE_H
+#define POLICEFORCE_H
+
+#include <QObject>
+#include <cstddef>
+#include <vector>
+
+class QDataStream;
+
+/**
+  * @file
+  * @brief Defines the police units chasing the player.
+  */
+
+namespace Game
+{
+
+class FlowField;
+
+/**
+ * @brief The PoliceForce class
+ *
+ * Keeps any number of police units as structure of arrays in pixel
+ * coordinates of the game map. steer moves every unit toward the player in
+ * one pass without trigonometry: the direction is the normalized vector to
+ * the player, so the loop is a few multiplies and a square root per unit
+ * that the compiler can vectorize.
+ *
+ * With a flow field, each unit first looks up the next cell of its own cell
+ * and heads for the center of it, so units go around water. Units in the
+ * cell of the player, outside the field or where the player cannot be
+ * reached from head straight to the player.
+ */
+class PoliceForce : public QObject
+{
+    Q_OBJECT
+public:
+    // Step of a unit in metres, the same as the speed of the old police
+    static const int SPEED_METRES = 2;
+
+    /**
+     * @brief PoliceForce constructor
+     *
+     * Creates a force without units
+     */
+    PoliceForce();
+
+    /**
+     * @brief ~PoliceForce destructor
+     */
+    virtual ~PoliceForce();
+
+    /**
+     * @brief addUnit
+     * @param x pixel coordinate of the unit
+     * @param y pixel coordinate of the unit
+     * @post Exception guarantee: strong
+     */
+    void addUnit( int x, int y );
+
+    /**
+     * @brief addUnits adds units at the starting points of the map
+     * @param count number of units added
+     *
+     * First unit starts where the police always has, the others evenly
+     * spaced along the map border.
+     */
+    void addUnits( std::size_t count );
+
+    /**
+     * @brief setFlowField sets the field units follow
+     * @param field flow field toward the player, not owned, nullptr to
+     * steer straight
+     * @pre The target of field is kept at the player
+     */
+    void setFlowField( const FlowField* field );
+
+    /**
+     * @brief steer moves every unit a step toward the player
+     * @param x player coordinate
+     * @param y player coordinate
+     * @param portion portion of a full step moved, 1 by default
+     *
+     * Units closer than a step stop on the player. playerCaught is emitted
+     * once if a unit was on the player before moving, like the old police.
+     * Units stay inside the game border.
+     */
+    void steer( int x, int y, float portion = 1.0f );
+
+    std::size_t size() const;
+
+    /**
+     * @brief getX
+     * @param unit index of the unit
+     * @pre unit < size()
+     * @return x coordinate of the unit
+     */
+    int getX( std::size_t unit ) const;
+
+    /**
+     * @brief getY
+     * @param unit index of the unit
+     * @pre unit < size()
+     * @return y coordinate of the unit
+     */
+    int getY( std::size_t unit ) const;
+
+    /**
+     * @brief saveState writes the positions of the units to a snapshot
+     * @param out stream the positions are written to
+     */
+    void saveState( QDataStream& out ) const;
+
+    /**
+     * @brief restoreState moves the units to positions written by saveState
+     * @param in stream to read the positions from
+     * @return true if the positions were read, false if they are not valid or
+     * are for another number of units. Nothing is changed on false
+     */
+    bool restoreState( QDataStream& in );
+
+signals:
+    void playerCaught();
+
+private:
+    std::vector< float > x_;
+    std::vector< float > y_;
+    // Points units head to during steer
+    std::vector< float > aimX_;
+    std::vector< float > aimY_;
+    const FlowField* field_;
+    // Step in pixels
+    const float step_;
+};
+}
+
+#endif // POLICEFORCE_H
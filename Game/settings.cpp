@@ -23,6 +23,18 @@ Settings::~Settings()
 void Settings::on_startButton_clicked()
 {
     GameWindow *window = new GameWindow(this);
+    if( !recordFile_.isEmpty() )
+    {
+        window->recordTo( recordFile_ );
+    }
+    if( !snapshotFile_.isEmpty() )
+    {
+        window->snapshotTo( snapshotFile_ );
+    }
+    if( !statisticsFile_.isEmpty() )
+    {
+        window->statisticsTo( statisticsFile_ );
+    }
 
     if( ui->timeGoalButton->isChecked() )
     {
@@ -45,6 +57,41 @@ void Settings::on_startButton_clicked()
     window->show();
 }
 
+void Settings::setRecordFile(const QString &path)
+{
+    recordFile_ = path;
+}
+
+void Settings::setSnapshotFile(const QString &path)
+{
+    snapshotFile_ = path;
+}
+
+void Settings::setStatisticsFile(const QString &path)
+{
+    statisticsFile_ = path;
+}
+
+bool Settings::resume(const QString &path)
+{
+    GameWindow *window = new GameWindow(this);
+    if( !snapshotFile_.isEmpty() )
+    {
+        window->snapshotTo( snapshotFile_ );
+    }
+    if( !statisticsFile_.isEmpty() )
+    {
+        window->statisticsTo( statisticsFile_ );
+    }
+    if( !window->resumeFrom( path ) )
+    {
+        delete window;
+        return false;
+    }
+    window->show();
+    return true;
+}
+
 void Settings::on_timeCheckBox_stateChanged(int arg1)
 {
     if( !isCustomeTimeUsed_ )
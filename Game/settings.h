@@ -32,6 +32,35 @@ public:
      */
     ~Settings();
 
+    /**
+     * @brief setRecordFile
+     * @param path file the inputs of started games are recorded to
+     */
+    void setRecordFile( const QString& path );
+
+    /**
+     * @brief setSnapshotFile
+     * @param path file the state of started games is written to when they
+     * are closed
+     */
+    void setSnapshotFile( const QString& path );
+
+    /**
+     * @brief setStatisticsFile
+     * @param path file the statistics of started games are written to when
+     * they end
+     */
+    void setStatisticsFile( const QString& path );
+
+    /**
+     * @brief resume
+     * @param path snapshot written by a game started with setSnapshotFile
+     * @return false if the file is not a snapshot
+     *
+     * Opens the gameWindow and continues the game of the snapshot
+     */
+    bool resume( const QString& path );
+
 private slots:
     /**
      * @brief on_startButton_clicked
@@ -45,6 +74,9 @@ private:
     Ui::Settings *ui;
     const QTime DEFAULTTIME = QTime( 7, 20 );
     bool isCustomeTimeUsed_ = false;
+    QString recordFile_;
+    QString snapshotFile_;
+    QString statisticsFile_;
 };
 
 #endif // SETTINGS_H
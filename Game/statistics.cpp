@@ -1,13 +1,64 @@
 #include "statistics.hh"
-#include <QDebug>
+#include "core/trace.hh"
+
+#include <QDataStream>
+#include <QTextStream>
 
 namespace Game
 {
-Statistics::Statistics(): score_(0), busesDestroyed_(0), passengersCaptured_(0)
+
+namespace
+{
+
+const char* const SERIES_NAMES[] =
+{
+    "active_buses", "new_passengers", "boardings", "alightings",
+    "destroyed_buses"
+};
+const std::size_t SERIES_COUNT = sizeof( SERIES_NAMES ) / sizeof( SERIES_NAMES[0] );
+
+// Values of a series oldest first
+void saveValues( QDataStream& out, const TimeSeries& series )
+{
+    out << quint32( series.size() );
+    for( std::size_t age = 0; age < series.size(); ++age )
+    {
+        out << series.at( age );
+    }
+}
+
+bool restoreValues( QDataStream& in, TimeSeries& series )
 {
+    quint32 size = 0;
+    in >> size;
+    if( size > series.capacity() )
+    {
+        in.setStatus( QDataStream::ReadCorruptData );
+    }
+    for( quint32 age = 0; age < size && in.status() == QDataStream::Ok; ++age )
+    {
+        double value = 0.0;
+        in >> value;
+        series.push( value );
+    }
+    return in.status() == QDataStream::Ok;
+}
 
 }
 
+const std::size_t Statistics::DEFAULT_MINUTES;
+// "NYST" and the version of the binary export
+const quint32 Statistics::BINARY_MAGIC = 0x4E595354;
+const quint16 Statistics::BINARY_VERSION = 1;
+
+Statistics::Statistics( std::size_t minutes ): minutes_( minutes ),
+    minutesRecorded_(0), activeBuses_(0), newPassengers_(0), boardings_(0),
+    alightings_(0), destroyedBuses_(0),
+    series_( SERIES_COUNT, TimeSeries( minutes ) )
+{
+    Q_ASSERT( minutes > 0 );
+}
+
 Statistics::~Statistics()
 {
 
@@ -15,44 +66,346 @@ Statistics::~Statistics()
 
 void Statistics::morePassengers(int num)
 {
-    qDebug() << "Added " << num << " passengers";
+    qCDebug(nysseGame) << "Added " << num << " passengers";
+    newPassengers_ += num;
 }
 
 void Statistics::nysseRemoved()
 {
-    qDebug() << "Nysse removed ingame";
-    score_ += BUS_DESTROYED_POINTS;
-    busesDestroyed_ += 1;
+    metrics_.add( Metrics::Counter::SCORE, BUS_DESTROYED_POINTS );
+    metrics_.add( Metrics::Counter::BUSES_DESTROYED );
+    destroyedBuses_ += 1;
+    COURSE_TRACE(CourseSide::Trace::Event::NYSSE_DESTROYED, getDestroyedBuses(), 0);
 }
 
 void Statistics::newNysse()
 {
-    qDebug() << "New nysse added to the game";
+    qCDebug(nysseGame) << "New nysse added to the game";
+    activeBuses_ += 1;
 }
 
 void Statistics::nysseLeft()
 {
-    qDebug() << "Nysse has left the game";
+    qCDebug(nysseGame) << "Nysse has left the game";
+    activeBuses_ -= 1;
+}
+
+void Statistics::nyssesAdded(int num)
+{
+    qCDebug(nysseGame) << num << "new nysses added to the game";
+    activeBuses_ += num;
+}
+
+void Statistics::nyssesLeft(int num)
+{
+    qCDebug(nysseGame) << num << "nysses have left the game";
+    activeBuses_ -= num;
+}
+
+void Statistics::passengerBoarded(unsigned int /*line*/)
+{
+    boardings_ += 1;
+}
+
+void Statistics::passengerAlighted(unsigned int /*line*/)
+{
+    alightings_ += 1;
+}
+
+void Statistics::passengersBoarded(unsigned int /*line*/, int num)
+{
+    boardings_ += num;
+}
+
+void Statistics::passengersAlighted(unsigned int /*line*/, int num)
+{
+    alightings_ += num;
+}
+
+void Statistics::passengersWaiting(unsigned int stopId, int num)
+{
+    std::size_t i = keyIndex( stops_, stopId );
+    stops_.sums[i] += num;
+    stops_.samples[i] += 1;
+}
+
+void Statistics::busLoad(unsigned int line, int num)
+{
+    std::size_t i = keyIndex( lines_, line );
+    lines_.sums[i] += num;
+    lines_.samples[i] += 1;
+}
+
+void Statistics::minutePassed()
+{
+    series_[ int( Series::ACTIVE_BUSES ) ].push( activeBuses_ );
+    series_[ int( Series::NEW_PASSENGERS ) ].push( newPassengers_ );
+    series_[ int( Series::BOARDINGS ) ].push( boardings_ );
+    series_[ int( Series::ALIGHTINGS ) ].push( alightings_ );
+    series_[ int( Series::DESTROYED_BUSES ) ].push( destroyedBuses_ );
+    newPassengers_ = 0;
+    boardings_ = 0;
+    alightings_ = 0;
+    destroyedBuses_ = 0;
+
+    closeMinute( stops_ );
+    closeMinute( lines_ );
+    ++minutesRecorded_;
+}
+
+const TimeSeries &Statistics::series(Series kind) const
+{
+    return series_[ int( kind ) ];
+}
+
+const TimeSeries *Statistics::waitingAtStop(unsigned int stopId) const
+{
+    auto found = stops_.index.find( stopId );
+    return found == stops_.index.end() ? nullptr : &stops_.series[ found->second ];
+}
+
+const TimeSeries *Statistics::lineLoad(unsigned int line) const
+{
+    auto found = lines_.index.find( line );
+    return found == lines_.index.end() ? nullptr : &lines_.series[ found->second ];
+}
+
+int Statistics::minutesRecorded() const
+{
+    return minutesRecorded_;
+}
+
+void Statistics::writeCsv(QTextStream &out) const
+{
+    // Every series holds the same latest minutes
+    int firstMinute = minutesRecorded_ - int( series_.front().size() );
+
+    out << "minute,series,key,value\n";
+    for( std::size_t kind = 0; kind < SERIES_COUNT; ++kind )
+    {
+        for( std::size_t age = 0; age < series_[kind].size(); ++age )
+        {
+            out << firstMinute + int( age ) << ',' << SERIES_NAMES[kind] << ",,"
+                << series_[kind].at( age ) << '\n';
+        }
+    }
+
+    const std::pair< const char*, const KeyedSeries* > keyedSeries[] =
+    {
+        { "waiting", &stops_ }, { "load_factor", &lines_ }
+    };
+    for( const auto& keyed : keyedSeries )
+    {
+        for( std::size_t i = 0; i < keyed.second->keys.size(); ++i )
+        {
+            const TimeSeries& series = keyed.second->series[i];
+            for( std::size_t age = 0; age < series.size(); ++age )
+            {
+                out << firstMinute + int( age ) << ',' << keyed.first << ','
+                    << keyed.second->keys[i] << ',' << series.at( age ) << '\n';
+            }
+        }
+    }
+}
+
+bool Statistics::writeBinary(QDataStream &out) const
+{
+    int firstMinute = minutesRecorded_ - int( series_.front().size() );
+
+    out << BINARY_MAGIC << BINARY_VERSION << quint32( minutes_ )
+        << qint32( minutesRecorded_ )
+        << quint32( SERIES_COUNT + stops_.keys.size() + lines_.keys.size() );
+
+    auto writeSeries = [&out, firstMinute]( const char* name, quint32 key,
+                                            const TimeSeries& series ) {
+        out << QString( name ) << key << qint32( firstMinute )
+            << quint32( series.size() );
+        for( std::size_t age = 0; age < series.size(); ++age )
+        {
+            out << series.at( age );
+        }
+    };
+    for( std::size_t kind = 0; kind < SERIES_COUNT; ++kind )
+    {
+        writeSeries( SERIES_NAMES[kind], 0, series_[kind] );
+    }
+    for( std::size_t i = 0; i < stops_.keys.size(); ++i )
+    {
+        writeSeries( "waiting", stops_.keys[i], stops_.series[i] );
+    }
+    for( std::size_t i = 0; i < lines_.keys.size(); ++i )
+    {
+        writeSeries( "load_factor", lines_.keys[i], lines_.series[i] );
+    }
+    return out.status() == QDataStream::Ok;
+}
+
+void Statistics::saveState(QDataStream &out) const
+{
+    out << quint32( minutes_ ) << qint32( minutesRecorded_ ) << qint32( activeBuses_ )
+        << qint32( newPassengers_ ) << qint32( boardings_ ) << qint32( alightings_ )
+        << qint32( destroyedBuses_ );
+    for( const TimeSeries& series : series_ )
+    {
+        saveValues( out, series );
+    }
+    saveKeyed( out, stops_ );
+    saveKeyed( out, lines_ );
+    for( std::size_t counter = 0; counter < Metrics::COUNTER_COUNT; ++counter )
+    {
+        out << qint64( metrics_.total( Metrics::Counter( counter ) ) );
+    }
+}
+
+bool Statistics::restoreState(QDataStream &in)
+{
+    quint32 minutes = 0;
+    // minutesRecorded_ and the counters of the current minute
+    qint32 counters[6] = {};
+    in >> minutes;
+    for( qint32& counter : counters )
+    {
+        in >> counter;
+    }
+    if( in.status() != QDataStream::Ok || minutes != minutes_ )
+    {
+        in.setStatus( QDataStream::ReadCorruptData );
+        return false;
+    }
+
+    // Everything is read before the state is changed
+    std::vector< TimeSeries > series( SERIES_COUNT, TimeSeries( minutes_ ) );
+    for( TimeSeries& kind : series )
+    {
+        restoreValues( in, kind );
+    }
+    KeyedSeries stops;
+    KeyedSeries lines;
+    restoreKeyed( in, stops );
+    restoreKeyed( in, lines );
+    qint64 totals[Metrics::COUNTER_COUNT] = {};
+    for( qint64& total : totals )
+    {
+        in >> total;
+    }
+    if( in.status() != QDataStream::Ok )
+    {
+        return false;
+    }
+
+    minutesRecorded_ = counters[0];
+    activeBuses_ = counters[1];
+    newPassengers_ = counters[2];
+    boardings_ = counters[3];
+    alightings_ = counters[4];
+    destroyedBuses_ = counters[5];
+    series_.swap( series );
+    stops_ = std::move( stops );
+    lines_ = std::move( lines );
+    for( std::size_t counter = 0; counter < Metrics::COUNTER_COUNT; ++counter )
+    {
+        Metrics::Counter kind = Metrics::Counter( counter );
+        metrics_.add( kind, totals[counter] - metrics_.total( kind ) );
+    }
+    return true;
+}
+
+void Statistics::saveKeyed(QDataStream &out, const KeyedSeries &keyed) const
+{
+    out << quint32( keyed.keys.size() );
+    for( std::size_t i = 0; i < keyed.keys.size(); ++i )
+    {
+        out << quint32( keyed.keys[i] ) << keyed.sums[i] << qint32( keyed.samples[i] );
+        saveValues( out, keyed.series[i] );
+    }
+}
+
+bool Statistics::restoreKeyed(QDataStream &in, KeyedSeries &keyed) const
+{
+    quint32 count = 0;
+    in >> count;
+    for( quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i )
+    {
+        quint32 key = 0;
+        double sum = 0.0;
+        qint32 samples = 0;
+        in >> key >> sum >> samples;
+        TimeSeries series( minutes_ );
+        if( !restoreValues( in, series ) ||
+                !keyed.index.insert( { key, keyed.keys.size() } ).second )
+        {
+            in.setStatus( QDataStream::ReadCorruptData );
+            break;
+        }
+        keyed.keys.push_back( key );
+        keyed.sums.push_back( sum );
+        keyed.samples.push_back( samples );
+        keyed.series.push_back( std::move( series ) );
+    }
+    return in.status() == QDataStream::Ok;
+}
+
+std::size_t Statistics::keyIndex(KeyedSeries &keyed, unsigned int key)
+{
+    auto found = keyed.index.find( key );
+    if( found != keyed.index.end() )
+    {
+        return found->second;
+    }
+
+    // Minutes before the key was seen count as zeros
+    TimeSeries series( minutes_ );
+    for( std::size_t age = 0; age < series_.front().size(); ++age )
+    {
+        series.push( 0.0 );
+    }
+    keyed.series.push_back( std::move( series ) );
+    keyed.keys.push_back( key );
+    keyed.sums.push_back( 0.0 );
+    keyed.samples.push_back( 0 );
+    keyed.index.insert( { key, keyed.keys.size() - 1 } );
+    return keyed.keys.size() - 1;
+}
+
+void Statistics::closeMinute(KeyedSeries &keyed)
+{
+    for( std::size_t i = 0; i < keyed.series.size(); ++i )
+    {
+        keyed.series[i].push( keyed.samples[i] == 0
+                              ? 0.0 : keyed.sums[i] / keyed.samples[i] );
+        keyed.sums[i] = 0.0;
+        keyed.samples[i] = 0;
+    }
+}
+
+Metrics &Statistics::metrics()
+{
+    return metrics_;
+}
+
+const Metrics &Statistics::metrics() const
+{
+    return metrics_;
 }
 
 int Statistics::getScore()
 {
-    return score_;
+    return int( metrics_.total( Metrics::Counter::SCORE ) );
 }
 
 int Statistics::getDestroyedBuses()
 {
-    return busesDestroyed_;
+    return int( metrics_.total( Metrics::Counter::BUSES_DESTROYED ) );
 }
 
 void Statistics::PassengerCaptured()
 {
-    score_ += PASSENGER_CAPTURED_POINTS;
-    passengersCaptured_ += 1;
+    metrics_.add( Metrics::Counter::SCORE, PASSENGER_CAPTURED_POINTS );
+    metrics_.add( Metrics::Counter::PASSENGERS_CAPTURED );
 }
 
 int Statistics::getPassengersCaptured()
 {
-    return passengersCaptured_;
+    return int( metrics_.total( Metrics::Counter::PASSENGERS_CAPTURED ) );
 }
 }
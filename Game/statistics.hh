@@ -2,6 +2,15 @@
 #define STATISTICS_HH
 
 #include "interfaces/istatistics.hh"
+#include "metrics.hh"
+#include "timeseries.hh"
+
+#include <QtGlobal>
+#include <unordered_map>
+#include <vector>
+
+class QDataStream;
+class QTextStream;
 
 /**
   * @file
@@ -14,16 +23,42 @@ namespace Game
  * @brief The Statistics class
  *
  * Manages scoring, bus and passenger statistics
+ *
+ * Besides the score, the statistics keep per-minute time series of the
+ * game. Events are counted and samples summed until minutePassed closes
+ * the minute and pushes one value to each series. Per-stop and per-line
+ * series are created when a stop or line is first reported; all series
+ * are aligned to the same minutes.
+ *
+ * Score, destroyed buses and captured passengers are kept in Metrics, so
+ * they can be counted from worker threads; their getters merge the
+ * threads. Time series are updated from the thread of the game logic.
  */
 class Statistics : public Interface::IStatistics
 {
 public:
+    /**
+     * @brief Series of the whole game
+     */
+    enum class Series
+    {
+        ACTIVE_BUSES,      // buses in traffic at the end of the minute
+        NEW_PASSENGERS,    // passengers added during the minute
+        BOARDINGS,         // passengers that boarded a bus during the minute
+        ALIGHTINGS,        // passengers that left a bus during the minute
+        DESTROYED_BUSES    // buses destroyed by the player during the minute
+    };
+
+    // Minutes kept in each series by default, four hours of game time
+    static const std::size_t DEFAULT_MINUTES = 240;
+
     /**
      * @brief Statistics constructor
+     * @param minutes how many of the latest minutes each series keeps
      *
-     * sets score_ and passengersCaptured_ to 0
+     * score and captured passengers start from 0
      */
-    Statistics();
+    explicit Statistics( std::size_t minutes = DEFAULT_MINUTES );
 
     /**
      * @brief ~Statistics
@@ -56,9 +91,130 @@ public:
     /**
      * @brief nysseLeft notifies, that a nysse has left the game.
      * @post Exception guarantee: strong
+     *
+     * Also called for destroyed buses, when they leave the traffic.
      */
     void nysseLeft();
 
+    /**
+     * @brief nyssesAdded
+     * @param num how many nysses were added
+     */
+    void nyssesAdded( int num );
+
+    /**
+     * @brief nyssesLeft
+     * @param num how many nysses left the traffic
+     */
+    void nyssesLeft( int num );
+
+    void passengerBoarded( unsigned int line );
+    void passengerAlighted( unsigned int line );
+    void passengersBoarded( unsigned int line, int num );
+    void passengersAlighted( unsigned int line, int num );
+
+    /**
+     * @brief passengersWaiting
+     * @param stopId id of the stop
+     * @param num number of waiting passengers
+     *
+     * Series of the stop gets the mean of the samples of a minute
+     */
+    void passengersWaiting( unsigned int stopId, int num );
+
+    /**
+     * @brief busLoad
+     * @param line number of the line of the bus
+     * @param num number of passengers in the bus
+     *
+     * Load factor of the line is the mean number of passengers per bus
+     * sample during a minute.
+     */
+    void busLoad( unsigned int line, int num );
+
+    /**
+     * @brief minutePassed
+     * @post Each series has the values of the ended minute. Exception
+     * guarantee: nothrow
+     */
+    void minutePassed();
+
+    /**
+     * @brief series
+     * @param kind series of the whole game
+     * @return the series
+     */
+    const TimeSeries& series( Series kind ) const;
+
+    /**
+     * @brief waitingAtStop
+     * @param stopId id of the stop
+     * @return series of waiting passengers, nullptr if the stop has not
+     * been reported
+     */
+    const TimeSeries* waitingAtStop( unsigned int stopId ) const;
+
+    /**
+     * @brief lineLoad
+     * @param line number of the line
+     * @return series of the load factor, nullptr if the line has not been
+     * reported
+     */
+    const TimeSeries* lineLoad( unsigned int line ) const;
+
+    /**
+     * @brief minutesRecorded
+     * @return number of minutes closed with minutePassed
+     */
+    int minutesRecorded() const;
+
+    /**
+     * @brief writeCsv
+     * @param out stream the series are written to
+     *
+     * Writes one "minute,series,key,value" row for each kept value. Minutes
+     * are counted from the first recorded one, key is the stop id or line
+     * number and empty for the series of the whole game.
+     */
+    void writeCsv( QTextStream& out ) const;
+
+    /**
+     * @brief writeBinary
+     * @param out stream the series are written to
+     * @return true if writing succeeded
+     *
+     * Writes the series with QDataStream: a header, then for each series
+     * its name, key, first minute and values.
+     */
+    bool writeBinary( QDataStream& out ) const;
+
+    /**
+     * @brief saveState
+     * @param out stream the state is written to
+     *
+     * Writes everything the statistics have counted to a snapshot: the
+     * counters of the current minute, the series and the score.
+     */
+    void saveState( QDataStream& out ) const;
+
+    /**
+     * @brief restoreState
+     * @param in stream to read a state written by saveState from
+     * @return true if the state was read, false if it is not valid or kept
+     * another number of minutes. Nothing is changed on false
+     *
+     * Replaces what has been counted, including events Logic gave while its
+     * snapshot was restored.
+     */
+    bool restoreState( QDataStream& in );
+
+    /**
+     * @brief metrics
+     * @return counters and histograms of the game
+     */
+    Metrics& metrics();
+    const Metrics& metrics() const;
+
     /**
      * @brief getScore
      * @return current score
@@ -84,11 +240,42 @@ public:
     int getPassengersCaptured();
 
 private:
-    int score_;
-    int busesDestroyed_;
-    const int BUS_DESTROYED_POINTS = 10;
+    // Series of stops or lines, indexed in the order the keys were seen
+    struct KeyedSeries
+    {
+        std::unordered_map< unsigned int, std::size_t > index;
+        std::vector< unsigned int > keys;
+        std::vector< TimeSeries > series;
+        // Samples of the current minute
+        std::vector< double > sums;
+        std::vector< int > samples;
+    };
+
+    // Returns the position of key, adding a series aligned with the others
+    std::size_t keyIndex( KeyedSeries& keyed, unsigned int key );
+    void closeMinute( KeyedSeries& keyed );
+    void saveKeyed( QDataStream& out, const KeyedSeries& keyed ) const;
+    bool restoreKeyed( QDataStream& in, KeyedSeries& keyed ) const;
+
+    const std::size_t minutes_;
+    int minutesRecorded_;
 
-    int passengersCaptured_;
+    // Counters of the current minute
+    int activeBuses_;
+    int newPassengers_;
+    int boardings_;
+    int alightings_;
+    int destroyedBuses_;
+
+    std::vector< TimeSeries > series_;
+    KeyedSeries stops_;
+    KeyedSeries lines_;
+
+    static const quint32 BINARY_MAGIC;
+    static const quint16 BINARY_VERSION;
+
+    Metrics metrics_;
+    const int BUS_DESTROYED_POINTS = 10;
     const int PASSENGER_CAPTURED_POINTS = 20;
     const int PASSENGER_GOAL = 40;
 
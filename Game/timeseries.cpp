@@ -0,0 +1,99 @@
+#include "timeseries.hh"
+
+#include <QtGlobal>
+#include <algorithm>
+
+namespace Game
+{
+
+TimeSeries::TimeSeries(std::size_t capacity) :
+    values_( capacity, 0.0 ), head_(0), size_(0), sum_(0.0)
+{
+
+}
+
+void TimeSeries::push(double value)
+{
+    Q_ASSERT( !values_.empty() );
+
+    if( size_ == values_.size() )
+    {
+        sum_ -= values_[head_];
+    }
+    else
+    {
+        ++size_;
+    }
+    values_[head_] = value;
+    sum_ += value;
+    head_ = ( head_ + 1 ) % values_.size();
+}
+
+void TimeSeries::clear()
+{
+    head_ = 0;
+    size_ = 0;
+    sum_ = 0.0;
+}
+
+std::size_t TimeSeries::size() const
+{
+    return size_;
+}
+
+std::size_t TimeSeries::capacity() const
+{
+    return values_.size();
+}
+
+double TimeSeries::at(std::size_t age) const
+{
+    Q_ASSERT( age < size_ );
+    // The oldest value is size_ positions before head_
+    return values_[ ( head_ + values_.size() - size_ + age ) % values_.size() ];
+}
+
+double TimeSeries::latest() const
+{
+    return at( size_ - 1 );
+}
+
+double TimeSeries::sum() const
+{
+    return sum_;
+}
+
+double TimeSeries::mean() const
+{
+    return size_ == 0 ? 0.0 : sum_ / size_;
+}
+
+double TimeSeries::min() const
+{
+    if( size_ == 0 )
+    {
+        return 0.0;
+    }
+    double smallest = at( 0 );
+    for( std::size_t age = 1; age < size_; ++age )
+    {
+        smallest = std::min( smallest, at( age ) );
+    }
+    return smallest;
+}
+
+double TimeSeries::max() const
+{
+    if( size_ == 0 )
+    {
+        return 0.0;
+    }
+    double largest = at( 0 );
+    for( std::size_t age = 1; age < size_; ++age )
+    {
+        largest = std::max( largest, at( age ) );
+    }
+    return largest;
+}
+
+}
@@ -0,0 +1,100 @@
+#ifndef TIMESERIES_HH
+#define TIMESERIES_HH
+
+#include <cstddef>
+#include <vector>
+
+/**
+  * @file
+  * @brief Defines a fixed-size ring buffer of per-minute statistics values.
+  */
+
+namespace Game
+{
+
+/**
+ * @brief The TimeSeries class
+ *
+ * Keeps the latest capacity() values of one statistic, one value per minute.
+ * Room for all values is reserved when the series is created, so pushing
+ * never allocates: when the series is full, the oldest value is overwritten.
+ * The sum of the kept values is updated on push, which makes sum and mean
+ * constant time.
+ */
+class TimeSeries
+{
+public:
+    /**
+     * @brief TimeSeries constructor
+     * @param capacity how many of the latest values are kept
+     */
+    explicit TimeSeries( std::size_t capacity = 0 );
+
+    /**
+     * @brief push adds the value of the next minute
+     * @param value value of the minute
+     * @pre capacity() > 0
+     * @post Oldest value is dropped if the series was full.
+     * Exception guarantee: nothrow
+     */
+    void push( double value );
+
+    /**
+     * @brief clear removes all values
+     * @post Capacity is kept. Exception guarantee: nothrow
+     */
+    void clear();
+
+    std::size_t size() const;
+    std::size_t capacity() const;
+
+    /**
+     * @brief at
+     * @param age position of the value, 0 is the oldest kept value
+     * @pre age < size()
+     * @return value at the position
+     */
+    double at( std::size_t age ) const;
+
+    /**
+     * @brief latest
+     * @pre size() > 0
+     * @return value of the latest minute
+     */
+    double latest() const;
+
+    /**
+     * @brief sum
+     * @return sum of the kept values, 0 if there are none
+     */
+    double sum() const;
+
+    /**
+     * @brief mean
+     * @return mean of the kept values, 0 if there are none
+     */
+    double mean() const;
+
+    /**
+     * @brief min
+     * @return smallest kept value, 0 if there are none
+     */
+    double min() const;
+
+    /**
+     * @brief max
+     * @return largest kept value, 0 if there are none
+     */
+    double max() const;
+
+private:
+    std::vector< double > values_;
+    // Position the next value is written to
+    std::size_t head_;
+    std::size_t size_;
+    double sum_;
+};
+
+}
+
+#endif // TIMESERIES_HH
@@ -0,0 +1,15 @@
+TEMPLATE = app
+TARGET = datagenerator
+
+QT += core
+QT -= gui
+
+CONFIG += c++14 console
+CONFIG -= app_bundle
+
+SOURCES += \
+    datagenerator.cc \
+    main.cc
+
+HEADERS += \
+    datagenerator.hh
@@ -0,0 +1,188 @@
+#include "datagenerator.hh"
+
+#include <QFile>
+#include <QJsonDocument>
+
+#include <algorithm>
+#include <cmath>
+
+namespace Tools
+{
+
+namespace
+{
+
+// Number of random candidates considered for the next stop of a route
+const int CANDIDATES = 8;
+
+}
+
+DataGenerator::DataGenerator(const GeneratorConfig& config) :
+    config_(config),
+    random_(config.seed)
+{
+}
+
+void DataGenerator::generate()
+{
+    stops_.clear();
+    stopArray_ = QJsonArray();
+    busArray_ = QJsonArray();
+
+    generateStops();
+    for (int line = 1; line <= config_.lines; ++line) {
+        generateLine(line);
+    }
+}
+
+QJsonArray DataGenerator::stops() const
+{
+    return stopArray_;
+}
+
+QJsonArray DataGenerator::buses() const
+{
+    return busArray_;
+}
+
+bool DataGenerator::writeFile(const QString& path, const QJsonArray& array, bool indented)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    QJsonDocument document(array);
+    QByteArray content = document.toJson(indented ? QJsonDocument::Indented : QJsonDocument::Compact);
+    return file.write(content) == content.size();
+}
+
+void DataGenerator::generateStops()
+{
+    std::uniform_int_distribution<int> east(config_.minEast, config_.maxEast);
+    std::uniform_int_distribution<int> north(config_.minNorth, config_.maxNorth);
+
+    stops_.reserve(config_.stops);
+    for (int i = 0; i < config_.stops; ++i) {
+        GeneratedStop stop = { i + 1, east(random_), north(random_) };
+        stops_.push_back(stop);
+
+        // Stop file stores every value as a string
+        QJsonObject o;
+        o.insert("stationId", QString::number(stop.id));
+        o.insert("y", QString::number(stop.north));
+        o.insert("x", QString::number(stop.east));
+        o.insert("name", QString("Pysakki %1").arg(stop.id));
+        stopArray_.append(o);
+    }
+}
+
+void DataGenerator::generateLine(int number)
+{
+    int length = std::min(config_.routeLength, config_.stops);
+    if (length < 2) {
+        return;
+    }
+
+    std::uniform_int_distribution<int> first(0, config_.stops - 1);
+    std::vector<bool> used(stops_.size(), false);
+    std::vector<int> route = { first(random_) };
+    used.at(route.front()) = true;
+    while (static_cast<int>(route.size()) < length) {
+        int next = nextStop(route.back(), used);
+        used.at(next) = true;
+        route.push_back(next);
+    }
+
+    QJsonArray fullSS;
+    int seconds = 0;
+    for (std::size_t i = 0; i < route.size(); ++i) {
+        const GeneratedStop& stop = stops_.at(route.at(i));
+        fullSS.append(routePoint(true, stop.id, seconds, stop.east, stop.north));
+        if (i + 1 == route.size()) {
+            break;
+        }
+
+        // Shape points along the straight line to the next stop
+        const GeneratedStop& next = stops_.at(route.at(i + 1));
+        double distance = std::hypot(next.east - stop.east, next.north - stop.north);
+        int travel = std::max(1, static_cast<int>(distance / config_.speed));
+        int step = std::max(1, config_.shapeIntervalSeconds);
+        for (int t = step; t < travel; t += step) {
+            double ratio = static_cast<double>(t) / travel;
+            fullSS.append(routePoint(false, 0, seconds + config_.dwellSeconds + t,
+                                     stop.east + (next.east - stop.east) * ratio,
+                                     stop.north + (next.north - stop.north) * ratio));
+        }
+        seconds += config_.dwellSeconds + travel;
+    }
+
+    const GeneratedStop& start = stops_.at(route.front());
+    const GeneratedStop& end = stops_.at(route.back());
+
+    QJsonObject o;
+    o.insert("busNro", QString::number(number));
+    o.insert("busId", QString::number(number));
+    o.insert("firstStation", QString::number(start.id));
+    o.insert("busLineName", QString("Pysakki %1 - Pysakki %2").arg(start.id).arg(end.id));
+    o.insert("startTimes", departureTimes());
+    o.insert("fullSS", fullSS);
+    busArray_.append(o);
+}
+
+int DataGenerator::nextStop(int current, const std::vector<bool>& used)
+{
+    std::uniform_int_distribution<int> pick(0, config_.stops - 1);
+    const GeneratedStop& from = stops_.at(current);
+
+    int best = -1;
+    long long bestDistance = 0;
+    for (int i = 0; i < CANDIDATES || best < 0; ++i) {
+        int candidate = pick(random_);
+        if (used.at(candidate)) {
+            continue;
+        }
+        long long de = stops_.at(candidate).east - from.east;
+        long long dn = stops_.at(candidate).north - from.north;
+        long long distance = de * de + dn * dn;
+        if (best < 0 || distance < bestDistance) {
+            best = candidate;
+            bestDistance = distance;
+        }
+    }
+    return best;
+}
+
+QJsonArray DataGenerator::departureTimes()
+{
+    // Lines are offset randomly so that departures don't all happen at once
+    int headway = std::max(1, config_.headwayMinutes);
+    std::uniform_int_distribution<int> offset(0, headway - 1);
+    int first = (config_.firstDeparture / 100) * 60 + config_.firstDeparture % 100 + offset(random_);
+    int last = (config_.lastDeparture / 100) * 60 + config_.lastDeparture % 100;
+
+    QJsonArray times;
+    for (int minutes = first; minutes <= last && minutes < 24 * 60; minutes += headway) {
+        times.append(QString::number((minutes / 60) * 100 + minutes % 60));
+    }
+    return times;
+}
+
+QJsonObject DataGenerator::routePoint(bool stop, int stationId, int seconds, double east, double north)
+{
+    int mm = seconds / 60;
+    int ss = seconds % 60;
+
+    QJsonObject o;
+    o.insert("stop", stop);
+    if (stop) {
+        o.insert("stationId", stationId);
+    }
+    o.insert("mm", mm);
+    o.insert("ss", ss);
+    o.insert("mns", QString("%1%2").arg(mm).arg(ss, 2, 10, QChar('0')));
+    o.insert("x", static_cast<int>(east));
+    o.insert("y", static_cast<int>(north));
+    return o;
+}
+
+}
@@ -0,0 +1,109 @@
+#ifndef DATAGENERATOR_HH
+#define DATAGENERATOR_HH
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QString>
+
+#include <random>
+#include <vector>
+
+/**
+  * @file
+  * @brief Defines a generator for synthetic OfflineReader-compatible bus and stop data.
+  */
+
+namespace Tools
+{
+
+/**
+ * @brief GeneratorConfig holds the parameters of a generated city.
+ *
+ * Defaults are close to the bundled Tampere data.
+ */
+struct GeneratorConfig
+{
+    int lines = 58;
+    int stops = 2428;
+    int routeLength = 37;        // stops per line
+    int headwayMinutes = 30;     // time between departures of a line
+    int firstDeparture = 500;    // hhmm
+    int lastDeparture = 2300;    // hhmm
+    double speed = 8.0;          // metres per second between stops
+    int dwellSeconds = 15;       // time spent at each stop
+    int shapeIntervalSeconds = 15; // time between route points
+    unsigned int seed = 1;
+
+    // Area where stops are placed, KKJ3 coordinates
+    int minEast = 3318000;
+    int maxEast = 3340000;
+    int minNorth = 6815000;
+    int maxNorth = 6835000;
+};
+
+/**
+ * @brief DataGenerator creates random stops and bus lines using the JSON
+ * schema read by CourseSide::OfflineReader.
+ */
+class DataGenerator
+{
+public:
+    /**
+     * @brief DataGenerator constructor
+     * @param config parameters of the generated data
+     */
+    explicit DataGenerator(const GeneratorConfig& config);
+
+    /**
+     * @brief generate creates the stops and lines.
+     * @post stops() and buses() return the generated data.
+     */
+    void generate();
+
+    /**
+     * @brief stops returns the generated stops in the format of the stop file
+     * @return array of stop objects
+     */
+    QJsonArray stops() const;
+
+    /**
+     * @brief buses returns the generated lines in the format of the bus file
+     * @return array of line objects
+     */
+    QJsonArray buses() const;
+
+    /**
+     * @brief writeFile writes a JSON array to a file.
+     * @param path file to be written
+     * @param array content of the file
+     * @param indented true for human readable output, false for compact output
+     * @return true if writing succeeded
+     */
+    static bool writeFile(const QString& path, const QJsonArray& array, bool indented);
+
+private:
+    struct GeneratedStop {
+        int id;
+        int east;
+        int north;
+    };
+
+    GeneratorConfig config_;
+    std::mt19937 random_;
+    std::vector<GeneratedStop> stops_;
+    QJsonArray stopArray_;
+    QJsonArray busArray_;
+
+    void generateStops();
+    void generateLine(int number);
+
+    // Picks the next stop of a route among a few random candidates
+    int nextStop(int current, const std::vector<bool>& used);
+
+    QJsonArray departureTimes();
+    static QJsonObject routePoint(bool stop, int stationId, int seconds, double east, double north);
+};
+
+}
+
+#endif // DATAGENERATOR_HH
@@ -0,0 +1,77 @@
+#include "datagenerator.hh"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QTextStream>
+
+namespace
+{
+
+// Reads a positive integer option, keeps the default if the option is not given
+bool readOption(const QCommandLineParser& parser, const QString& name, int& value)
+{
+    if (!parser.isSet(name)) {
+        return true;
+    }
+    bool ok = false;
+    int parsed = parser.value(name).toInt(&ok);
+    if (!ok || parsed <= 0) {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("datagenerator");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Generates synthetic bus and stop files for OfflineReader.");
+    parser.addHelpOption();
+    parser.addOptions({
+        { "lines", "Number of bus lines.", "count" },
+        { "stops", "Number of stops.", "count" },
+        { "route-length", "Stops on each line.", "count" },
+        { "headway", "Minutes between departures of a line.", "minutes" },
+        { "scale", "Multiplies the number of lines and stops.", "factor" },
+        { "seed", "Seed for the random generator.", "seed" },
+        { "buses", "Output bus file.", "file", "synthetic_buses.json" },
+        { "stations", "Output stop file.", "file", "synthetic_stations.json" },
+        { "indented", "Write human readable JSON." }
+    });
+    parser.process(app);
+
+    Tools::GeneratorConfig config;
+    int scale = 1;
+    int seed = static_cast<int>(config.seed);
+    if (!readOption(parser, "lines", config.lines) ||
+            !readOption(parser, "stops", config.stops) ||
+            !readOption(parser, "route-length", config.routeLength) ||
+            !readOption(parser, "headway", config.headwayMinutes) ||
+            !readOption(parser, "scale", scale) ||
+            !readOption(parser, "seed", seed)) {
+        QTextStream(stderr) << "Options must be positive integers." << '\n';
+        return 1;
+    }
+    config.lines *= scale;
+    config.stops *= scale;
+    config.seed = static_cast<unsigned int>(seed);
+
+    Tools::DataGenerator generator(config);
+    generator.generate();
+
+    bool indented = parser.isSet("indented");
+    if (!Tools::DataGenerator::writeFile(parser.value("stations"), generator.stops(), indented) ||
+            !Tools::DataGenerator::writeFile(parser.value("buses"), generator.buses(), indented)) {
+        QTextStream(stderr) << "Writing the output files failed." << '\n';
+        return 1;
+    }
+
+    QTextStream(stdout) << "Generated " << config.lines << " lines and "
+                        << config.stops << " stops." << '\n';
+    return 0;
+}
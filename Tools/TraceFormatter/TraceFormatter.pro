@@ -0,0 +1,18 @@
+TEMPLATE = app
+TARGET = traceformatter
+
+QT += core
+QT -= gui
+
+CONFIG += c++14 console
+CONFIG -= app_bundle
+
+SOURCES += \
+    ../../Course/CourseLib/core/trace.cc \
+    main.cc
+
+HEADERS += \
+    ../../Course/CourseLib/core/trace.hh
+
+INCLUDEPATH += \
+    $$PWD/../../Course/CourseLib
@@ -0,0 +1,43 @@
+#include "core/trace.hh"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QTextStream>
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("traceformatter");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Prints a trace written with NYSSE_TRACE, one event per line.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("trace", "Binary trace file.");
+    parser.process(app);
+
+    const QStringList files = parser.positionalArguments();
+    if (files.size() != 1) {
+        parser.showHelp(1);
+    }
+
+    QFile file(files.first());
+    if (!file.open(QIODevice::ReadOnly)) {
+        QTextStream(stderr) << "Could not open " << file.fileName() << ": "
+                            << file.errorString() << '\n';
+        return 1;
+    }
+
+    // readBinary gives nothing for a file it does not recognise
+    std::vector<CourseSide::Trace::Record> records = CourseSide::Trace::readBinary(file);
+    if (records.empty()) {
+        QTextStream(stderr) << "No trace events in " << file.fileName() << '\n';
+        return 1;
+    }
+
+    QTextStream out(stdout);
+    for (const CourseSide::Trace::Record& record : records) {
+        out << CourseSide::Trace::format(record) << '\n';
+    }
+    return 0;
+}
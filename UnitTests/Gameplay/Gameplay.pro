@@ -0,0 +1,19 @@
+QT += testlib gui
+
+TARGET = tst_gameplay
+
+CONFIG += qt console warn_on depend_includepath testcase c++14
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+HEADERS += \
+        ../../Game/flowfield.h \
+        ../../Game/inputlog.hh
+
+SOURCES +=  tst_gameplay.cpp \
+        ../../Game/flowfield.cpp \
+        ../../Game/inputlog.cpp
+
+INCLUDEPATH += \
+        ../../Game/
@@ -0,0 +1,264 @@
+#include "flowfield.h"
+#include "inputlog.hh"
+#include <QFile>
+#include <QImage>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <cstdlib>
+#include <random>
+#include <utility>
+#include <vector>
+
+
+class GameplayTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    GameplayTest();
+    ~GameplayTest();
+
+private Q_SLOTS:
+    void testFlowFieldCrossesAtBridge();
+    void testFlowFieldNoCornerCutting();
+    void testFlowFieldUnreachable();
+    void testWalkableCellsOrientation();
+    void testInputLogRoundTrip();
+    void testInputLogRejectsCorrupt();
+
+};
+
+namespace
+{
+
+// Index of the cell at the given column and row
+std::int32_t cellAt( const Game::FlowField& field, int column, int row )
+{
+    return row * field.columns() + column;
+}
+
+// Field of whole cells, all walkable except the given cells
+Game::FlowField gridField( int columns, int rows,
+                           const std::vector<std::pair<int, int>>& blocked )
+{
+    std::vector<std::uint8_t> mask( std::size_t( columns * rows ), 1 );
+    for( const std::pair<int, int>& cell : blocked )
+    {
+        mask[ std::size_t( cell.second * columns + cell.first ) ] = 0;
+    }
+    Game::FlowField field;
+    field.setWalkable( columns * Game::FlowField::CELL_SIZE,
+                       rows * Game::FlowField::CELL_SIZE, mask );
+    return field;
+}
+
+// Moves the target of the field to the center of a cell
+void targetCell( Game::FlowField& field, int column, int row )
+{
+    const int size = Game::FlowField::CELL_SIZE;
+    field.setTarget( column * size + size / 2, row * size + size / 2 );
+}
+
+}
+
+GameplayTest::GameplayTest()
+{
+
+}
+
+GameplayTest::~GameplayTest()
+{
+
+}
+
+void GameplayTest::testFlowFieldCrossesAtBridge()
+{
+    // River along column 6, bridged at row 7 only
+    std::vector<std::pair<int, int>> river;
+    for( int row = 0; row < 9; ++row )
+    {
+        if( row != 7 )
+        {
+            river.push_back( { 6, row } );
+        }
+    }
+    Game::FlowField field = gridField( 12, 9, river );
+    targetCell( field, 10, 1 );
+
+    std::int32_t cell = cellAt( field, 1, 1 );
+    bool crossed = false;
+    for( std::size_t steps = 0; cell != field.targetCell(); ++steps )
+    {
+        QVERIFY( steps < field.cellCount() );
+        std::int32_t next = field.next( cell );
+        QVERIFY( next != Game::FlowField::NONE );
+        QVERIFY( field.isWalkable( next ) );
+        crossed |= next == cellAt( field, 6, 7 );
+        cell = next;
+    }
+    QVERIFY( crossed );
+}
+
+void GameplayTest::testFlowFieldNoCornerCutting()
+{
+    Game::FlowField field = gridField( 3, 3, { { 1, 0 } } );
+    targetCell( field, 1, 1 );
+    // Diagonals past the blocked cell go around it
+    QCOMPARE( field.next( cellAt( field, 0, 0 ) ), cellAt( field, 0, 1 ) );
+    QCOMPARE( field.next( cellAt( field, 2, 0 ) ), cellAt( field, 2, 1 ) );
+    QCOMPARE( field.next( cellAt( field, 0, 2 ) ), cellAt( field, 1, 1 ) );
+
+    // No diagonal step of a random map passes a blocked cell
+    std::mt19937 random( 1 );
+    std::vector<std::pair<int, int>> blocked;
+    for( int i = 0; i < 120; ++i )
+    {
+        blocked.push_back( { int( random() % 20 ), int( random() % 20 ) } );
+    }
+    field = gridField( 20, 20, blocked );
+    targetCell( field, 19, 19 );
+    int diagonals = 0;
+    for( std::int32_t cell = 0; cell < std::int32_t( field.cellCount() ); ++cell )
+    {
+        std::int32_t next = field.next( cell );
+        if( next == Game::FlowField::NONE )
+        {
+            continue;
+        }
+        int column = cell % field.columns();
+        int row = cell / field.columns();
+        int nextColumn = next % field.columns();
+        int nextRow = next / field.columns();
+        QVERIFY( std::abs( nextColumn - column ) <= 1 && std::abs( nextRow - row ) <= 1 );
+        if( nextColumn != column && nextRow != row )
+        {
+            QVERIFY( field.isWalkable( cellAt( field, nextColumn, row ) ) );
+            QVERIFY( field.isWalkable( cellAt( field, column, nextRow ) ) );
+            ++diagonals;
+        }
+    }
+    QVERIFY( diagonals > 0 );
+}
+
+void GameplayTest::testFlowFieldUnreachable()
+{
+    // Cell (1, 1) is walled in, also diagonally
+    Game::FlowField field = gridField( 5, 5, { { 0, 0 }, { 1, 0 }, { 2, 0 }, { 0, 1 },
+                                               { 2, 1 }, { 0, 2 }, { 1, 2 }, { 2, 2 } } );
+    targetCell( field, 4, 4 );
+    QCOMPARE( field.next( cellAt( field, 1, 1 ) ), Game::FlowField::NONE );
+    QCOMPARE( field.next( cellAt( field, 1, 0 ) ), Game::FlowField::NONE );
+    QCOMPARE( field.next( field.targetCell() ), Game::FlowField::NONE );
+    QVERIFY( field.next( cellAt( field, 3, 0 ) ) != Game::FlowField::NONE );
+}
+
+void GameplayTest::testWalkableCellsOrientation()
+{
+    // Water in the top left of the image, which is the top left of the game area
+    const int size = Game::FlowField::CELL_SIZE;
+    QImage map( 2 * size, 2 * size, QImage::Format_RGB32 );
+    map.fill( qRgb( 200, 200, 190 ) );
+    for( int row = 0; row < size; ++row )
+    {
+        for( int x = 0; x < size; ++x )
+        {
+            map.setPixel( x, row, qRgb( 40, 120, 125 ) );
+        }
+    }
+
+    std::vector<std::uint8_t> walkable =
+            Game::FlowField::walkableCells( map, 2 * size, 2 * size );
+    QCOMPARE( walkable.size(), std::size_t( 4 ) );
+    // Image row 0 is y = height - 1, in the last row of cells
+    QCOMPARE( int( walkable[ 2 ] ), 0 );
+    QCOMPARE( int( walkable[ 0 ] ), 1 );
+    QCOMPARE( int( walkable[ 1 ] ), 1 );
+    QCOMPARE( int( walkable[ 3 ] ), 1 );
+}
+
+void GameplayTest::testInputLogRoundTrip()
+{
+    Game::InputLog log;
+    log.setStart( 1234, QTime( 13, 45 ), 1 );
+    log.append( 0, 20, Game::InputType::KEY_PRESS, Qt::Key_W );
+    // A click timed by the simulation, behind the key before it
+    log.append( 3, 5, Game::InputType::BUTTON, qint32( Game::Button::TRAM ) );
+    log.append( 3, 60, Game::InputType::KEY_RELEASE, Qt::Key_W );
+    log.append( 100000, 2000000, Game::InputType::SKIP, 250 );
+    log.finish( 100010, 2000200 );
+
+    QTemporaryDir dir;
+    QVERIFY( dir.isValid() );
+    const QString path = dir.filePath( "game.log" );
+    QVERIFY( log.save( path ) );
+
+    Game::InputLog loaded;
+    QVERIFY( loaded.load( path ) );
+    QCOMPARE( loaded.seed(), quint32( 1234 ) );
+    QCOMPARE( loaded.startTime(), QTime( 13, 45 ) );
+    QCOMPARE( loaded.gameMode(), 1 );
+    QCOMPARE( loaded.endTick(), quint64( 100010 ) );
+    QCOMPARE( loaded.endMsecs(), qint64( 2000200 ) );
+    QCOMPARE( loaded.events().size(), log.events().size() );
+    for( std::size_t i = 0; i < log.events().size(); ++i )
+    {
+        const Game::InputEvent& expected = log.events()[ i ];
+        const Game::InputEvent& event = loaded.events()[ i ];
+        QCOMPARE( event.tick, expected.tick );
+        QCOMPARE( event.msecs, expected.msecs );
+        QVERIFY( event.type == expected.type );
+        QCOMPARE( event.value, expected.value );
+    }
+
+    // Differences keep each event a few bytes
+    QFile file( path );
+    QVERIFY( file.open( QIODevice::ReadOnly ) );
+    QCOMPARE( file.size(), qint64( 38 + 13 * 4 ) );
+}
+
+void GameplayTest::testInputLogRejectsCorrupt()
+{
+    Game::InputLog log;
+    log.setStart( 1234, QTime( 13, 45 ), 1 );
+    log.append( 2, 40, Game::InputType::KEY_PRESS, Qt::Key_A );
+    log.finish( 5, 100 );
+
+    QTemporaryDir dir;
+    QVERIFY( dir.isValid() );
+    const QString path = dir.filePath( "game.log" );
+    QVERIFY( log.save( path ) );
+
+    QFile file( path );
+    QVERIFY( file.open( QIODevice::ReadOnly ) );
+    QByteArray bytes = file.readAll();
+    file.close();
+
+    Game::InputLog loaded;
+    loaded.setStart( 7, QTime( 8, 0 ), 0 );
+
+    // The type of the last event, which is followed by its value
+    bytes[ bytes.size() - 5 ] = char( quint8( Game::InputType::SKIP ) + 1 );
+    const QString corrupt = dir.filePath( "corrupt.log" );
+    QFile out( corrupt );
+    QVERIFY( out.open( QIODevice::WriteOnly ) );
+    out.write( bytes );
+    out.close();
+    QVERIFY( !loaded.load( corrupt ) );
+
+    // Cut short inside the events
+    QVERIFY( out.open( QIODevice::WriteOnly | QIODevice::Truncate ) );
+    out.write( bytes.left( bytes.size() - 3 ) );
+    out.close();
+    QVERIFY( !loaded.load( corrupt ) );
+
+    QVERIFY( !loaded.load( dir.filePath( "missing.log" ) ) );
+
+    // Failed loads leave the log as it was
+    QCOMPARE( loaded.seed(), quint32( 7 ) );
+    QCOMPARE( loaded.startTime(), QTime( 8, 0 ) );
+    QVERIFY( loaded.events().empty() );
+}
+
+QTEST_APPLESS_MAIN(GameplayTest)
+
+#include "tst_gameplay.moc"
@@ -0,0 +1,48 @@
+QT += testlib core gui widgets network multimedia concurrent
+
+TARGET = tst_simulation
+
+CONFIG += qt console warn_on depend_includepath testcase c++14
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+HEADERS += \
+        ../../Game/city.hh \
+        ../../Game/coordinates.h \
+        ../../Tools/DataGenerator/datagenerator.hh
+
+SOURCES +=  tst_simulation.cpp \
+        ../../Game/city.cpp \
+        ../../Game/coordinates.cpp \
+        ../../Tools/DataGenerator/datagenerator.cc
+
+INCLUDEPATH += \
+        ../../Game/ \
+        ../../Tools/DataGenerator/
+
+win32:CONFIG(release, debug|release): LIBS += \
+    -L$$OUT_PWD/../../Course/CourseLib/release/ -lCourseLib
+else:win32:CONFIG(debug, debug|release): LIBS += \
+    -L$$OUT_PWD/../../Course/CourseLib/debug/ -lCourseLib
+else:unix: LIBS += \
+    -L$$OUT_PWD/../../Course/CourseLib/ -lCourseLib
+
+INCLUDEPATH += \
+    $$PWD/../../Course/CourseLib
+
+DEPENDPATH += \
+    $$PWD/../../Course/CourseLib
+
+include($$PWD/../../Course/CourseLib/statistics.pri)
+
+win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += \
+    $$OUT_PWD/../../Course/CourseLib/release/libCourseLib.a
+else:win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += \
+    $$OUT_PWD/../../Course/CourseLib/debug/libCourseLib.a
+else:win32:!win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += \
+    $$OUT_PWD/../../Course/CourseLib/release/CourseLib.lib
+else:win32:!win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += \
+    $$OUT_PWD/../../Course/CourseLib/debug/CourseLib.lib
+else:unix: PRE_TARGETDEPS += \
+    $$OUT_PWD/../../Course/CourseLib/libCourseLib.a
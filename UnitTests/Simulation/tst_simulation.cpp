@@ -0,0 +1,410 @@
+#include "city.hh"
+#include "datagenerator.hh"
+#include "core/journeyplanner.hh"
+#include "core/location.hh"
+#include "core/locationbuffer.hh"
+#include "core/logic.hh"
+#include "core/pool.hh"
+#include "offlinereader.hh"
+
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+
+class SimulationTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    SimulationTest();
+    ~SimulationTest();
+
+private Q_SLOTS:
+    void testJourneyPlannerBruteForce_data();
+    void testJourneyPlannerBruteForce();
+    void testSnapshotRejectsCorrupt();
+    void testSnapshotRejectsOtherData();
+    void testBatchedLocationsMatchScalar_data();
+    void testBatchedLocationsMatchScalar();
+    void testPoolReusesSizeClass();
+    void testPoolAlignment();
+    void testPoolLargeBlocks();
+    void testPoolOutlivesOwner();
+
+};
+
+namespace
+{
+
+// Reads data generated with the given configuration
+std::shared_ptr<CourseSide::OfflineData> generateData(const Tools::GeneratorConfig& config)
+{
+    Tools::DataGenerator generator(config);
+    generator.generate();
+
+    QTemporaryDir dir;
+    QString buses = dir.filePath("buses.json");
+    QString stops = dir.filePath("stations.json");
+    if (!Tools::DataGenerator::writeFile(buses, generator.buses(), false) ||
+            !Tools::DataGenerator::writeFile(stops, generator.stops(), false)) {
+        return nullptr;
+    }
+    CourseSide::OfflineReader reader;
+    return reader.readFiles(buses, stops);
+}
+
+// Small generated city with buses in traffic in the morning, for snapshot tests
+std::shared_ptr<CourseSide::OfflineData> snapshotData(int stops, int lines)
+{
+    Tools::GeneratorConfig config;
+    config.lines = lines;
+    config.stops = stops;
+    config.routeLength = 8;
+    config.headwayMinutes = 10;
+    config.firstDeparture = 600;
+    config.lastDeparture = 1200;
+    return generateData(config);
+}
+
+// Earliest arrivals at all stops by relaxing every connection until nothing improves.
+// Connections are relaxed latest first, so the result does not depend on the departure
+// order the planner scans in.
+std::vector<std::int32_t> bruteForceArrivals(const CourseSide::JourneyPlanner& planner,
+                                             std::int32_t from, std::int32_t departure)
+{
+    const std::vector<CourseSide::JourneyPlanner::Connection>& connections = planner.connections();
+    std::vector<std::int32_t> arrival(planner.stopCount(), CourseSide::JourneyPlanner::NEVER);
+    arrival[from] = departure;
+    bool improved = true;
+    while (improved) {
+        improved = false;
+        for (auto c = connections.rbegin(); c != connections.rend(); ++c) {
+            if (arrival[c->from] <= c->departure && c->arrival < arrival[c->to]) {
+                arrival[c->to] = c->arrival;
+                improved = true;
+            }
+        }
+    }
+    return arrival;
+}
+
+}
+
+SimulationTest::SimulationTest()
+{
+}
+
+SimulationTest::~SimulationTest()
+{
+}
+
+void SimulationTest::testJourneyPlannerBruteForce_data()
+{
+    QTest::addColumn<unsigned int>("seed");
+
+    QTest::newRow("seed 1") << 1u;
+    QTest::newRow("seed 2") << 2u;
+    QTest::newRow("seed 3") << 3u;
+}
+
+void SimulationTest::testJourneyPlannerBruteForce()
+{
+    QFETCH(unsigned int, seed);
+
+    // Small network where lines share stops, so journeys have transfers
+    Tools::GeneratorConfig config;
+    config.lines = 10;
+    config.stops = 30;
+    config.routeLength = 8;
+    config.headwayMinutes = 20;
+    config.firstDeparture = 600;
+    config.lastDeparture = 1200;
+    config.seed = seed;
+    std::shared_ptr<CourseSide::OfflineData> data = generateData(config);
+    QVERIFY( data != nullptr && !data->stops.empty() );
+
+    CourseSide::JourneyPlanner planner;
+    planner.build(*data);
+    QVERIFY( !planner.connections().empty() );
+
+    using Planner = CourseSide::JourneyPlanner;
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<std::int32_t> stop(0, static_cast<std::int32_t>(planner.stopCount()) - 1);
+    std::uniform_int_distribution<std::int32_t> time(6 * 3600, 11 * 3600);
+    int transfers = 0;
+    for (int query = 0; query < 50; ++query) {
+        std::int32_t from = stop(random);
+        std::int32_t to = stop(random);
+        std::int32_t earliest = time(random);
+        std::int32_t latest = earliest + 3600;
+        if (from == to) {
+            continue;
+        }
+
+        Planner::Journey journey = planner.earliestArrival(from, to, earliest);
+        QCOMPARE( journey.arrival, bruteForceArrivals(planner, from, earliest)[to] );
+        transfers += journey.legs.size() > 1;
+
+        // The first run of the journey is boarded at the origin, also when asked again
+        // for a later departure that the cached answer covers
+        std::int32_t trip = planner.firstTrip(from, to, earliest);
+        QCOMPARE( trip != Planner::NONE, journey.found() );
+        if (trip != Planner::NONE) {
+            const Planner::Trip& run = planner.trips()[trip];
+            QCOMPARE( planner.tripOf(run.bus, run.start), trip );
+            std::int32_t departure = planner.departureAt(trip, from, earliest);
+            QVERIFY( departure >= earliest && departure != Planner::NEVER );
+            QCOMPARE( bruteForceArrivals(planner, from, departure)[to], journey.arrival );
+            QCOMPARE( planner.firstTrip(from, to, departure), trip );
+        }
+
+        // Pareto set of the window: departures from the origin whose earliest arrival is
+        // earlier than that of the next departure
+        std::vector<std::int32_t> departures;
+        for (const Planner::Connection& c : planner.connections()) {
+            if (c.from == from && c.departure >= earliest) {
+                departures.push_back(c.departure);
+            }
+        }
+        std::sort(departures.begin(), departures.end());
+        departures.erase(std::unique(departures.begin(), departures.end()), departures.end());
+
+        std::vector<std::int32_t> arrivals;
+        for (std::int32_t departure : departures) {
+            arrivals.push_back(bruteForceArrivals(planner, from, departure)[to]);
+        }
+        std::vector<Planner::ProfileEntry> expected;
+        for (std::size_t i = 0; i < departures.size() && departures[i] <= latest; ++i) {
+            std::int32_t next = i + 1 < arrivals.size() ? arrivals[i + 1] : Planner::NEVER;
+            if (arrivals[i] != Planner::NEVER && arrivals[i] < next) {
+                expected.push_back(Planner::ProfileEntry{departures[i], arrivals[i]});
+            }
+        }
+
+        std::vector<Planner::ProfileEntry> profile = planner.profile(from, to, earliest, latest);
+        QCOMPARE( profile.size(), expected.size() );
+        for (std::size_t i = 0; i < expected.size(); ++i) {
+            QCOMPARE( profile[i].departure, expected[i].departure );
+            QCOMPARE( profile[i].arrival, expected[i].arrival );
+        }
+    }
+    qInfo("%d of the journeys had transfers", transfers);
+}
+
+void SimulationTest::testSnapshotRejectsCorrupt()
+{
+    std::shared_ptr<Game::City> city = std::make_shared<Game::City>();
+    CourseSide::Logic logic;
+    logic.takeCity(city);
+    QVERIFY( logic.takeOfflineData(snapshotData(40, 10)) );
+    logic.setSeed(1);
+    logic.setTime(8, 0);
+    logic.finalizeGameStart();
+    for (int i = 0; i < 20; ++i) {
+        logic.increaseTime();
+    }
+
+    QByteArray snapshot;
+    QDataStream out(&snapshot, QIODevice::WriteOnly);
+    QVERIFY( logic.saveSnapshot(out) );
+
+    std::shared_ptr<Game::City> restoredCity = std::make_shared<Game::City>();
+    CourseSide::Logic restored;
+    restored.takeCity(restoredCity);
+    QVERIFY( restored.takeOfflineData(snapshotData(40, 10)) );
+
+    // Another format, and snapshots cut short at any point
+    std::vector<QByteArray> corrupt;
+    QByteArray otherMagic = snapshot;
+    otherMagic[0] = char(otherMagic[0] ^ 0x5A);
+    corrupt.push_back(otherMagic);
+    int stride = std::max(1, snapshot.size() / 200);
+    for (int size = 0; size < snapshot.size(); size += stride) {
+        corrupt.push_back(snapshot.left(size));
+    }
+    for (const QByteArray& bytes : corrupt) {
+        QDataStream in(bytes);
+        QVERIFY( !restored.restoreSnapshot(in) );
+    }
+
+    // Failed restores changed nothing, the game starts from the whole snapshot
+    QDataStream in(snapshot);
+    QVERIFY( restored.restoreSnapshot(in) );
+    QCOMPARE( restored.ticks(), logic.ticks() );
+    QByteArray again;
+    QDataStream againOut(&again, QIODevice::WriteOnly);
+    QVERIFY( restored.saveSnapshot(againOut) );
+    QCOMPARE( again, snapshot );
+}
+
+void SimulationTest::testSnapshotRejectsOtherData()
+{
+    std::shared_ptr<Game::City> city = std::make_shared<Game::City>();
+    CourseSide::Logic logic;
+    logic.takeCity(city);
+    QVERIFY( logic.takeOfflineData(snapshotData(40, 10)) );
+    logic.setTime(8, 0);
+    logic.finalizeGameStart();
+
+    QByteArray snapshot;
+    QDataStream out(&snapshot, QIODevice::WriteOnly);
+    QVERIFY( logic.saveSnapshot(out) );
+
+    // Other stops, then other lines
+    const int sizes[][2] = { { 41, 10 }, { 40, 11 } };
+    for (const auto& size : sizes) {
+        std::shared_ptr<Game::City> otherCity = std::make_shared<Game::City>();
+        CourseSide::Logic other;
+        other.takeCity(otherCity);
+        QVERIFY( other.takeOfflineData(snapshotData(size[0], size[1])) );
+        QDataStream in(snapshot);
+        QVERIFY( !other.restoreSnapshot(in) );
+    }
+}
+
+void SimulationTest::testBatchedLocationsMatchScalar_data()
+{
+    QTest::addColumn<int>("count");
+
+    // Empty, tails shorter than any vector, and masks that run into a second and third word
+    QTest::newRow("0") << 0;
+    QTest::newRow("1") << 1;
+    QTest::newRow("7") << 7;
+    QTest::newRow("63") << 63;
+    QTest::newRow("64") << 64;
+    QTest::newRow("67") << 67;
+    QTest::newRow("133") << 133;
+}
+
+void SimulationTest::testBatchedLocationsMatchScalar()
+{
+    QFETCH(int, count);
+    const int LIMIT = 10;
+
+    Interface::Location from(6825500, 3327700);
+    std::mt19937 random(static_cast<unsigned int>(count));
+    std::uniform_int_distribution<int> offset(-2 * LIMIT, 2 * LIMIT);
+    std::vector<Interface::Location> locations;
+    Interface::LocationBuffer buffer;
+    for (int i = 0; i < count; ++i) {
+        Interface::Location location;
+        location.setXY(from.giveX() + offset(random), from.giveY() + offset(random));
+        locations.push_back(location);
+        buffer.push_back(location);
+    }
+
+    std::vector<double> distances;
+    Interface::Location::calcDistances(from, buffer, distances);
+    QCOMPARE( distances.size(), locations.size() );
+    for (int i = 0; i < count; ++i) {
+        QCOMPARE( distances[i], Interface::Location::calcDistance(from, locations[i]) );
+    }
+
+    // Any old content of the mask is replaced
+    std::vector<std::uint64_t> mask(4, ~std::uint64_t(0));
+    Interface::Location::closeMask(from, buffer, mask, LIMIT);
+    QCOMPARE( mask.size(), std::size_t((count + 63) / 64) );
+    int close = 0;
+    for (int i = 0; i < count; ++i) {
+        bool bit = (mask[i / 64] >> (i % 64)) & 1;
+        QCOMPARE( bit, from.isClose(locations[i], LIMIT) );
+        close += bit;
+    }
+    // Bits past the last location stay clear
+    if (count % 64 != 0) {
+        QCOMPARE( mask.back() >> (count % 64), std::uint64_t(0) );
+    }
+    QVERIFY( count < 8 || (close > 0 && close < count) );
+}
+
+void SimulationTest::testPoolReusesSizeClass()
+{
+    using CourseSide::Pool;
+    Pool pool;
+    void* block = pool.allocate(Pool::ALIGNMENT + 1);
+    pool.deallocate(block, Pool::ALIGNMENT + 1);
+
+    // Another size class carves a new block, the same class gets the freed one
+    void* smaller = pool.allocate(Pool::ALIGNMENT);
+    QVERIFY( smaller != block );
+    QCOMPARE( pool.allocate(2 * Pool::ALIGNMENT), block );
+
+    const CourseSide::PoolStatistics& statistics = pool.statistics();
+    QCOMPARE( statistics.allocations, std::size_t(3) );
+    QCOMPARE( statistics.deallocations, std::size_t(1) );
+    QCOMPARE( statistics.reuses, std::size_t(1) );
+    QCOMPARE( statistics.live(), std::size_t(2) );
+}
+
+void SimulationTest::testPoolAlignment()
+{
+    using CourseSide::Pool;
+    Pool pool;
+
+    // Every size up to MAX_BLOCK, more than a slab in total
+    std::vector<std::pair<char*, std::size_t>> blocks;
+    for (std::size_t size = 1; size <= Pool::MAX_BLOCK; ++size) {
+        char* block = static_cast<char*>(pool.allocate(size));
+        QCOMPARE( reinterpret_cast<std::uintptr_t>(block) % Pool::ALIGNMENT, std::uintptr_t(0) );
+        std::fill(block, block + size, static_cast<char>(size));
+        blocks.push_back({block, size});
+    }
+    QVERIFY( pool.statistics().slabs > 1 );
+
+    // No block was written over by a later one
+    for (const std::pair<char*, std::size_t>& block : blocks) {
+        for (std::size_t i = 0; i < block.second; ++i) {
+            QCOMPARE( block.first[i], static_cast<char>(block.second) );
+        }
+        pool.deallocate(block.first, block.second);
+    }
+    QCOMPARE( pool.statistics().live(), std::size_t(0) );
+}
+
+void SimulationTest::testPoolLargeBlocks()
+{
+    using CourseSide::Pool;
+    Pool pool;
+    const std::size_t size = Pool::MAX_BLOCK + 1;
+    char* block = static_cast<char*>(pool.allocate(size));
+    QCOMPARE( reinterpret_cast<std::uintptr_t>(block) % Pool::ALIGNMENT, std::uintptr_t(0) );
+    std::fill(block, block + size, 'x');
+    pool.deallocate(block, size);
+
+    // Served and freed by the general heap, the slabs are not touched
+    const CourseSide::PoolStatistics& statistics = pool.statistics();
+    QCOMPARE( statistics.fallbacks, std::size_t(1) );
+    QCOMPARE( statistics.slabs, std::size_t(0) );
+    QCOMPARE( statistics.live(), std::size_t(0) );
+
+    // A freed large block is not reused for a small one
+    pool.allocate(Pool::ALIGNMENT);
+    QCOMPARE( pool.statistics().reuses, std::size_t(0) );
+}
+
+void SimulationTest::testPoolOutlivesOwner()
+{
+    std::shared_ptr<CourseSide::Pool> pool = std::make_shared<CourseSide::Pool>();
+    std::weak_ptr<CourseSide::Pool> watch = pool;
+    std::shared_ptr<std::vector<int>> object = std::allocate_shared<std::vector<int>>(
+                CourseSide::PoolAllocator<std::vector<int>>(pool), 3, 7);
+    QCOMPARE( pool->statistics().live(), std::size_t(1) );
+
+    // The control block of the object keeps the pool alive
+    pool.reset();
+    QVERIFY( !watch.expired() );
+    QCOMPARE( object->at(2), 7 );
+    object.reset();
+    QVERIFY( watch.expired() );
+}
+
+QTEST_GUILESS_MAIN(SimulationTest)
+
+#include "tst_simulation.moc"
@@ -0,0 +1,35 @@
+QT += testlib
+QT -= gui
+
+TARGET = tst_statistics
+
+CONFIG += qt console warn_on depend_includepath testcase
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+HEADERS += \
+        ../../Game/metrics.hh \
+        ../../Game/statistics.hh \
+        ../../Game/timeseries.hh
+
+HEADERS += \
+        ../../Course/CourseLib/interfaces/istatistics.hh \
+        ../../Course/CourseLib/core/statisticspolicy.hh \
+        ../../Course/CourseLib/core/trace.hh
+
+SOURCES +=  tst_statistics.cpp \
+        ../../Game/metrics.cpp \
+        ../../Game/statistics.cpp \
+        ../../Game/timeseries.cpp \
+        ../../Course/CourseLib/core/statisticspolicy.cc \
+        ../../Course/CourseLib/core/trace.cc
+
+INCLUDEPATH += \
+        ../../Game/
+
+INCLUDEPATH += \
+    $$PWD/../../Course/CourseLib
+
+DEPENDPATH += \
+    $$PWD/../../Course/CourseLib
@@ -0,0 +1,356 @@
+#include "statistics.hh"
+#include "core/statisticspolicy.hh"
+#include <QtTest>
+#include <thread>
+#include <vector>
+
+
+class StatisticsTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    StatisticsTest();
+    ~StatisticsTest();
+
+private Q_SLOTS:
+    void testNysseRemoved();
+    void testPassengerCaptured();
+    void testSeriesOverwritesOldest();
+    void testMinuteSeries();
+    void testKeyedSeriesAreAligned();
+    void testCsvExport();
+    void testBinaryExport();
+    void testMetricsMergeThreads();
+    void testBatchedStatisticsFlush();
+    void testStateRoundTrip();
+    void testStateRejectsCorrupt();
+
+};
+
+namespace
+{
+
+// Counts the calls the batched statistics make per tick
+class CountingStatistics : public Game::Statistics
+{
+public:
+    int calls = 0;
+
+    void nyssesAdded( int num )
+    {
+        ++calls;
+        Statistics::nyssesAdded( num );
+    }
+
+    void passengersBoarded( unsigned int line, int num )
+    {
+        ++calls;
+        Statistics::passengersBoarded( line, num );
+    }
+
+    void passengersAlighted( unsigned int line, int num )
+    {
+        ++calls;
+        Statistics::passengersAlighted( line, num );
+    }
+};
+
+}
+
+StatisticsTest::StatisticsTest()
+{
+
+}
+
+StatisticsTest::~StatisticsTest()
+{
+
+}
+
+void StatisticsTest::testNysseRemoved()
+{
+    Game::Statistics stats;
+    int oldScore = stats.getScore();
+    int oldBusesDestroyed = stats.getDestroyedBuses();
+
+    stats.nysseRemoved();
+
+    QVERIFY( oldScore != stats.getScore() );
+    QVERIFY( stats.getDestroyedBuses() == oldScore + 1 );
+}
+
+void StatisticsTest::testPassengerCaptured()
+{
+    Game::Statistics stats;
+    int oldScore = stats.getScore();
+    int oldPassengersCaptured = stats.getPassengersCaptured();
+
+    stats.PassengerCaptured();
+
+    QVERIFY2( oldScore != stats.getScore(), "Score has not changed");
+    QVERIFY2( oldPassengersCaptured == ( stats.getPassengersCaptured() - 1 ),
+              "Captured passenger amount has not changed" );
+
+}
+
+void StatisticsTest::testSeriesOverwritesOldest()
+{
+    Game::TimeSeries series( 3 );
+    for( int value = 1; value <= 5; ++value )
+    {
+        series.push( value );
+    }
+
+    QCOMPARE( series.size(), std::size_t( 3 ) );
+    QCOMPARE( series.at( 0 ), 3.0 );
+    QCOMPARE( series.latest(), 5.0 );
+    QCOMPARE( series.sum(), 12.0 );
+    QCOMPARE( series.min(), 3.0 );
+    QCOMPARE( series.max(), 5.0 );
+}
+
+void StatisticsTest::testMinuteSeries()
+{
+    Game::Statistics stats( 10 );
+    stats.newNysse();
+    stats.newNysse();
+    stats.passengerBoarded( 3 );
+    stats.passengerBoarded( 3 );
+    stats.passengerAlighted( 3 );
+    stats.minutePassed();
+
+    stats.nysseLeft();
+    stats.minutePassed();
+
+    using Series = Game::Statistics::Series;
+    QCOMPARE( stats.minutesRecorded(), 2 );
+    QCOMPARE( stats.series( Series::ACTIVE_BUSES ).at( 0 ), 2.0 );
+    QCOMPARE( stats.series( Series::ACTIVE_BUSES ).at( 1 ), 1.0 );
+    QCOMPARE( stats.series( Series::BOARDINGS ).at( 0 ), 2.0 );
+    QCOMPARE( stats.series( Series::BOARDINGS ).at( 1 ), 0.0 );
+    QCOMPARE( stats.series( Series::ALIGHTINGS ).sum(), 1.0 );
+}
+
+void StatisticsTest::testKeyedSeriesAreAligned()
+{
+    Game::Statistics stats( 10 );
+    stats.minutePassed();
+
+    stats.busLoad( 25, 10 );
+    stats.busLoad( 25, 20 );
+    stats.minutePassed();
+
+    QVERIFY( stats.lineLoad( 3 ) == nullptr );
+    const Game::TimeSeries* load = stats.lineLoad( 25 );
+    QVERIFY( load != nullptr );
+    QCOMPARE( load->size(), std::size_t( 2 ) );
+    QCOMPARE( load->at( 0 ), 0.0 );
+    QCOMPARE( load->latest(), 15.0 );
+}
+
+void StatisticsTest::testCsvExport()
+{
+    Game::Statistics stats( 10 );
+    stats.passengersWaiting( 1234, 4 );
+    stats.minutePassed();
+
+    QString csv;
+    QTextStream out( &csv );
+    stats.writeCsv( out );
+    out.flush();
+
+    QStringList rows = csv.split( '\n', Qt::SkipEmptyParts );
+    // Header, five series of the game and the stop, one minute each
+    QCOMPARE( rows.size(), 7 );
+    QCOMPARE( rows.first(), QString( "minute,series,key,value" ) );
+    QVERIFY( rows.contains( "0,waiting,1234,4" ) );
+}
+
+void StatisticsTest::testBinaryExport()
+{
+    Game::Statistics stats( 10 );
+    stats.passengersWaiting( 1234, 4 );
+    stats.minutePassed();
+    stats.passengersWaiting( 1234, 6 );
+    stats.minutePassed();
+
+    QByteArray bytes;
+    QDataStream out( &bytes, QIODevice::WriteOnly );
+    QVERIFY( stats.writeBinary( out ) );
+
+    QDataStream in( bytes );
+    quint32 magic = 0;
+    quint16 version = 0;
+    quint32 minutes = 0;
+    qint32 recorded = 0;
+    quint32 count = 0;
+    in >> magic >> version >> minutes >> recorded >> count;
+    QCOMPARE( magic, quint32( 0x4E595354 ) );
+    QCOMPARE( minutes, quint32( 10 ) );
+    QCOMPARE( recorded, qint32( 2 ) );
+    // Five series of the game and the stop
+    QCOMPARE( count, quint32( 6 ) );
+
+    bool foundStop = false;
+    for( quint32 i = 0; i < count; ++i )
+    {
+        QString name;
+        quint32 key = 0;
+        qint32 firstMinute = -1;
+        quint32 size = 0;
+        in >> name >> key >> firstMinute >> size;
+        QCOMPARE( firstMinute, qint32( 0 ) );
+        QCOMPARE( size, quint32( 2 ) );
+        std::vector< double > values( size );
+        for( double& value : values )
+        {
+            in >> value;
+        }
+        if( name == "waiting" )
+        {
+            QCOMPARE( key, quint32( 1234 ) );
+            QCOMPARE( values[0], 4.0 );
+            QCOMPARE( values[1], 6.0 );
+            foundStop = true;
+        }
+    }
+    QVERIFY( foundStop );
+    QCOMPARE( in.status(), QDataStream::Ok );
+    QVERIFY( in.atEnd() );
+}
+
+void StatisticsTest::testMetricsMergeThreads()
+{
+    Game::Metrics metrics;
+    const int THREADS = int( Game::Metrics::SLOT_COUNT ) + 4;
+    const int EVENTS = 1000;
+
+    // More threads than slots, the last ones share a slot
+    std::vector< std::thread > threads;
+    for( int t = 0; t < THREADS; ++t )
+    {
+        threads.emplace_back( [&metrics]() {
+            for( int i = 0; i < EVENTS; ++i )
+            {
+                metrics.add( Game::Metrics::Counter::SCORE, 2 );
+                metrics.record( Game::Metrics::Histogram::FRAME_USECS, 3 );
+            }
+        } );
+    }
+    for( std::thread& thread : threads )
+    {
+        thread.join();
+    }
+
+    QCOMPARE( metrics.total( Game::Metrics::Counter::SCORE ),
+              qint64( 2 * THREADS * EVENTS ) );
+    QCOMPARE( metrics.total( Game::Metrics::Counter::BUSES_DESTROYED ), qint64( 0 ) );
+
+    std::vector< quint64 > buckets =
+            metrics.buckets( Game::Metrics::Histogram::FRAME_USECS );
+    QCOMPARE( buckets[ Game::Metrics::bucketOf( 3 ) ], quint64( THREADS * EVENTS ) );
+    QCOMPARE( metrics.percentile( Game::Metrics::Histogram::FRAME_USECS, 0.5 ),
+              quint64( 3 ) );
+}
+
+void StatisticsTest::testBatchedStatisticsFlush()
+{
+    CountingStatistics stats;
+    CourseSide::BatchedStatistics batched;
+    batched.setSink( &stats );
+
+    batched.busAdded();
+    batched.busAdded();
+    for( int i = 0; i < 5; ++i )
+    {
+        batched.boarded( 3 );
+    }
+    batched.boarded( 7 );
+    batched.alighted( 3 );
+    QCOMPARE( stats.calls, 0 );
+
+    batched.flush();
+    // One call for the added buses, two lines of boardings, one of alightings
+    QCOMPARE( stats.calls, 4 );
+
+    batched.flush();
+    QCOMPARE( stats.calls, 4 );
+
+    batched.minutePassed();
+    using Series = Game::Statistics::Series;
+    QCOMPARE( stats.series( Series::ACTIVE_BUSES ).latest(), 2.0 );
+    QCOMPARE( stats.series( Series::BOARDINGS ).latest(), 6.0 );
+    QCOMPARE( stats.series( Series::ALIGHTINGS ).latest(), 1.0 );
+}
+
+void StatisticsTest::testStateRoundTrip()
+{
+    Game::Statistics stats( 10 );
+    stats.nysseRemoved();
+    stats.PassengerCaptured();
+    stats.newNysse();
+    stats.passengerBoarded( 3 );
+    stats.busLoad( 3, 12 );
+    stats.minutePassed();
+    stats.passengersWaiting( 1234, 4 );
+    stats.morePassengers( 5 );
+
+    QByteArray state;
+    QDataStream out( &state, QIODevice::WriteOnly );
+    stats.saveState( out );
+
+    // Events given while Logic restores are replaced
+    Game::Statistics restored( 10 );
+    restored.newNysse();
+    QDataStream in( state );
+    QVERIFY( restored.restoreState( in ) );
+    QCOMPARE( restored.getScore(), stats.getScore() );
+    QCOMPARE( restored.getDestroyedBuses(), 1 );
+    QCOMPARE( restored.getPassengersCaptured(), 1 );
+    QCOMPARE( restored.minutesRecorded(), 1 );
+
+    // Counters of the unfinished minute continue
+    restored.minutePassed();
+    using Series = Game::Statistics::Series;
+    QCOMPARE( restored.series( Series::BOARDINGS ).at( 0 ), 1.0 );
+    QCOMPARE( restored.series( Series::ACTIVE_BUSES ).latest(), 1.0 );
+    QCOMPARE( restored.series( Series::NEW_PASSENGERS ).latest(), 5.0 );
+    QVERIFY( restored.lineLoad( 3 ) != nullptr );
+    QCOMPARE( restored.lineLoad( 3 )->at( 0 ), 12.0 );
+    QVERIFY( restored.waitingAtStop( 1234 ) != nullptr );
+    QCOMPARE( restored.waitingAtStop( 1234 )->latest(), 4.0 );
+}
+
+void StatisticsTest::testStateRejectsCorrupt()
+{
+    Game::Statistics stats( 10 );
+    stats.nysseRemoved();
+    stats.busLoad( 3, 12 );
+    stats.minutePassed();
+
+    QByteArray state;
+    QDataStream out( &state, QIODevice::WriteOnly );
+    stats.saveState( out );
+
+    // Cut short anywhere
+    Game::Statistics restored( 10 );
+    for( int size = 0; size < state.size(); ++size )
+    {
+        QDataStream in( state.left( size ) );
+        QVERIFY( !restored.restoreState( in ) );
+    }
+    QCOMPARE( restored.getScore(), 0 );
+    QCOMPARE( restored.minutesRecorded(), 0 );
+    QVERIFY( restored.lineLoad( 3 ) == nullptr );
+
+    // Series of another length
+    Game::Statistics shorter( 5 );
+    QDataStream in( state );
+    QVERIFY( !shorter.restoreState( in ) );
+    QCOMPARE( shorter.getScore(), 0 );
+}
+
+QTEST_APPLESS_MAIN(StatisticsTest)
+
+#include "tst_statistics.moc"